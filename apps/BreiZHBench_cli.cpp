@@ -0,0 +1,396 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+#include <sstream>
+#include <getopt.h>
+
+#include "../lib/BreiZHMinimizer.hpp"
+#include "../src/bench/synthetic_collection.hpp"
+#include "../src/bench/parse_collection.hpp"
+#include "../src/bench/peak_rss.hpp"
+
+//
+//  Banc de mesure du pipeline sur des collections synthétiques : chaque étape est mesurée
+//  (débit, pic de mémoire) pour chaque nombre de threads, en passage à l'échelle fort (même
+//  collection) et faible (nombre d'échantillons proportionnel au nombre de threads).
+//
+
+static std::vector<std::string> split_list(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss( list );
+    std::string item;
+    while( std::getline(ss, item, ',') )
+        if( item.empty() == false )
+            items.push_back( item );
+    return items;
+}
+
+static uint64_t total_bytes(const std::vector<std::string>& files)
+{
+    uint64_t bytes = 0;
+    for(const std::string& f : files)
+        bytes += std::filesystem::file_size( f );
+    return bytes;
+}
+
+static double mb(const uint64_t bytes)
+{
+    return (double)bytes / (1024.0 * 1024.0);
+}
+
+//
+// Une ligne du rapport, affichée et ajoutée au fichier CSV
+//
+struct bench_row
+{
+    std::string bench;
+    std::string stage;
+    std::string algo;
+    int         threads;
+    uint64_t    samples;
+    double      seconds;
+    uint64_t    bytes;       // bytes consumed by the stage (compressed input for the parsers)
+    uint64_t    items;       // bases or minimizers (0 for the merges)
+    uint64_t    peak_rss_kb;
+    double      speedup;
+    double      efficiency;
+};
+
+static void report(FILE* csv, const bench_row& r)
+{
+    const double mbs = (r.seconds > 0.0) ? mb(r.bytes) / r.seconds : 0.0;
+    const double ips = (r.seconds > 0.0) ? (double)r.items / r.seconds / 1e6 : 0.0;
+    printf("%-8s | %-10s | %-15s | %3d thr. | %6lu samples | %8.3f sec. | %9.1f MB/s | %9.1f M/s | %7lu MB RSS",
+           r.bench.c_str(), r.stage.c_str(), r.algo.c_str(), r.threads, r.samples, r.seconds, mbs, ips, r.peak_rss_kb / 1024);
+    if( r.speedup > 0.0 )
+        printf(" | x%5.2f (%3.0f%%)", r.speedup, 100.0 * r.efficiency);
+    printf("\n");
+    fflush( stdout );
+
+    if( csv != nullptr )
+    {
+        fprintf(csv, "%s,%s,%s,%d,%lu,%.6f,%lu,%.3f,%lu,%.3f,%lu,%.4f,%.4f\n",
+                r.bench.c_str(), r.stage.c_str(), r.algo.c_str(), r.threads, r.samples, r.seconds,
+                r.bytes, mbs, r.items, ips, r.peak_rss_kb, r.speedup, r.efficiency);
+        fflush( csv );
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+struct pipeline_run
+{
+    double                              seconds;
+    uint64_t                            peak_rss_kb;
+    std::vector<CMetrics::stage_record> stages;
+};
+
+static std::string accumulator = "list";
+
+static pipeline_run run_pipeline(const std::vector<std::string>& files, const std::string& work, const int threads,
+                                 const uint64_t ram_value, const int k, const int m, const std::string& algo)
+{
+    const std::string tmp_dir = work + "/tmp";
+    std::filesystem::remove_all( tmp_dir );
+    std::filesystem::create_directories( tmp_dir );
+
+    CMetrics::reset();
+    reset_peak_rss();
+    CTimer timer( true );
+    generate_minimizers(files, work + "/result", tmp_dir, threads, ram_value, k, m, 8, algo, 0,
+                        false, false, false, "auto", "", "sort", "fixed", false, false, "", false, accumulator);
+
+    pipeline_run r;
+    r.seconds     = timer.get_time_sec();
+    r.peak_rss_kb = peak_rss_kb();
+    r.stages      = CMetrics::stages();
+    return r;
+}
+
+static pipeline_run best_pipeline(const std::vector<std::string>& files, const std::string& work, const int threads,
+                                  const uint64_t ram_value, const int k, const int m, const std::string& algo, const int repeat)
+{
+    pipeline_run best = run_pipeline(files, work, threads, ram_value, k, m, algo);
+    for(int r = 1; r < repeat; r += 1)
+    {
+        pipeline_run run = run_pipeline(files, work, threads, ram_value, k, m, algo);
+        if( run.seconds < best.seconds )
+            best = run;
+    }
+    return best;
+}
+
+static void report_pipeline(FILE* csv, const std::string& bench, const pipeline_run& run, const std::string& algo,
+                            const int threads, const uint64_t samples, const double speedup, const double efficiency)
+{
+    for(const CMetrics::stage_record& s : run.stages)
+    {
+        const bool step1 = (s.name == "step1");
+        report(csv, { bench, s.name, algo, threads, samples, s.duration_us / 1e6,
+                      step1 ? s.counters[MET_READ_DISK_BYTES] : s.counters[MET_READ_BYTES],
+                      step1 ? s.counters[MET_BASES]           : 0,
+                      run.peak_rss_kb, 0.0, 0.0 });
+    }
+    report(csv, { bench, "total", algo, threads, samples, run.seconds, 0, 0, run.peak_rss_kb, speedup, efficiency });
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+int main(int argc, char *argv[])
+{
+    synthetic_params params;
+    std::string work_dir    = "./bench";
+    std::string thread_list = "1,2,4,8";
+    std::string algo_list   = "crumsort,std::sort,std_2cores,std_4cores,crumsort_2cores,radix_lsd,std_parallel,radix_par";
+    std::string bench_list  = "parse,extract,strong,weak";
+    std::string report_file = "";
+
+    int      help_flag      = 0;
+    int      repeat         = 1;
+    int      kmer_size      = 31;
+    int      minimizer_size = 19;
+    uint64_t ram_value      = 1024; // MB
+
+    static struct option long_options[] = {
+            {"help",           no_argument,       0, 'h'},
+            {"directory",      required_argument, 0, 'd'},
+            {"genome-size",    required_argument, 0, 'g'},
+            {"samples",        required_argument, 0, 'n'},
+            {"core-fraction",  required_argument, 0, 'c'},
+            {"snp-rate",       required_argument, 0, 's'},
+            {"reads",          no_argument,       0, 'r'},
+            {"coverage",       required_argument, 0, 'C'},
+            {"read-length",    required_argument, 0, 'l'},
+            {"error-rate",     required_argument, 0, 'e'},
+            {"format",         required_argument, 0, 'f'},
+            {"seed",           required_argument, 0, 'S'},
+            {"threads",        required_argument, 0, 't'},
+            {"algo",           required_argument, 0, 'a'},
+            {"bench",          required_argument, 0, 'b'},
+            {"repeat",         required_argument, 0, 'R'},
+            {"ram",            required_argument, 0, 'M'},
+            {"kmer-size",      required_argument, 0, 'k'},
+            {"minimizer-size", required_argument, 0, 'm'},
+            {"output",         required_argument, 0, 'o'},
+            {"accumulator",    required_argument, 0, 'u'},
+            {0, 0, 0, 0}
+    };
+
+    int option_index = 0;
+    int c;
+    while( true )
+    {
+        c = getopt_long(argc, argv, "d:g:n:c:s:rC:l:e:f:S:t:a:b:R:M:k:m:o:u:h", long_options, &option_index);
+
+        if (c == -1)
+            break;
+
+        switch ( c )
+        {
+            case 'd': work_dir             = optarg;                     break;
+            case 'g': params.genome_size   = std::atoll( optarg );       break;
+            case 'n': params.samples       = std::atoll( optarg );       break;
+            case 'c': params.core_fraction = std::atof ( optarg );       break;
+            case 's': params.snp_rate      = std::atof ( optarg );       break;
+            case 'r': params.reads         = true;                       break;
+            case 'C': params.coverage      = std::atof ( optarg );       break;
+            case 'l': params.read_length   = std::atoll( optarg );       break;
+            case 'e': params.error_rate    = std::atof ( optarg );       break;
+            case 'f': params.format        = optarg;                     break;
+            case 'S': params.seed          = std::strtoull(optarg, nullptr, 10); break;
+            case 't': thread_list          = optarg;                     break;
+            case 'a': algo_list            = optarg;                     break;
+            case 'b': bench_list           = optarg;                     break;
+            case 'R': repeat               = std::max(1, std::atoi( optarg )); break;
+            case 'M': ram_value            = std::atoll( optarg );       break;
+            case 'k': kmer_size            = std::atoi( optarg );        break;
+            case 'm': minimizer_size       = std::atoi( optarg );        break;
+            case 'o': report_file          = optarg;                     break;
+            case 'u': accumulator          = optarg;                     break;
+            case 'h': help_flag            = true;                       break;
+            default:
+                abort ();
+        }
+    }
+
+    std::vector<int> threads;
+    for(const std::string& t : split_list(thread_list))
+        threads.push_back( std::max(1, std::atoi(t.c_str())) );
+    const std::vector<std::string> algos   = split_list( algo_list  );
+    const std::vector<std::string> benches = split_list( bench_list );
+    auto wanted = [&](const std::string& b) { return std::find(benches.begin(), benches.end(), b) != benches.end(); };
+
+    if ( (help_flag == true) || threads.empty() || algos.empty() )
+    {
+        printf ("Usage :\n");
+        printf ("./BreiZHBench [options]\n");
+        printf ("\n");
+        printf ("Generates a synthetic collection and measures each stage of the pipeline over the thread counts.\n");
+        printf ("\n");
+        printf ("Collection :\n");
+        printf ("  --directory <string>     (-d) : working directory (default: ./bench)\n");
+        printf ("  --genome-size <int>      (-g) : bases per sample (default: %lu)\n", params.genome_size);
+        printf ("  --samples <int>          (-n) : samples, for the first thread count in weak scaling (default: %lu)\n", params.samples);
+        printf ("  --core-fraction <float>  (-c) : part of the genome shared by all the samples (default: %.2f)\n", params.core_fraction);
+        printf ("  --snp-rate <float>       (-s) : per sample substitution rate (default: %.4f)\n", params.snp_rate);
+        printf ("  --reads                  (-r) : sequencing reads instead of assemblies\n");
+        printf ("  --coverage <float>       (-C) : read coverage (default: %.1f)\n", params.coverage);
+        printf ("  --read-length <int>      (-l) : read length (default: %lu)\n", params.read_length);
+        printf ("  --error-rate <float>     (-e) : read substitution errors (default: %.4f)\n", params.error_rate);
+        printf ("  --format <string>        (-f) : fasta|fastq[.gz|.bz2|.lz4] (default: %s)\n", params.format.c_str());
+        printf ("  --seed <int>             (-S) : (default: %lu)\n", params.seed);
+        printf ("\n");
+        printf ("Measures :\n");
+        printf ("  --bench <list>           (-b) : parse,extract,strong,weak (default: %s)\n", bench_list.c_str());
+        printf ("  --threads <list>         (-t) : thread counts (default: %s)\n", thread_list.c_str());
+        printf ("  --algo <list>            (-a) : sorting algorithms of the extraction (default: %s)\n", algo_list.c_str());
+        printf ("  --repeat <int>           (-R) : runs per measure, the best one is kept (default: 1)\n");
+        printf ("  --ram <int>              (-M) : memory budget in MB (default: %lu)\n", ram_value);
+        printf ("  --accumulator <string>   (-u) : Step 1 accumulator, list or hash (default: list)\n");
+        printf ("  --kmer-size <int>        (-k) : (default: 31)\n");
+        printf ("  --minimizer-size <int>   (-m) : (default: 19)\n");
+        printf ("  --output <string>        (-o) : CSV report\n");
+        printf ("  --help                   (-h) : display this help message\n");
+        putchar ('\n');
+        exit( EXIT_FAILURE );
+    }
+
+    FILE* csv = nullptr;
+    if( report_file.empty() == false )
+    {
+        csv = fopen(report_file.c_str(), "w");
+        if( csv == nullptr )
+        {
+            error_section();
+            printf("(EE) Cannot create the report file (%s)\n", report_file.c_str());
+            printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+            reset_section();
+            exit( EXIT_FAILURE );
+        }
+        fprintf(csv, "bench,stage,algo,threads,samples,seconds,bytes,mb_per_s,items,m_items_per_s,peak_rss_kb,speedup,efficiency\n");
+    }
+
+    const int max_threads = *std::max_element(threads.begin(), threads.end());
+    CMetrics::enable( true );
+
+    try {
+        CTimer gen_timer( true );
+        const std::vector<std::string> files = generate_synthetic_collection(params, work_dir + "/samples_" + std::to_string(params.samples), max_threads);
+        printf("[I] %lu samples (%s, %.1f MB) generated in %1.2f seconds\n", files.size(), params.format.c_str(), mb(total_bytes(files)), gen_timer.get_time_sec());
+
+        //
+        // Décodage seul des fichiers de séquences
+        //
+        if( wanted("parse") )
+        {
+            for(const int t : threads)
+            {
+                double   best    = 1e30;
+                uint64_t n_bases = 0;
+                reset_peak_rss();
+                for(int r = 0; r < repeat; r += 1)
+                {
+                    CTimer timer( true );
+                    n_bases = parse_collection(files, t);
+                    best    = std::min(best, timer.get_time_sec());
+                }
+                report(csv, { "parse", "parse", "-", t, params.samples, best, total_bytes(files), n_bases, peak_rss_kb(), 0.0, 0.0 });
+            }
+        }
+
+        //
+        // Extraction des minimiseurs (Step 1 sans écriture), pour chaque algorithme de tri
+        //
+        if( wanted("extract") )
+        {
+            for(const std::string& algo : algos)
+            {
+                for(const int t : threads)
+                {
+                    double best = 1e30;
+                    uint64_t n_bases = 0, n_minimizers = 0;
+                    reset_peak_rss();
+                    for(int r = 0; r < repeat; r += 1)
+                    {
+                        CMetrics::reset();
+                        CTimer timer( true );
+#pragma omp parallel for schedule(dynamic) num_threads(t)
+                        for(size_t i = 0; i < files.size(); i += 1)
+                            minimizer_processing_v4(files[i], work_dir + "/extract_" + std::to_string(i) + ".raw", algo, ram_value / t, false, false, kmer_size, minimizer_size, accumulator);
+                        best = std::min(best, timer.get_time_sec());
+                        const std::vector<uint64_t> sum = CMetrics::totals();
+                        n_bases      = sum[MET_BASES];
+                        n_minimizers = sum[MET_MINIMIZERS];
+                    }
+                    report(csv, { "extract", "bases", algo, t, params.samples, best, total_bytes(files), n_bases, peak_rss_kb(), 0.0, 0.0 });
+                    report(csv, { "extract", "minimizers", algo, t, params.samples, best, total_bytes(files), n_minimizers, peak_rss_kb(), 0.0, 0.0 });
+                }
+            }
+
+            //
+            // Fichiers laissés par les extractions qui ont dépassé le budget mémoire
+            //
+            for(size_t i = 0; i < files.size(); i += 1)
+                std::filesystem::remove( work_dir + "/extract_" + std::to_string(i) + ".raw" );
+        }
+
+        //
+        // Passage à l'échelle fort : même collection, toutes les étapes du pipeline
+        //
+        if( wanted("strong") )
+        {
+            double reference = 0.0;
+            for(const int t : threads)
+            {
+                const pipeline_run run = best_pipeline(files, work_dir + "/strong", t, ram_value, kmer_size, minimizer_size, algos[0], repeat);
+                if( reference == 0.0 )
+                    reference = run.seconds * threads[0];
+                const double speedup = reference / threads[0] / run.seconds;
+                report_pipeline(csv, "strong", run, algos[0], t, params.samples, speedup, speedup * threads[0] / t);
+            }
+            std::filesystem::remove_all( work_dir + "/strong" );
+        }
+
+        //
+        // Passage à l'échelle faible : le nombre d'échantillons suit le nombre de threads
+        //
+        if( wanted("weak") )
+        {
+            double reference = 0.0;
+            for(const int t : threads)
+            {
+                synthetic_params weak = params;
+                weak.samples = std::max<uint64_t>(1, params.samples * t / threads[0]);
+                const std::vector<std::string> w_files = (weak.samples == params.samples) ? files :
+                        generate_synthetic_collection(weak, work_dir + "/samples_" + std::to_string(weak.samples), max_threads);
+
+                const pipeline_run run = best_pipeline(w_files, work_dir + "/weak", t, ram_value, kmer_size, minimizer_size, algos[0], repeat);
+                if( reference == 0.0 )
+                    reference = run.seconds;
+                report_pipeline(csv, "weak", run, algos[0], t, weak.samples, (double)weak.samples / params.samples * reference / run.seconds, reference / run.seconds);
+            }
+            std::filesystem::remove_all( work_dir + "/weak" );
+        }
+    } catch (const std::exception& e) {
+        error_section();
+        printf("(EE) %s\n", e.what());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+
+    if( csv != nullptr )
+        fclose( csv );
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "../lib/BreiZHMinimizer.hpp"
+#include "../src/files/uring/uring_file.hpp"
 
 //
 //  Récupère la liste des fichiers contenus dans un répertoire
@@ -54,6 +55,17 @@ int main(int argc, char *argv[])
     uint64_t   file_limit          = 65536;
 
     std::string algo = "crumsort";
+    std::string split_policy = "auto";
+    std::string color_classes = "";
+    std::string color_grouping = "sort";
+    std::string sparse_codec = "fixed";
+    bool build_index = false;
+    bool build_mphf  = false;
+    std::string append_index = "";
+    bool resume = false;
+    std::string metrics_file = "";
+    std::string trace_file   = "";
+    std::string accumulator  = "list";
 
     static struct option long_options[] = {
             {"help",        no_argument, 0, 'h'},
@@ -77,6 +89,18 @@ int main(int argc, char *argv[])
             {"sorter-algo",      required_argument, 0, 'a'},
             {"GB",           required_argument, 0, 'G'},
             {"MB",           required_argument, 0, 'M'},
+            {"direct-io",    no_argument,       0, 'D'},
+            {"split-policy", required_argument, 0, 'P'},
+            {"color-classes", required_argument, 0, 'C'},
+            {"color-grouping", required_argument, 0, 'g'},
+            {"sparse-codec", required_argument, 0, 'S'},
+            {"index",        no_argument,       0, 'I'},
+            {"mphf",         no_argument,       0, 'H'},
+            {"append",       required_argument, 0, 'A'},
+            {"resume",       no_argument,       0, 'R'},
+            {"metrics",      required_argument, 0, 'J'},
+            {"trace",        required_argument, 0, 'T'},
+            {"accumulator",  required_argument, 0, 'e'},
             {0, 0, 0, 0}
     };
 
@@ -86,7 +110,7 @@ int main(int argc, char *argv[])
     int c;
     while( true )
     {
-        c = getopt_long(argc, argv, "d:f:snNo:k:m:w:t:x:a:M:G:vh", long_options, &option_index);
+        c = getopt_long(argc, argv, "d:f:snNo:u:k:m:w:t:x:a:M:G:DP:C:g:S:IHA:RJ:T:e:vh", long_options, &option_index);
 
         if (c == -1)
             break;
@@ -153,6 +177,94 @@ int main(int argc, char *argv[])
                 ram_value = 1024 * std::atoi( optarg );
                 break;
 
+            case 'D':
+                uring_settings::direct = true;
+                break;
+
+            case 'P':
+                split_policy = optarg;
+                if( (split_policy != "auto") && (split_policy != "legacy") )
+                {
+                    error_section();
+                    printf("(EE) Unknown split policy (%s), expected auto or legacy\n", optarg);
+                    printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+                    reset_section();
+                    exit( EXIT_FAILURE );
+                }
+                break;
+
+            case 'C':
+                color_classes = optarg;
+                if( (color_classes != "raw") && (color_classes != "lz4") && (color_classes != "gz") && (color_classes != "bz2") )
+                {
+                    error_section();
+                    printf("(EE) Unknown color class format (%s), expected raw, lz4, gz or bz2\n", optarg);
+                    printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+                    reset_section();
+                    exit( EXIT_FAILURE );
+                }
+                break;
+
+            case 'g':
+                color_grouping = optarg;
+                if( (color_grouping != "sort") && (color_grouping != "hash") )
+                {
+                    error_section();
+                    printf("(EE) Unknown color grouping (%s), expected sort or hash\n", optarg);
+                    printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+                    reset_section();
+                    exit( EXIT_FAILURE );
+                }
+                break;
+
+            case 'I':
+                build_index = true;
+                break;
+
+            case 'H':
+                build_mphf = true;
+                break;
+
+            case 'A':
+                append_index = optarg;
+                break;
+
+            case 'S':
+                sparse_codec = optarg;
+                if( (sparse_codec != "fixed") && (sparse_codec != "vbyte") )
+                {
+                    error_section();
+                    printf("(EE) Unknown sparse codec (%s), expected fixed or vbyte\n", optarg);
+                    printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+                    reset_section();
+                    exit( EXIT_FAILURE );
+                }
+                break;
+
+            case 'R':
+                resume = true;
+                break;
+
+            case 'J':
+                metrics_file = optarg;
+                break;
+
+            case 'T':
+                trace_file = optarg;
+                break;
+
+            case 'e':
+                accumulator = optarg;
+                if( (accumulator != "list") && (accumulator != "hash") )
+                {
+                    error_section();
+                    printf("(EE) Unknown minimizer accumulator (%s), expected list or hash\n", optarg);
+                    printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+                    reset_section();
+                    exit( EXIT_FAILURE );
+                }
+                break;
+
             case 'v':
                 verbose_flag = true;
                 break;
@@ -195,9 +307,39 @@ int main(int argc, char *argv[])
         printf("                        + std_4cores      :\n");
         printf("                        + crumsort        : default\n");
         printf("                        + crumsort_2cores :\n");
+        printf("                        + radix_lsd       : LSD radix sort (11-bit digits)\n");
+        printf("                        + std_parallel    : std::sort(std::execution::par_unseq)\n");
+        printf("                        + radix_par       : parallel in-place radix sort and deduplication,\n");
+        printf("                                            uses the threads left idle by the other files\n");
+        printf (" --accumulator    (-e) [string] : how Step 1 keeps the minimizers of a file until they are sorted\n");
+        printf("                        + list            : every occurrence, sorted and deduplicated when the memory is full (default)\n");
+        printf("                        + hash            : deduplicated on insertion in a hash set, sorted once (high coverage reads)\n");
         printf (" --merge-step     (-w) [int]    : w-way merge, number of files merged together (default: 8)\n");
         printf (" --MB             (-M) [int]    : maximum memory usage in MBytes (default: 1024)\n");
         printf (" --GB             (-G) [int]    : maximum memory usage in GBytes (default: 1)\n");
+        printf (" --direct-io      (-D)          : temporary files bypass the page cache (io_uring backend only)\n");
+        printf (" --split-policy   (-P) [string] : representation tiers of the final rows\n");
+        printf("                        + auto            : sparse / delta / dense / complement from the color histogram (default)\n");
+        printf("                        + legacy          : sparse / dense\n");
+        printf (" --color-classes  (-C) [string] : store the dense rows as a table of distinct color sets (raw, lz4, gz, bz2)\n");
+        printf("                                   plus a bit-packed minimizer -> class id stream (default: OFF)\n");
+        printf (" --color-grouping (-g) [string] : how the final rows with equal color sets are brought together\n");
+        printf("                        + sort            : external sort by color (default)\n");
+        printf("                        + hash            : hash partitioning, equal sets are adjacent but not ordered\n");
+        printf (" --sparse-codec   (-S) [string] : encoding of the color ids in the sparse tier\n");
+        printf("                        + fixed           : 8/16/32/64 bits per id from the number of colors (default)\n");
+        printf("                        + vbyte           : gaps between ids on 1 to 4 bytes (StreamVByte)\n");
+        printf (" --index          (-I)          : also write <output>.<N>c.index, minimizer -> colors random access index\n");
+        printf (" --mphf           (-H)          : also write <output>.<N>c.mphf, minimal perfect hash of the minimizers to their\n");
+        printf("                                   color class, with 8-bit fingerprints (not with --color-classes)\n");
+        printf (" --append         (-A) [string] : index of a previous result (--index), the files of the directory are added\n");
+        printf("                                   as new colors after the previous ones (implies --index)\n");
+        printf (" --resume         (-R)          : resume an interrupted run from the journal of its tmp-dir, the steps\n");
+        printf("                                   whose outputs are still valid are not computed again\n");
+        printf (" --metrics        (-J) [string] : write the per stage and per thread counters (bases, m-mers, minimizers,\n");
+        printf("                                   bytes read/written before and after compression, merge fan-in and\n");
+        printf("                                   stall time) and the spans of the merge nodes, CSV for *.csv, JSON otherwise\n");
+        printf (" --trace          (-T) [string] : write the stages and merge nodes in the Chrome trace format\n");
         printf ("\n");
 
         printf ("Others :\n");
@@ -284,6 +426,20 @@ int main(int argc, char *argv[])
         }
     }
 
+    if( (build_mphf == true) && (color_classes.empty() == false) )
+    {
+        error_section();
+        printf("(EE) --mphf reads the final rows, it cannot be used with --color-classes\n");
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+
+    //
+    // Les flux de fichiers ne sont instrumentés que lorsqu'un fichier de métriques est demandé
+    //
+    CMetrics::enable( (metrics_file.empty() == false) || (trace_file.empty() == false) );
+
     generate_minimizers(
         filelist,
         file_out,
@@ -297,9 +453,23 @@ int main(int argc, char *argv[])
         verbose_flag,
         skip_minimizer_step,
         keep_minimizer_files,
-        keep_merge_files
+        keep_merge_files,
+        split_policy,
+        color_classes,
+        color_grouping,
+        sparse_codec,
+        build_index,
+        build_mphf,
+        append_index,
+        resume,
+        accumulator
     );
 
+    if( metrics_file.empty() == false )
+        CMetrics::write( metrics_file );
+    if( trace_file.empty() == false )
+        CMetrics::write_trace( trace_file );
+
 
     return 0;
 }
\ No newline at end of file
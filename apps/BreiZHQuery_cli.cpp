@@ -0,0 +1,151 @@
+#include "../lib/BreiZHMinimizer.hpp"
+
+//
+//  Fichiers de séquences à interroger : un répertoire (filtré sur les extensions supportées)
+//  et/ou les fichiers donnés en fin de ligne de commande
+//
+static bool is_sequence_file(const std::string& t_file)
+{
+    const std::string ext = t_file.substr(t_file.find_last_of(".") + 1);
+    return (ext == "lz4") || (ext == "bz2") || (ext == "gz") || (ext == "fastx") ||
+           (ext == "fasta") || (ext == "fastq") || (ext == "fna");
+}
+
+
+int main(int argc, char *argv[])
+{
+    std::string index_file = "";
+    std::string directory  = "";
+    std::string file_out   = "-";
+
+    int    verbose_flag   = 0;
+    int    help_flag      = 0;
+    int    threads        = 4;
+    int    kmer_size      = 31;
+    int    minimizer_size = 19;
+    double min_ratio      = 0.0;
+
+    static struct option long_options[] = {
+            {"help",           no_argument,       0, 'h'},
+            {"verbose",        no_argument,       0, 'v'},
+            {"index",          required_argument, 0, 'i'},
+            {"directory",      required_argument, 0, 'd'},
+            {"output",         required_argument, 0, 'o'},
+            {"kmer-size",      required_argument, 0, 'k'},
+            {"minimizer-size", required_argument, 0, 'm'},
+            {"threads",        required_argument, 0, 't'},
+            {"min-ratio",      required_argument, 0, 'r'},
+            {0, 0, 0, 0}
+    };
+
+    int option_index = 0;
+    int c;
+    while( true )
+    {
+        c = getopt_long(argc, argv, "i:d:o:k:m:t:r:vh", long_options, &option_index);
+
+        if (c == -1)
+            break;
+
+        switch ( c )
+        {
+            case 'i':
+                index_file = optarg;
+                break;
+
+            case 'd':
+                directory = optarg;
+                break;
+
+            case 'o':
+                file_out = optarg;
+                break;
+
+            case 'k':
+                kmer_size = std::atoi( optarg );
+                break;
+
+            case 'm':
+                minimizer_size = std::atoi( optarg );
+                break;
+
+            case 't':
+                threads  = std::atoi( optarg );
+                break;
+
+            case 'r':
+                min_ratio = std::atof( optarg );
+                break;
+
+            case 'v':
+                verbose_flag = 2;
+                break;
+
+            case 'h':
+                help_flag = true;
+                break;
+
+            default:
+                abort ();
+        }
+    }
+
+    std::vector<std::string> filelist;
+    if( directory.size() != 0 )
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(directory))
+            if( is_sequence_file(entry.path().string()) )
+                filelist.push_back( entry.path().string() );
+        std::sort(filelist.begin(), filelist.end());
+    }
+    for(int i = optind; i < argc; i += 1)
+        filelist.push_back( argv[i] );
+
+    if ( (help_flag == true) || (index_file.size() == 0) || (filelist.size() == 0) )
+    {
+        printf ("Usage :\n");
+        printf ("./BreiZHQuery -i <index> [options] <query files ...>\n");
+        printf ("./BreiZHQuery -i <index> -d <directory of query files> [options]\n");
+        printf ("\n");
+        printf ("Each query file (FASTA/FASTQ, optionally gz/bz2/lz4 compressed) is a batch : its distinct\n");
+        printf ("minimizers are merge-joined against the index and counted per color.\n");
+        printf ("\n");
+        printf ("Options :\n");
+        printf ("  --index <string>       (-i) : index written by BreiZHMinimizer --index\n");
+        printf ("  --directory <string>   (-d) : query all the sequence files of a directory\n");
+        printf ("  --output <string>      (-o) : tab separated hits, - for stdout (default: -)\n");
+        printf ("  --kmer-size <int>      (-k) : has to match the index (default: 31)\n");
+        printf ("  --minimizer-size <int> (-m) : has to match the index (default: 19)\n");
+        printf ("  --threads <int>        (-t) : query files processed in parallel (default: 4)\n");
+        printf ("  --min-ratio <float>    (-r) : only report colors holding this fraction of the query minimizers (default: 0)\n");
+        printf ("  --verbose              (-v) :\n");
+        printf ("  --help                 (-h) : display this help message\n");
+        putchar ('\n');
+        exit( EXIT_FAILURE );
+    }
+
+    for(const std::string& t_file : filelist)
+    {
+        if( is_sequence_file(t_file) == false )
+        {
+            error_section();
+            printf("(EE) File extension is not supported (%s)\n", t_file.c_str());
+            printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+            reset_section();
+            exit( EXIT_FAILURE );
+        }
+    }
+
+    query_index(
+        filelist,
+        index_file,
+        file_out,
+        threads,
+        kmer_size,
+        minimizer_size,
+        min_ratio,
+        verbose_flag
+    );
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <benchmark/benchmark.h>
+
+#include "../src/sorting/crumsort/crumsort.hpp"
+#include "../src/sorting/std_2cores/std_2cores.hpp"
+#include "../src/sorting/std_4cores/std_4cores.hpp"
+#include "../src/sorting/crumsort_2cores/crumsort_2cores.hpp"
+#include "../src/sorting/radix_lsd/radix_lsd.hpp"
+#include "../src/sorting/std_parallel/std_parallel.hpp"
+#include "../src/sorting/radix_par/radix_par.hpp"
+
+//
+//  Micro-benchmarks des algorithmes de tri de la Step 1 sur des vecteurs de minimiseurs :
+//  valeurs de hachage 64 bits, avec une part de doublons et un ordre initial variables.
+//  Le débit (items_per_second) est le nombre de clés triées par seconde (radix_par retire
+//  aussi les doublons, comme le tri suivi de smer_deduplication dans la Step 1).
+//
+//  Arguments de chaque mesure : taille / threads / % de clés distinctes / ordre initial
+//  (0 : aléatoire, 1 : séquences triées de 64K clés, comme les blocs vidés sur disque,
+//   2 : presque trié, 1% de clés déplacées)
+//
+
+static std::vector<uint64_t> minimizer_vector(const uint64_t n, const uint64_t distinct_pct, const int order)
+{
+    std::mt19937_64 rng( 0x42 + n + distinct_pct + order );
+
+    const uint64_t n_distinct = std::max<uint64_t>(1, n * distinct_pct / 100);
+    std::vector<uint64_t> pool( n_distinct );
+    for(uint64_t& v : pool)
+        v = rng();
+
+    std::vector<uint64_t> keys( n );
+    for(uint64_t i = 0; i < n; i += 1)
+        keys[i] = (i < n_distinct) ? pool[i] : pool[rng() % n_distinct];
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    if( order == 1 )
+    {
+        for(uint64_t i = 0; i < n; i += 65536)
+            std::sort(keys.begin() + i, keys.begin() + std::min(n, i + 65536));
+    }
+    else if( order == 2 )
+    {
+        std::sort(keys.begin(), keys.end());
+        for(uint64_t i = 0; i < n / 100; i += 1)
+            std::swap(keys[rng() % n], keys[rng() % n]);
+    }
+    return keys;
+}
+
+typedef std::function<void(std::vector<uint64_t>&, const int)> sort_function;
+
+static void sort_benchmark(benchmark::State& state, const sort_function sort)
+{
+    const uint64_t n       = state.range(0);
+    const int      threads = (int)state.range(1);
+
+    const std::vector<uint64_t> input = minimizer_vector(n, state.range(2), (int)state.range(3));
+    std::vector<uint64_t> keys( n );
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        keys = input;
+        state.ResumeTiming();
+        sort(keys, threads);
+        benchmark::DoNotOptimize( keys.data() );
+        benchmark::ClobberMemory();
+    }
+
+    if( std::is_sorted(keys.begin(), keys.end()) == false )
+        state.SkipWithError("output is not sorted");
+
+    state.SetItemsProcessed( state.iterations() * n );
+    state.counters["threads"] = threads;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+int main(int argc, char** argv)
+{
+    struct candidate
+    {
+        const char*      name;
+        sort_function    sort;
+        std::vector<int> threads; // the fixed thread count of the sort, or the ones to measure
+    };
+
+    const std::vector<int> scaling = { 1, 2, 4, 8 };
+
+    const std::vector<candidate> candidates = {
+        { "std::sort",       [](std::vector<uint64_t>& v, int) { std::sort(v.begin(), v.end()); },  { 1 } },
+        { "std_2cores",      [](std::vector<uint64_t>& v, int) { std_2cores( v ); },               { 2 } },
+        { "std_4cores",      [](std::vector<uint64_t>& v, int) { std_4cores( v ); },               { 4 } },
+        { "crumsort",        [](std::vector<uint64_t>& v, int) { crumsort_prim(v.data(), v.size(), 9 /*uint64*/); }, { 1 } },
+        { "crumsort_2cores", [](std::vector<uint64_t>& v, int) { crumsort_2cores( v ); },          { 2 } },
+        { "radix_lsd",       [](std::vector<uint64_t>& v, int t) { radix_lsd(v, t); },             scaling },
+        { "std_parallel",    [](std::vector<uint64_t>& v, int t) { std_parallel(v, t); },          scaling },
+        { "radix_par",       [](std::vector<uint64_t>& v, int t) { radix_par(v, t); },             scaling }, // + deduplication
+    };
+
+    for(const candidate& c : candidates)
+    {
+        std::vector<int64_t> threads( c.threads.begin(), c.threads.end() );
+        benchmark::RegisterBenchmark(c.name, sort_benchmark, c.sort)
+            ->ArgNames({ "keys", "threads", "distinct%", "order" })
+            ->ArgsProduct({ benchmark::CreateRange(1 << 16, 1 << 24, 4), threads, { 100, 25, 5 }, { 0, 1, 2 } })
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if( benchmark::ReportUnrecognizedArguments(argc, argv) )
+        return EXIT_FAILURE;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
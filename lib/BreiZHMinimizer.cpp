@@ -33,6 +33,31 @@ std::string shorten(const std::string fname, const int length)
     return nstr;
 }
 
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+static void build_mphf_step(const std::vector<std::string>& files, const tier_policy& policy, const std::string& mphf_file, const int threads, const size_t verbose)
+{
+    CTimer timer_mphf( true );
+    CMetrics::span node( shorten(mphf_file, 32) );
+    try {
+        const uint64_t keys = build_minimizer_mphf(files, policy, mphf_file, threads);
+        if (verbose >= 2){
+            printf("[II] Minimal perfect hash (%lu keys) written to %s in %1.2f seconds\n", keys, mphf_file.c_str(), timer_mphf.get_time_sec());
+        }
+    } catch (const std::exception& e) {
+        error_section();
+        printf("(EE) %s\n", e.what());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+}
+
 void generate_minimizers(
     std::vector<std::string> filenames, 
     const std::string &output,
@@ -46,8 +71,49 @@ void generate_minimizers(
     size_t verbose,
     bool skip_minimizer_step, 
     bool keep_minimizer_files, 
-    bool keep_merge_files)
+    bool keep_merge_files,
+    const std::string &split_policy,
+    const std::string &color_classes,
+    const std::string &color_grouping_algo,
+    const std::string &sparse_codec,
+    const bool build_index_arg,
+    const bool build_mphf,
+    const std::string &append_index,
+    const bool resume,
+    const std::string &accumulator)
 {
+    //
+    // En mode ajout, le nouveau résultat garde un index pour pouvoir être complété à son tour
+    //
+    const bool build_index = build_index_arg || (append_index.empty() == false);
+
+    //
+    // Journal des étapes terminées : avec resume, celles dont les fichiers produits sont encore
+    // valides ne sont pas recalculées. La clef identifie les paramètres qui changent les fichiers
+    //
+    std::string names;
+    for(const std::string& f : filenames)
+        names += f + "\n";
+    uint64_t names_hash[2];
+    MurmurHash3_x64_128(names.data(), names.size(), 0x42, names_hash);
+
+    const std::string run_key = output + " k=" + std::to_string(k) + " m=" + std::to_string(m)
+                              + " w=" + std::to_string(merge_step) + " P=" + split_policy + " S=" + sparse_codec
+                              + " C=" + color_classes + " g=" + color_grouping_algo
+                              + " I=" + std::to_string(build_index) + " H=" + std::to_string(build_mphf)
+                              + " A=" + append_index + " files=" + std::to_string(filenames.size())
+                              + ":" + std::to_string(names_hash[0]);
+    CJournal journal;
+    journal.open(tmp_dir + "/breizh.journal", run_key, resume, verbose);
+
+    //
+    // Budget mémoire commun à tous les workers : ceux de l'étape 1 commencent avec un quart de
+    // leur part et grandissent tant qu'il reste de la mémoire, les fusions et le tri externe
+    // prennent le leur dans le même budget
+    //
+    const uint64_t ram_bytes = ram_value_MB * 1024 * 1024;
+    CMemoryBudget::set_limit(ram_bytes, ram_bytes / (4 * std::max(1, threads)));
+
 
 
     ////////////////////////////////////////////////////////////////////////////
@@ -66,6 +132,7 @@ void generate_minimizers(
         
 
         CTimer minimizers_timer( true );
+        CMetrics::stage( "step1" );
 
         //
         // On predimentionne le vecteur de sortie car on connait sa taille. Cela evite les
@@ -73,11 +140,25 @@ void generate_minimizers(
         //
         n_files.resize( filenames.size() );
 
+        //
+        // Les fichiers sont distribués dynamiquement, les plus coûteux en premier (taille pondérée
+        // par le format), les noms des fichiers produits suivent toujours l'ordre d'entrée
+        //
+        const std::vector<size_t> order = step1_schedule( filenames );
+
         int counter = 0;
         omp_set_num_threads(threads);
-#pragma omp parallel for default(shared)
-        for(size_t i = 0; i < filenames.size(); i += 1)
+
+        //
+        // Les threads libres sont prêtés au tri parallèle (radix_par) des gros fichiers, ce qui
+        // demande un second niveau de parallélisme, rendu à sa valeur après l'étape
+        //
+        const int max_levels = omp_get_max_active_levels();
+        omp_set_max_active_levels( std::max(max_levels, 2) );
+#pragma omp parallel for default(shared) schedule(dynamic, 1) reduction(+:in_mbytes, ou_mbytes)
+        for(size_t o = 0; o < order.size(); o += 1)
         {
+            const size_t i = order[o];
             CTimer minimizer_t( true );
 
             //
@@ -87,8 +168,22 @@ void generate_minimizers(
             const std::string t_file = tmp_dir + "/data_n" + to_number(i, (int)filenames.size()) + ".raw.lz4";
             in_mbytes += i_file.size_mb;
 
+            //
+            // Fichier déjà traité par un run interrompu (il a pu être consommé depuis)
+            //
+            if( journal.done("s1", {i_file.name}, {t_file}) == true )
+            {
+                n_files[i] = CMergeFile( t_file, 0, 0 );
+                continue;
+            }
+
             /////
-            minimizer_processing_v4(i_file.name, t_file, algo, (ram_value_MB/threads), true, false, k, m);
+            {
+                CMetrics::span node( shorten(i_file.name, 32) );
+                CMetrics::add(MET_READ_DISK_BYTES, i_file.size_bytes); // the sequence parsers are not metered
+                minimizer_processing_v4(i_file.name, t_file, algo, ram_value_MB, true, false, k, m, accumulator);
+            }
+            journal.commit("s1", {i_file.name}, {t_file});
             /////
 
             //
@@ -102,8 +197,10 @@ void generate_minimizers(
                 // Mesure du temps d'execution
                 //
                 std::string nname = shorten(i_file.name, 32);
-                counter += 1;
-                printf("[III] %5ld | %5d/%5ld | %32s | %6ld MB | ==========> | %20s | %6ld MB | %5.2f sec.\n", i, counter, filenames.size(), nname.c_str(), i_file.size_mb, o_file.name.c_str(), o_file.size_mb, minimizer_t.get_time_sec());
+                int rank;
+#pragma omp atomic capture
+                rank = ++counter;
+                printf("[III] %5ld | %5d/%5ld | %32s | %6ld MB | ==========> | %20s | %6ld MB | %5.2f sec.\n", i, rank, filenames.size(), nname.c_str(), i_file.size_mb, o_file.name.c_str(), o_file.size_mb, minimizer_t.get_time_sec());
 
             }
 
@@ -112,6 +209,7 @@ void generate_minimizers(
             n_files[i] = d_file;                          // on stocke le nom du fichier que l'on vient de produire
             /////
         }
+        omp_set_max_active_levels( max_levels );
 
         //
         // The S-MER computation stage is now finished, we can prepare the merging ones
@@ -152,6 +250,7 @@ void generate_minimizers(
     }
 
     CTimer merge_64_timer( true );
+    CMetrics::stage( "step2.1" );
 
     if (verbose >= 2){
         printf("[II] Step 2.1: Tree-based %d-ways merging of sorted minimizer files - %d thread(s)\n", 64, threads);
@@ -173,7 +272,14 @@ void generate_minimizers(
         std::string t_file = tmp_dir + "/data_n" + to_number(ll/64, l_files.size()/64) + ".";
         t_file            += std::to_string(max_files) + "c.lz4";
 
-        merge_n_files_less_than_64_colors( liste, t_file);
+        const bool reused = journal.done("s2.1", liste, {t_file});
+        if( reused == false )
+        {
+            CMetrics::span node( shorten(t_file, 32), max_files );
+            CMemoryBudget::lease memory(ram_bytes / threads, ram_bytes / std::min<uint64_t>(threads, n_files.size()));
+            merge_n_files_less_than_64_colors( liste, t_file, memory.bytes() / (1024 * 1024) );
+            journal.commit("s2.1", liste, {t_file});
+        }
 
         if(keep_minimizer_files == false)
         {
@@ -191,9 +297,12 @@ void generate_minimizers(
         //
         // Information reporting for the user
         //
-        if(verbose >= 3 ){
+        int rank;
+#pragma omp atomic capture
+        rank = cnt++;
+        if( (verbose >= 3) && (reused == false) ){
             const file_stats t_file( o_file.name );
-            printf("[III] %6d | %s .... ", cnt, l_files[ll            ].name.c_str());
+            printf("[III] %6d | %s .... ", rank, l_files[ll            ].name.c_str());
             printf("%s ",                 l_files[ll+max_files-1].name.c_str());
             printf("   == %d x MERGE =>   ", 8);
             t_file.printf_size();
@@ -201,7 +310,6 @@ void generate_minimizers(
             const float elapsed_file = std::chrono::duration_cast<std::chrono::milliseconds>(end_file - start_file).count() / 1000.f;
             printf("in  %6.2fs\n", elapsed_file);
         }
-        cnt += 1;
     }
 
     const float elapsed_merge_64 = merge_64_timer.get_time_sec();
@@ -219,12 +327,14 @@ void generate_minimizers(
     std::vector<CMergeFile> vrac_names; //vrac_names sortie pour ceux laissés de côté
 
     CTimer merge_8_timer( true );
+    CMetrics::stage( "step2.2" );
 
     if (verbose >= 1){
         printf("[I] Step 2.2: Tree-based %ld-ways merging of first stage files - %d thread(s)\n", merge_step, threads);
     }
     
     int colors = 64;
+    int level  = 1;
     omp_set_num_threads(threads); // on regle le niveau de parallelisme accessible dans cette partie
     while( l_files.size() > 1 )
     {
@@ -240,7 +350,7 @@ void generate_minimizers(
 
 
         int cnt = 0;
-#pragma omp parallel for
+#pragma omp parallel for reduction(+:in_mbytes, ou_mbytes)
         for(size_t ll = 0; ll < l_files.size(); ll += merge_step) // On merge par 8, ce choix est discutable
         {
             //
@@ -249,14 +359,6 @@ void generate_minimizers(
             const auto start_file = std::chrono::steady_clock::now();
             const int64_t max_files = (l_files.size() - ll) < merge_step ? (l_files.size() - ll) : merge_step;
 
-            int64_t local_mb = 0;
-            for(int ff = 0; ff < max_files; ff += 1)
-            {
-                const file_stats file_s( l_files[ll + ff].name );
-                in_mbytes += file_s.size_mb;
-                local_mb  += file_s.size_mb;
-            }
-
             int final_real_color = 0;
             for(int ff = 0; ff < max_files; ff += 1)
                 final_real_color += l_files[ll + ff].real_colors;
@@ -268,7 +370,11 @@ void generate_minimizers(
             //
             // Generation of the name of the output file
             //
-            std::string t_file   = tmp_dir + "/data_n";
+            //
+            // Le niveau fait partie du nom : le fichier laissé seul à la fin d'un niveau garde son
+            // nombre de couleurs et écraserait sinon celui d'un autre noeud du niveau suivant
+            //
+            std::string t_file   = tmp_dir + "/data_l" + std::to_string(level) + "_n";
             t_file += to_number(ll/merge_step, l_files.size()/merge_step) + ".";
             t_file += std::to_string(final_real_color) + "c.lz4";
 
@@ -279,10 +385,35 @@ void generate_minimizers(
             for(int ff = 0; ff < max_files; ff += 1)
                 tmp_list.push_back( l_files[ll + ff].name );
 
-            merge_n_files_greater_than_64_colors(
-                    tmp_list,
-                    l_files[ll].numb_colors,
-                t_file);
+            //
+            // Les fichiers d'un noeud déjà fusionné par un run interrompu ont pu être consommés
+            //
+            const bool reused = journal.done("s2.2", tmp_list, {t_file});
+
+            int64_t local_mb = 0;
+            for(int ff = 0; (ff < max_files) && (reused == false); ff += 1)
+            {
+                const file_stats file_s( l_files[ll + ff].name );
+                in_mbytes += file_s.size_mb;
+                local_mb  += file_s.size_mb;
+            }
+
+            //
+            // Les fichiers produits à partir d'ici utilisent une représentation adaptative des
+            // couleurs (liste, bitmap ou plages), seuls ceux de l'étape 2.1 sont des bitmaps
+            //
+            if( reused == false )
+            {
+                CMetrics::span node( shorten(t_file, 32), max_files );
+                CMemoryBudget::lease memory(ram_bytes / threads, ram_bytes / std::min<uint64_t>(threads, n_files.size()));
+                merge_n_files_hybrid(
+                        tmp_list,
+                        l_files[ll].numb_colors,
+                        colors > 64,
+                    t_file,
+                    memory.bytes() / (1024 * 1024));
+                journal.commit("s2.2", tmp_list, {t_file});
+            }
 
             if (keep_merge_files == false)
             {
@@ -290,20 +421,26 @@ void generate_minimizers(
                     std::remove( l_files[ll + ff].name.c_str() );
             }
 
-            const file_stats o_file( t_file );
-            ou_mbytes += o_file.size_mb;
-
             //
             // Creation of the object associated to the generated file
             //
             CMergeFile cm_file( t_file, final_numb_colors, final_real_color);
             n_files[ll/merge_step] = cm_file;
 
+            if( reused == true )
+                continue;
+
+            const file_stats o_file( t_file );
+            ou_mbytes += o_file.size_mb;
+
             //
             // Information reporting for the user
             //
+            int rank;
+#pragma omp atomic capture
+            rank = cnt++;
             if(verbose >= 3 ){
-                printf("[III] %6d | %s .... ", cnt, l_files[ll            ].name.c_str());
+                printf("[III] %6d | %s .... ", rank, l_files[ll            ].name.c_str());
                 printf("%s ",                 l_files[ll+max_files-1].name.c_str());
                 printf("   == %ld x MERGE =>   ", merge_step);
                 o_file.printf_size();
@@ -311,8 +448,6 @@ void generate_minimizers(
                 const float elapsed_file = std::chrono::duration_cast<std::chrono::milliseconds>(end_file - start_file).count() / 1000.f;
                 printf("in  %6.2fs\n", elapsed_file);
             }
-
-            cnt += 1; // on compte le nombre de données traitées
         }
         const auto  end_merge = std::chrono::steady_clock::now();
 
@@ -360,6 +495,7 @@ void generate_minimizers(
         l_files = n_files;
         n_files.clear();
         colors *= merge_step;
+        level  += 1;
     }
 
     const float elapsed_merge_8 = merge_8_timer.get_time_sec();
@@ -369,22 +505,32 @@ void generate_minimizers(
     }
     
 
-    bool skip_final_merge = false;
     if(vrac_names.size() == 0)
     {
         //
-        // On n'a qu'un seul fichier suite au premier processus de fusion (64), donc on ne passe
-        // pas par la seconde étape de fusion => mise à jour du vecteur de sortie
-        // OU
-        // le nombre de fichier était multiple de 64 TODO: gérer le split sparse/dense ici aussi
+        // On n'a qu'un seul fichier suite au premier processus de fusion (64 échantillons au
+        // plus) : ses bitmaps simples sont convertis en lignes adaptatives, et il passe par la
+        // fusion finale qui le découpe en tiers comme les autres
         //
         const CMergeFile single = l_files[0];
-        vrac_names.push_back( single );
-        skip_final_merge = true;
+        CMergeFile block = single;
+        block.name        = tmp_dir + "/data_n_block." + std::to_string( single.real_colors ) + "c.lz4";
+        block.numb_colors = single.real_colors;
+        if( journal.done("s2.2", { single.name }, { block.name }) == false )
+        {
+            CMetrics::span node( shorten(block.name, 32), 1 );
+            merge_n_files_hybrid({ single.name }, 64, false, block.name);
+            journal.commit("s2.2", { single.name }, { block.name });
+        }
+        if( keep_merge_files == false )
+            std::remove( single.name.c_str() );
+        vrac_names.push_back( block );
     }
 
 
     for(size_t i = 0; i < vrac_names.size(); i += 1) {
+        if( std::filesystem::exists( vrac_names[i].name ) == false )
+            continue; // déjà consommé par un run interrompu
         const file_stats t_file( vrac_names[i].name   );
         if (verbose >= 3){
             t_file.printf_size();
@@ -392,8 +538,14 @@ void generate_minimizers(
         }
     }
 
-    if( vrac_names.size() > 2 ) {
+    //
+    // En mode ajout tous les nouveaux fichiers sont fusionnés ici en un seul bloc de couleurs
+    //
+    const size_t leftovers = append_index.empty() ? 2 : 1;
+
+    if( vrac_names.size() > leftovers ) {
         CTimer timer_leftovers_merge( true );
+        CMetrics::stage( "step2.3" );
 
         if (verbose >= 2){
             printf("[II] Step 2.3: Comb-based 2-ways merging of remaining sorted minimizer files \n");
@@ -402,28 +554,34 @@ void generate_minimizers(
 
         int cnt = 0;
 
-        while( vrac_names.size() > 2 ) {
+        while( vrac_names.size() > leftovers ) {
             const auto  start_file = std::chrono::steady_clock::now();
 
             const CMergeFile i_file_1 = vrac_names[1]; // le plus grand est tjs le second
             const CMergeFile i_file_2 = vrac_names[0]; // la plus petite couleur est le premier
                   CMergeFile o_file  ( "", i_file_1, i_file_2 ); // la plus petite couleur est le premier
 
-            o_file.name = tmp_dir + "/data_n" + std::to_string(cnt++) + "." + std::to_string( o_file.real_colors ) + "c.lz4";
+            o_file.name = tmp_dir + "/data_c" + std::to_string(cnt++) + "." + std::to_string( o_file.real_colors ) + "c.lz4";
 
-            merger_in(
-                    i_file_1.name,
-                    i_file_2.name,
-                    o_file.name,
-                    i_file_1.numb_colors,
-                    i_file_2.numb_colors
-            );
+            const bool reused = journal.done("s2.3", {i_file_1.name, i_file_2.name}, {o_file.name});
+            if( reused == false )
+            {
+                CMetrics::span node( shorten(o_file.name, 32), 2 );
+                merge_level_hybrid(
+                        i_file_1.name,
+                        i_file_2.name,
+                        o_file.name,
+                        i_file_1.real_colors, // couleurs compactes, comme lors de la fusion finale
+                        i_file_2.real_colors
+                );
+                journal.commit("s2.3", {i_file_1.name, i_file_2.name}, {o_file.name});
+            }
             vrac_names[1] = o_file;
 
             //
             // Information reporting for the user
             //
-            if(verbose == true ) {
+            if( (verbose == true) && (reused == false) ) {
                 printf("%6d | %s and %s   == 2-way x MERGE =>   ", cnt, i_file_1.name.c_str(), i_file_2.name.c_str());
                 const file_stats t_file( o_file.name   );
                 t_file.printf_size();
@@ -456,37 +614,167 @@ void generate_minimizers(
 
 
 
-    if( vrac_names.size() == 2 ) //final merge, use it to split dense and sparse colors
+    //
+    // Mode ajout : les nouveaux fichiers forment un bloc de couleurs placé après celles du
+    // résultat précédent. Les lignes de ce dernier sont relues dans son index (triées par
+    // minimizer) et les deux passent par la fusion finale habituelle
+    //
+    if( append_index.empty() == false )
+    {
+        CTimer timer_append( true );
+        CMetrics::stage( "append" );
+
+        const CMergeFile block = vrac_names[0];
+
+        CMergeFile previous( tmp_dir + "/data_n_previous.lz4", 0, 0 );
+        try {
+            std::vector<uint64_t> values;
+            if( journal.done("export", { append_index }, { previous.name }, &values) == false )
+            {
+                CMetrics::span node( shorten(previous.name, 32) );
+                values = { export_color_rows(append_index, previous.name) };
+                journal.commit("export", { append_index }, { previous.name }, values);
+            }
+            previous.real_colors = previous.numb_colors = values[0];
+        } catch (const std::exception& e) {
+            error_section();
+            printf("(EE) %s\n", e.what());
+            printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+            reset_section();
+            exit( EXIT_FAILURE );
+        }
+
+        vrac_names = { block, previous }; // les couleurs du résultat précédent gardent leurs numéros
+
+        if (verbose >= 2){
+            printf("[II] Append: %ld previous colors + %ld new colors (%1.2f seconds)\n", previous.real_colors, block.real_colors, timer_append.get_time_sec());
+        }
+    }
+
+    //
+    // La fusion de l'étape 2.2 a donné un unique fichier de lignes adaptatives : il passe
+    // quand même par la fusion finale (avec un fichier vide de 0 couleur) qui le découpe
+    // en tiers
+    //
+    if( vrac_names.size() == 1 )
+    {
+        const std::string empty_file = tmp_dir + "/data_n_empty.0c.lz4";
+        delete stream_writer_library::allocate( empty_file );
+        vrac_names.insert(vrac_names.begin(), CMergeFile(empty_file, 0, 0));
+    }
+
+    //
+    // Tiers of the final rows (sparse / delta / dense / complement), filled by the final merge
+    //
+    tier_policy              policy;
+    std::vector<std::string> tier_files( N_TIERS );
+    std::vector<uint64_t>    tier_rows ( N_TIERS, 0 );
+    std::vector<uint64_t>    tier_low  ( N_TIERS, 0 ); // color counts found in each tier
+    std::vector<uint64_t>    tier_high ( N_TIERS, 0 );
+
+    if( vrac_names.size() == 2 ) //final merge, use it to split the rows into the color tiers
     {
         CTimer timer_final_merge( true );
+        CMetrics::stage( "step2.4" );
 
         if (verbose >= 2){
-            printf("[II] Step 2.4: Final 2-ways merging of remaining sorted minimizer files (split dense & sparse) \n");
+            printf("[II] Step 2.4: Final 2-ways merging of remaining sorted minimizer files (split into color tiers) \n");
         }
         
         const CMergeFile i_file_1 = vrac_names[1]; // le plus grand est tjs le second
         const CMergeFile i_file_2 = vrac_names[0]; // la plus petite couleur est le premier
                 CMergeFile o_file  ( "", i_file_1, i_file_2 ); // la plus petite couleur est le premier
-                CMergeFile o_file_sparse  ( "", i_file_1, i_file_2 ); // la plus petite couleur est le premier
 
         o_file.name = tmp_dir + "/data_n_final." + std::to_string( o_file.real_colors ) + "c.lz4";
-        o_file_sparse.name = tmp_dir + "/data_n_final_sparse." + std::to_string( o_file.real_colors ) + "c.lz4";
-
-        merger_in(
-                i_file_1.name,
-                i_file_2.name,
-                o_file.name,
-                o_file_sparse.name,
-                i_file_1.real_colors,
-                i_file_2.real_colors
-        );
+        for(int t = 0; t < N_TIERS; t += 1)
+            tier_files[t] = (t == TIER_DENSE) ? o_file.name
+                          : tmp_dir + "/data_n_final_" + tier_name(t) + "." + std::to_string( o_file.real_colors ) + "c.lz4";
+
+        const std::string index_file = output + "." + std::to_string( o_file.real_colors ) + "c.index";
+        std::vector<std::string> final_outputs = tier_files;
+        if( build_index == true )
+            final_outputs.push_back( index_file );
+
+        //
+        // La politique, le nombre de lignes de chaque tier et leurs nombres de couleurs extrêmes
+        // sont conservés dans le journal
+        //
+        std::vector<uint64_t> values;
+        const bool reused = journal.done("s2.4", {i_file_1.name, i_file_2.name}, final_outputs, &values) && (values.size() == 8 + 3 * N_TIERS);
+        if( reused == true )
+        {
+            policy = { values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7] != 0 };
+            tier_rows.assign( values.begin() + 8,               values.begin() + 8 +     N_TIERS );
+            tier_low .assign( values.begin() + 8 +     N_TIERS, values.begin() + 8 + 2 * N_TIERS );
+            tier_high.assign( values.begin() + 8 + 2 * N_TIERS, values.begin() + 8 + 3 * N_TIERS );
+        }
+        else
+        {
+            CMetrics::span node( shorten(o_file.name, 32), 2 );
+            if( split_policy == "legacy" )
+            {
+                policy = tier_policy::legacy(i_file_1.real_colors, i_file_2.real_colors);
+                policy.sparse_vbyte = (sparse_codec == "vbyte");
+            }
+            else
+            {
+                //
+                // Un premier passage sur les 2 fichiers donne l'histogramme du nombre de couleurs
+                // par minimizer, qui fixe les seuils des différents tiers
+                //
+                const std::vector<uint64_t> histo = final_color_histogram(
+                        i_file_1.name,
+                        i_file_2.name,
+                        i_file_1.real_colors,
+                        i_file_2.real_colors
+                );
+                policy = tier_policy::from_histogram(i_file_1.real_colors, i_file_2.real_colors, histo, sparse_codec == "vbyte");
+            }
+            if (verbose >= 3){
+                policy.print();
+            }
+
+            tier_rows = merge_level_hybrid_final(
+                    i_file_1.name,
+                    i_file_2.name,
+                    tier_files,
+                    policy,
+                    i_file_1.real_colors,
+                    i_file_2.real_colors,
+                    tier_low,
+                    tier_high
+            );
+
+            //
+            // Les fichiers des tiers sont encore triés par minimizer, c'est le moment de construire
+            // l'index d'accès direct
+            //
+            if( build_index == true )
+            {
+                CMetrics::span index_node( shorten(index_file, 32) );
+                CTimer timer_index( true );
+                std::vector<std::string> indexed( N_TIERS );
+                for(int t = 0; t < N_TIERS; t += 1)
+                    if( tier_rows[t] != 0 ) indexed[t] = tier_files[t];
+                const uint64_t rows = build_minimizer_index(indexed, policy, index_file);
+                if (verbose >= 2){
+                    printf("[II] Minimizer index (%lu rows) written to %s in %1.2f seconds\n", rows, index_file.c_str(), timer_index.get_time_sec());
+                }
+            }
+
+            values = { policy.n_colors, policy.level_1, policy.bitmap_words, policy.sparse_bits,
+                       policy.sparse_max, policy.delta_max, policy.complement_min, policy.sparse_vbyte };
+            values.insert(values.end(), tier_rows.begin(), tier_rows.end());
+            values.insert(values.end(), tier_low .begin(), tier_low .end());
+            values.insert(values.end(), tier_high.begin(), tier_high.end());
+            journal.commit("s2.4", {i_file_1.name, i_file_2.name}, final_outputs, values);
+        }
         vrac_names[1] = o_file;
-        vrac_names.push_back( o_file_sparse );
 
         //
         // Information reporting for the user
         //
-        if(verbose >= 3 ){
+        if( (verbose >= 3) && (reused == false) ){
             printf("[III] %6d | %s and %s   == 2-way x MERGE =>   ", cnt, i_file_1.name.c_str(), i_file_2.name.c_str());
             const file_stats t_file( o_file.name   );
             t_file.printf_size();
@@ -534,12 +822,13 @@ void generate_minimizers(
 
 
     //
-    // Normalement on a un (deux avec sparse) fichier en sortie du processus de fusion, sinon c'est que quelque-chose
-    // a merdé dans le processus de fusion
+    // Normalement on a un fichier (dense, les autres tiers sont dans tier_files) en sortie du processus
+    // de fusion, sinon c'est que quelque-chose a merdé dans le processus de fusion
     //
-    if( vrac_names.size() == 2 || skip_final_merge == true ) //sparse + dense
+    if( vrac_names.size() == 1 )
     {
         CTimer timer_color_sort( true );
+        CMetrics::stage( "step3" );
 
         if (verbose >= 2) {
             printf("[II] Post Step 2: External sorting of final minimize-colors files \n");
@@ -547,48 +836,109 @@ void generate_minimizers(
         
 
         const CMergeFile lastfile = vrac_names[0];
-        const std::string o_file = output + "." + std::to_string(lastfile.real_colors) + "c.lz4";
-
-        external_sort(
-            lastfile.name,
-            o_file,
-            tmp_dir,
-            filenames.size(),
-            ram_value_MB,
-            keep_merge_files,
-            verbose,
-            threads
-        );
+              std::string o_file = output + "." + std::to_string(lastfile.real_colors) + "c.lz4";
+        const uint64_t    dense_colors = 64 * policy.bitmap_words; // rows hold W1 + W2 words
+        const color_grouping grouping  = (color_grouping_algo == "hash") ? GROUP_HASH : GROUP_SORT;
+
+        std::string class_table;
+        if( color_classes.empty() == false )
+        {
+            const std::string ext = (color_classes == "raw") ? "bin" : color_classes;
+            class_table = output + "." + std::to_string(lastfile.real_colors) + "c.classes." + ext;
+            o_file      = output + "." + std::to_string(lastfile.real_colors) + "c.ids."     + ext;
+        }
+
+        std::vector<std::string> dense_outputs = { o_file };
+        if( class_table.empty() == false )
+            dense_outputs.push_back( class_table );
+
+        if( journal.done("s3", {lastfile.name}, dense_outputs) == true )
+        {
+            if (verbose >= 2){
+                printf("[II] External sorting of %s already done\n", lastfile.name.c_str());
+            }
+        }
+        else
+        {
+            CMetrics::span node( shorten(o_file, 32) );
+            if( color_classes.empty() == true )
+            {
+                external_sort(
+                    lastfile.name,
+                    o_file,
+                    tmp_dir,
+                    dense_colors,
+                    ram_value_MB,
+                    true, // l'entrée est supprimée plus bas, une fois l'étape inscrite au journal
+                    verbose,
+                    threads,
+                    grouping
+                );
+            }
+            else
+            {
+                //
+                // Les bitmaps identiques sont remplacés par l'identifiant de leur classe de couleurs
+                //
+                external_sort_color_classes(
+                    lastfile.name,
+                    class_table,
+                    o_file,
+                    tmp_dir,
+                    dense_colors,
+                    ram_value_MB,
+                    true,
+                    verbose,
+                    threads,
+                    grouping
+                );
+            }
+            journal.commit("s3", {lastfile.name}, dense_outputs);
+        }
 
         if (!keep_merge_files){
             std::remove( lastfile.name.c_str() );
         }
-        
 
-        
-        if (!skip_final_merge){
+        std::vector<std::string> o_files( N_TIERS );
+        o_files[TIER_DENSE] = o_file;
 
-            const CMergeFile lastfile_sparse = vrac_names[1];
-            const std::string o_file_sparse = output + "_sparse." + std::to_string(lastfile_sparse.real_colors) + "c.lz4";
+        for(int t = 0; t < N_TIERS; t += 1)
+        {
+            if( (t == TIER_DENSE) || (tier_rows[t] == 0) ){
+                if( t != TIER_DENSE ) std::remove( tier_files[t].c_str() ); // tier present but empty
+                continue;
+            }
+            o_files[t] = output + "_" + tier_name(t) + "." + std::to_string(lastfile.real_colors) + "c.lz4";
 
-            if (get_file_size( lastfile_sparse.name ) > 0) {
+            if( journal.done("s3", {tier_files[t]}, {o_files[t]}) == false )
+            {
+                CMetrics::span node( shorten(o_files[t], 32) );
                 external_sort_sparse(
-                    lastfile_sparse.name,
-                    o_file_sparse,
+                    tier_files[t],
+                    o_files[t],
                     tmp_dir,
-                    filenames.size(),
+                    policy.n_colors,
                     ram_value_MB,
                     keep_merge_files,
                     verbose,
-                    threads
+                    threads,
+                    (t == TIER_DELTA) ? SPARSE_DELTA : ((t == TIER_SPARSE) && policy.sparse_vbyte) ? SPARSE_VBYTE : SPARSE_LIST,
+                    grouping
                 );
+                journal.commit("s3", {tier_files[t]}, {o_files[t]});
             }
 
             if (!keep_merge_files){
-                std::remove( lastfile_sparse.name.c_str() );
+                std::remove( tier_files[t].c_str() );
             }
         }
 
+        policy.write_manifest(output + "." + std::to_string(lastfile.real_colors) + "c.manifest", o_files, tier_rows, tier_low, tier_high, class_table);
+
+        if( (build_mphf == true) && (class_table.empty() == true) )
+            build_mphf_step(o_files, policy, output + "." + std::to_string(lastfile.real_colors) + "c.mphf", threads, verbose);
+
     
 
     const float elapsed_color_sort = timer_color_sort.get_time_sec();
@@ -602,4 +952,83 @@ void generate_minimizers(
         printf("(EE) Error location : %s %d\n", __FILE__, __LINE__); //skip sorting = bug
         exit( EXIT_FAILURE );
     }
-}
\ No newline at end of file
+
+    //
+    // Le run est terminé, il n'y a plus rien à reprendre
+    //
+    if (verbose >= 2 && journal.reused() != 0){
+        printf("[II] %lu step(s) reused from the journal\n", journal.reused());
+    }
+    journal.close();
+    std::remove( (tmp_dir + "/breizh.journal").c_str() );
+    CMetrics::stage( "" );
+
+    if (verbose >= 1){
+        printf("[I] Memory budget peak : %lu MB / %lu MB\n", CMemoryBudget::peak() / (1024 * 1024), ram_value_MB);
+    }
+    CMemoryBudget::set_limit(0, 0);
+}//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+std::vector<query_result> query_index(
+    const std::vector<std::string>& filenames,
+    const std::string &index_file,
+    const std::string &output,
+    const int threads,
+    const int k,
+    const int m,
+    const double min_ratio,
+    size_t verbose)
+{
+    if (verbose >= 1){
+        printf("[I] Querying %zu file(s) against %s - %d thread(s)\n", filenames.size(), index_file.c_str(), threads);
+    }
+
+    CTimer query_timer( true );
+
+    std::vector<query_result> results;
+    try {
+        results = query_files(index_file, filenames, k, m, threads);
+    } catch (const std::exception& e) {
+        error_section();
+        printf("(EE) %s\n", e.what());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+
+    FILE* f = (output == "-") ? stdout : fopen(output.c_str(), "w");
+    if( f == NULL )
+    {
+        error_section();
+        printf("(EE) Cannot create the output file (%s)\n", output.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+
+    fprintf(f, "#query\tminimizers\tcolor\thits\tratio\n");
+    for(const query_result& r : results)
+    {
+        for(size_t c = 0; c < r.hits.size(); c += 1)
+        {
+            const double ratio = (r.minimizers != 0) ? (double)r.hits[c] / (double)r.minimizers : 0.0;
+            if( (r.hits[c] == 0) || (ratio < min_ratio) )
+                continue;
+            fprintf(f, "%s\t%lu\t%zu\t%lu\t%.4f\n", shorten(r.name, 0).c_str(), r.minimizers, c, r.hits[c], ratio);
+        }
+    }
+    if( f != stdout )
+        fclose( f );
+
+    if (verbose >= 2){
+        for(const query_result& r : results)
+            printf("[II] %s : %lu minimizers, %lu indexed\n", r.name.c_str(), r.minimizers, r.found);
+        printf("[II] Query time : %1.2f seconds\n", query_timer.get_time_sec());
+    }
+    return results;
+}
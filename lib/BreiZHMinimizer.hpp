@@ -13,17 +13,28 @@
 #include "../src/minimizer/minimizer_v2.hpp"
 #include "../src/minimizer/minimizer_v3.hpp"
 #include "../src/minimizer/minimizer_v4.hpp"
+#include "../src/minimizer/step1_schedule.hpp"
 #include "../src/merger/in_file/merger_in.hpp"
 #include "../src/merger/CMergeFile.hpp"
 
 #include "../src/merger/in_file/merger_n_files.hpp"
 #include "../src/merger/in_file/merger_n_files_lt64.hpp"
 #include "../src/merger/in_file/merger_n_files_ge64.hpp"
+#include "../src/merger/in_file/merger_n_files_hybrid.hpp"
+#include "../src/merger/in_file/merger_level_hybrid_final.hpp"
 
 #include "../src/sorting/external_sort/external_sort.hpp"
+#include "../src/files/stream_writer_library.hpp"
+#include "../src/index/minimizer_index.hpp"
+#include "../src/index/minimizer_mphf.hpp"
+#include "../src/query/minimizer_query.hpp"
 
 #include "../src/tools/colors.hpp"
 #include "../src/tools/CTimer/CTimer.hpp"
+#include "../src/tools/CJournal/CJournal.hpp"
+#include "../src/tools/CMetrics/CMetrics.hpp"
+#include "../src/tools/CMemoryBudget/CMemoryBudget.hpp"
+#include "../src/hash/MurmurHash3.hpp"
 #include "../src/tools/file_stats.hpp"
 
 uint64_t get_file_size(const std::string& filen);
@@ -41,7 +52,32 @@ void generate_minimizers(
     size_t verbose,
     bool skip_minimizer_step = false, 
     bool keep_minimizer_files = false,
-    bool keep_merge_files = false
+    bool keep_merge_files = false,
+    const std::string &split_policy = "auto",
+    const std::string &color_classes = "",
+    const std::string &color_grouping_algo = "sort",
+    const std::string &sparse_codec = "fixed",
+    const bool build_index = false,
+    const bool build_mphf = false,
+    const std::string &append_index = "",
+    const bool resume = false,
+    const std::string &accumulator = "list"
+);
+
+//
+// Per color minimizer hits of each query file against an index built with --index, written
+// as a tab separated table (query, minimizers, color, hits, ratio), colors whose hit ratio is
+// below min_ratio are left out. Returns the per file results.
+//
+std::vector<query_result> query_index(
+    const std::vector<std::string>& filenames,
+    const std::string &index_file,
+    const std::string &output,
+    const int threads,
+    const int k,
+    const int m,
+    const double min_ratio,
+    size_t verbose
 );
 
 #endif
\ No newline at end of file
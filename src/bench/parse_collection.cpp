@@ -0,0 +1,46 @@
+#include "parse_collection.hpp"
+
+#include "../front/open_reader_ATCG_only.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <omp.h>
+
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t parse_collection(const std::vector<std::string>& filenames, const int threads)
+{
+    uint64_t    n_bases = 0;
+    std::string error;
+
+#pragma omp parallel for schedule(dynamic) num_threads(threads) reduction(+:n_bases)
+    for(size_t i = 0; i < filenames.size(); i += 1)
+    {
+        try {
+            std::unique_ptr<file_reader_ATCG_only> reader( open_reader_ATCG_only(filenames[i], 2 * 1024 * 1024) );
+            if( reader == nullptr )
+                throw std::runtime_error("File extension is not supported: " + filenames[i]);
+            char*    seq_buffer = nullptr;
+            uint64_t seq_size   = 0;
+            while( true )
+            {
+                const std::tuple<bool, bool> eof_eos = reader->load_next_chunk(&seq_buffer, &seq_size);
+                n_bases += seq_size;
+                if( std::get<0>(eof_eos) == true )
+                    break;
+            }
+        } catch (const std::exception& e) {
+#pragma omp critical
+            error = e.what();
+        }
+    }
+
+    if( error.empty() == false )
+        throw std::runtime_error( error );
+    return n_bases;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// Parsing stage alone : the files are decoded by the ATCG readers of Step 1 (same buffer
+// size), files processed in parallel. Returns the number of bases delivered.
+//
+extern uint64_t parse_collection(const std::vector<std::string>& filenames, const int threads);
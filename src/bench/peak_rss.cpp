@@ -0,0 +1,37 @@
+#include "peak_rss.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/resource.h>
+
+void reset_peak_rss()
+{
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if( f == NULL )
+        return;
+    fputs("5", f);
+    fclose( f );
+}
+
+uint64_t peak_rss_kb()
+{
+    FILE* f = fopen("/proc/self/status", "r");
+    if( f != NULL )
+    {
+        char line[256];
+        while( fgets(line, sizeof(line), f) != NULL )
+        {
+            unsigned long kb = 0;
+            if( sscanf(line, "VmHWM: %lu kB", &kb) == 1 )
+            {
+                fclose( f );
+                return kb;
+            }
+        }
+        fclose( f );
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
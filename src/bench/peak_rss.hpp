@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+
+//
+// Peak resident set size of the process (VmHWM), in KB. reset_peak_rss() restarts the
+// measure from the current RSS (Linux >= 4.0, otherwise the peak since the start is kept),
+// so that each benchmark run reports its own peak.
+//
+extern void     reset_peak_rss();
+extern uint64_t peak_rss_kb();
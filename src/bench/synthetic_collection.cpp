@@ -0,0 +1,213 @@
+#include "synthetic_collection.hpp"
+#include "../files/stream_writer_library.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <omp.h>
+
+static const char nucleotides[4] = {'A', 'C', 'G', 'T'};
+
+static void random_sequence(std::mt19937_64& rng, std::string& seq, const uint64_t length)
+{
+    seq.resize( length );
+    uint64_t bits = 0;
+    for(uint64_t i = 0; i < length; i += 1)
+    {
+        if( (i % 32) == 0 )
+            bits = rng();
+        seq[i] = nucleotides[bits & 0x3];
+        bits >>= 2;
+    }
+}
+
+//
+// Substitutions at the given rate, the gaps between two of them follow a geometric law
+//
+static void mutate(std::mt19937_64& rng, std::string& seq, const double rate)
+{
+    if( (rate <= 0.0) || seq.empty() )
+        return;
+    std::geometric_distribution<uint64_t> gap( std::min(rate, 1.0) );
+    for(uint64_t pos = gap(rng); pos < seq.size(); pos += 1 + gap(rng))
+    {
+        const int b = (int)(std::find(nucleotides, nucleotides + 4, seq[pos]) - nucleotides);
+        seq[pos]    = nucleotides[(b + 1 + rng() % 3) % 4];
+    }
+}
+
+static void reverse_complement(std::string& seq)
+{
+    std::reverse(seq.begin(), seq.end());
+    for(char& c : seq)
+        c = (c == 'A') ? 'T' : (c == 'C') ? 'G' : (c == 'G') ? 'C' : 'A';
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+class text_output
+{
+private:
+    std::unique_ptr<stream_writer> writer;
+    std::string                    buffer;
+
+public:
+    text_output(const std::string& filen) : writer( stream_writer_library::allocate(filen) )
+    {
+        if( (writer == nullptr) || (writer->is_open() == false) )
+            throw std::runtime_error("Cannot create the synthetic sample: " + filen);
+        buffer.reserve(4 << 20);
+    }
+
+    ~text_output()
+    {
+        flush();
+        writer->close();
+    }
+
+    void flush()
+    {
+        writer->write_bytes(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+    void append(const std::string& s)
+    {
+        buffer += s;
+        if( buffer.size() >= (4 << 20) )
+            flush();
+    }
+
+    void append_lines(const std::string& seq, const uint64_t width)
+    {
+        for(uint64_t p = 0; p < seq.size(); p += width)
+        {
+            buffer.append(seq, p, width);
+            buffer += '\n';
+            if( buffer.size() >= (4 << 20) )
+                flush();
+        }
+    }
+};
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+std::vector<std::string> generate_synthetic_collection(const synthetic_params& params, const std::string& directory, const int threads)
+{
+    const std::string kind = params.format.substr(0, params.format.find('.'));
+    const std::string comp = (params.format.find('.') == std::string::npos) ? "" : params.format.substr(params.format.find('.') + 1);
+    if( (kind != "fasta") && (kind != "fastq") )
+        throw std::runtime_error("Unsupported synthetic format (fasta or fastq): " + params.format);
+    if( (comp != "") && (comp != "gz") && (comp != "bz2") && (comp != "lz4") )
+        throw std::runtime_error("Unsupported synthetic compression (gz, bz2 or lz4): " + params.format);
+    if( (kind == "fastq") && (params.reads == false) )
+        throw std::runtime_error("Assemblies are written in FASTA");
+    if( (params.samples == 0) || (params.genome_size == 0) || (params.block_size == 0) )
+        throw std::runtime_error("Empty synthetic collection");
+
+    std::filesystem::create_directories( directory );
+
+    //
+    // Shared material : the core genome and the pool of accessory blocks. Block j is picked by
+    // a sample with a weight 1/(j+1), from blocks present in almost every sample to blocks
+    // found in a few of them.
+    //
+    std::mt19937_64 rng( params.seed );
+    const uint64_t core_size  = (uint64_t)(params.core_fraction * params.genome_size);
+    const uint64_t acc_size   = params.genome_size - std::min(core_size, params.genome_size);
+    const uint64_t acc_blocks = (acc_size + params.block_size - 1) / params.block_size;
+
+    std::string core;
+    random_sequence(rng, core, core_size);
+
+    std::vector<std::string> pool( 2 * acc_blocks );
+    for(std::string& block : pool)
+        random_sequence(rng, block, params.block_size);
+
+    std::vector<std::string> names( params.samples );
+    for(uint64_t s = 0; s < params.samples; s += 1)
+    {
+        std::string number = std::to_string(s);
+        number = std::string(number.size() < 5 ? 5 - number.size() : 0, '0') + number;
+        names[s] = directory + "/sample_" + number + "." + params.format;
+    }
+
+    std::string error;
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+    for(uint64_t s = 0; s < params.samples; s += 1)
+    {
+        try {
+            std::mt19937_64 srng( params.seed ^ (0x9E3779B97F4A7C15ULL * (s + 1)) );
+
+            //
+            // Records of the sample : its copy of the core and its accessory blocks
+            //
+            std::vector<std::string> records;
+            records.push_back( core );
+            mutate(srng, records.back(), params.snp_rate);
+
+            std::uniform_real_distribution<double> uni(0.0, 1.0);
+            std::vector<std::pair<double, uint64_t>> keys( pool.size() );
+            for(uint64_t j = 0; j < pool.size(); j += 1)
+                keys[j] = { std::pow(uni(srng), (double)(j + 1)), j }; // u^(1/w), w = 1/(j+1)
+            std::partial_sort(keys.begin(), keys.begin() + acc_blocks, keys.end(),
+                              [](const auto& a, const auto& b) { return a.first > b.first; });
+            for(uint64_t j = 0; j < acc_blocks; j += 1)
+            {
+                records.push_back( pool[keys[j].second] );
+                mutate(srng, records.back(), params.snp_rate);
+            }
+
+            text_output out( names[s] );
+            if( params.reads == false )
+            {
+                for(uint64_t r = 0; r < records.size(); r += 1)
+                {
+                    out.append(">s" + std::to_string(s) + ((r == 0) ? "_core" : "_acc" + std::to_string(r)) + "\n");
+                    out.append_lines(records[r], 80);
+                }
+                continue;
+            }
+
+            const std::string quality( params.read_length, 'I' );
+            uint64_t n_read = 0;
+            std::string read;
+            for(const std::string& rec : records)
+            {
+                if( rec.size() < params.read_length )
+                    continue;
+                const uint64_t n = (uint64_t)std::llround(params.coverage * rec.size() / params.read_length);
+                for(uint64_t i = 0; i < n; i += 1)
+                {
+                    read.assign(rec, srng() % (rec.size() - params.read_length + 1), params.read_length);
+                    if( srng() & 1 )
+                        reverse_complement( read );
+                    mutate(srng, read, params.error_rate);
+
+                    if( kind == "fastq" )
+                        out.append("@r" + std::to_string(n_read++) + "\n" + read + "\n+\n" + quality + "\n");
+                    else
+                        out.append(">r" + std::to_string(n_read++) + "\n" + read + "\n");
+                }
+            }
+        } catch (const std::exception& e) {
+#pragma omp critical
+            error = e.what();
+        }
+    }
+
+    if( error.empty() == false )
+        throw std::runtime_error( error );
+    return names;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// Reproducible synthetic sample collections for the benchmarks.
+//
+// Every sample is made of the core genome (core_fraction x genome_size bases, shared by all
+// the samples, each copy carries its own substitutions at snp_rate) and of accessory blocks
+// drawn from a pool twice as large as the accessory part of a sample, so that the accessory
+// content is shared by random subsets of the samples (the final rows then spread over all
+// the color tiers).
+//
+// Assemblies are written as one record per core / accessory block. Reads are sampled
+// uniformly from the records of the sample, on both strands, with substitution errors at
+// error_rate, up to the requested coverage. The format is given by the extension :
+// fasta, fastq (reads only), optionally followed by gz, bz2 or lz4.
+//
+struct synthetic_params
+{
+    uint64_t    genome_size   = 1000000;
+    uint64_t    samples       = 16;
+    double      core_fraction = 0.8;
+    double      snp_rate      = 0.002;
+    uint64_t    block_size    = 5000;     // accessory block length
+    bool        reads         = false;    // assemblies by default
+    double      coverage      = 10.0;
+    uint64_t    read_length   = 150;
+    double      error_rate    = 0.001;
+    std::string format        = "fasta";
+    uint64_t    seed          = 42;
+};
+
+//
+// Writes the samples in directory (created when missing), returns the file names in sample
+// order. The content only depends on the parameters (seed included), not on the threads.
+//
+extern std::vector<std::string> generate_synthetic_collection(const synthetic_params& params, const std::string& directory, const int threads);
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+//
+// Largest request handed in one call to the int based read()/write() primitives
+//
+static constexpr size_t io_max_call_bytes = 1024 * 1024 * 1024;
@@ -75,7 +75,18 @@ bool stream_lz4_reader::is_eof()
 //
 int  stream_lz4_reader::read(void* buffer, int eSize, int eCount)
 {
-    const LZ4F_errorCode_t nread = LZ4F_read (lz4fRead, buffer, eCount * eSize );
+    return read_bytes(buffer, (size_t)eCount * eSize) / eSize; // nombre d'éléments lu et NON PAS le nombre de bytes !
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+size_t stream_lz4_reader::read_bytes(void* buffer, size_t n_bytes)
+{
+    const LZ4F_errorCode_t nread = LZ4F_read (lz4fRead, buffer, n_bytes );
     if (LZ4F_isError(nread)) {
         error_section();
         printf("(EE) LZ4F_read error: %s\n", LZ4F_getErrorName(nread));
@@ -83,8 +94,8 @@ int  stream_lz4_reader::read(void* buffer, int eSize, int eCount)
         reset_section();
         exit( EXIT_FAILURE );
     }
-    is_foef |= ( (eCount * eSize) != static_cast<int>(nread) ); // a t'on atteint la fin du fichier ?
-    return (nread / eSize); // nombre d'éléments lu et NON PAS le nombre de bytes !
+    is_foef |= ( n_bytes != nread ); // a t'on atteint la fin du fichier ?
+    return nread;
 }
 //
 //
@@ -110,6 +110,26 @@ int stream_lz4_writer::write(void* buffer, int eSize, int eCount)
 //
 //
 //
+size_t stream_lz4_writer::write_bytes(const void* buffer, size_t n_bytes)
+{
+    const LZ4F_errorCode_t ret = LZ4F_write(lz4fWrite, buffer, n_bytes);
+    if (LZ4F_isError(ret) || (ret != n_bytes)) {
+        error_section();
+        printf("(EE) An error occured during the LZ4F_write task:\n");
+        printf("(EE) - Amount of data to write (bytes)  : %zu\n", n_bytes);
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+    return ret;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
 void stream_lz4_writer::close()
 {
     const LZ4F_errorCode_t ret = LZ4F_writeClose(lz4fWrite);
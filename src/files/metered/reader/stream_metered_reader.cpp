@@ -0,0 +1,68 @@
+#include "stream_metered_reader.hpp"
+#include "../../../tools/CMetrics/CMetrics.hpp"
+#include <sys/stat.h>
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_metered_reader::stream_metered_reader(stream_reader* inner, const std::string& filen)
+    : reader(inner)
+{
+    struct stat file_status;
+    if( stat(filen.c_str(), &file_status) == 0 )
+        CMetrics::add(MET_READ_DISK_BYTES, file_status.st_size);
+    is_fopen = reader->is_open();
+}
+
+stream_metered_reader::~stream_metered_reader()
+{
+    delete reader;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool stream_metered_reader::is_open()
+{
+    return reader->is_open();
+}
+
+void stream_metered_reader::close()
+{
+    reader->close();
+}
+
+bool stream_metered_reader::is_eof()
+{
+    return reader->is_eof();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+int stream_metered_reader::read(void* buffer, int eSize, int eCount)
+{
+    const uint64_t t_start = CMetrics::now_ns();
+    const int      n       = reader->read(buffer, eSize, eCount);
+    CMetrics::add(MET_READ_NS,    CMetrics::now_ns() - t_start);
+    CMetrics::add(MET_READ_BYTES, (n > 0) ? (uint64_t)n * eSize : 0);
+    return n;
+}
+
+size_t stream_metered_reader::read_bytes(void* buffer, size_t n_bytes)
+{
+    const uint64_t t_start = CMetrics::now_ns();
+    const size_t   n       = reader->read_bytes(buffer, n_bytes);
+    CMetrics::add(MET_READ_NS,    CMetrics::now_ns() - t_start);
+    CMetrics::add(MET_READ_BYTES, n);
+    return n;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "../../stream_reader.hpp"
+#include <string>
+
+//
+// Decorator that reports the bytes returned by a stream, the size of its file and the time
+// spent in its reads to the metrics (see CMetrics). Only installed when the metrics are on.
+//
+class stream_metered_reader : public stream_reader
+{
+private:
+    stream_reader* reader; // decorated stream (owned)
+
+public:
+     stream_metered_reader(stream_reader* inner, const std::string& filen);
+    ~stream_metered_reader();
+
+    virtual bool   is_open   ();
+    virtual void   close     ();
+    virtual bool   is_eof    ();
+    virtual int    read      (void* buffer, int eSize, int eCount);
+    virtual size_t read_bytes(void* buffer, size_t n_bytes);
+};
@@ -0,0 +1,74 @@
+#include "stream_metered_writer.hpp"
+#include "../../../tools/CMetrics/CMetrics.hpp"
+#include <sys/stat.h>
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_metered_writer::stream_metered_writer(stream_writer* inner, const std::string& filen)
+    : writer(inner), name(filen)
+{
+    is_fopen = writer->is_open();
+}
+
+stream_metered_writer::~stream_metered_writer()
+{
+    close();
+    delete writer;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool stream_metered_writer::is_open()
+{
+    return writer->is_open();
+}
+
+void stream_metered_writer::close()
+{
+    if( is_fopen == false )
+        return;
+
+    const uint64_t t_start = CMetrics::now_ns();
+    writer->close();
+    CMetrics::add(MET_WRITE_NS, CMetrics::now_ns() - t_start);
+    is_fopen = false;
+
+    //
+    // La taille sur disque n'est connue qu'une fois les blocs compressés écrits
+    //
+    struct stat file_status;
+    if( stat(name.c_str(), &file_status) == 0 )
+        CMetrics::add(MET_WRITE_DISK_BYTES, file_status.st_size);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+int stream_metered_writer::write(void* buffer, const int eSize, const int eCount)
+{
+    const uint64_t t_start = CMetrics::now_ns();
+    const int      n       = writer->write(buffer, eSize, eCount);
+    CMetrics::add(MET_WRITE_NS,    CMetrics::now_ns() - t_start);
+    CMetrics::add(MET_WRITE_BYTES, (uint64_t)eSize * eCount);
+    return n;
+}
+
+size_t stream_metered_writer::write_bytes(const void* buffer, size_t n_bytes)
+{
+    const uint64_t t_start = CMetrics::now_ns();
+    const size_t   n       = writer->write_bytes(buffer, n_bytes);
+    CMetrics::add(MET_WRITE_NS,    CMetrics::now_ns() - t_start);
+    CMetrics::add(MET_WRITE_BYTES, n);
+    return n;
+}
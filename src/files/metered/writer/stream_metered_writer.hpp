@@ -0,0 +1,24 @@
+#pragma once
+#include "../../stream_writer.hpp"
+#include <string>
+
+//
+// Decorator that reports the bytes given to a stream, the size of its file once closed and
+// the time spent in its writes to the metrics (see CMetrics). Only installed when the
+// metrics are on.
+//
+class stream_metered_writer : public stream_writer
+{
+private:
+    stream_writer* writer; // decorated stream (owned)
+    std::string    name;
+
+public:
+     stream_metered_writer(stream_writer* inner, const std::string& filen);
+    ~stream_metered_writer();
+
+    virtual bool   is_open    ();
+    virtual int    write      (void* buffer, const int eSize, const int eCount);
+    virtual size_t write_bytes(const void* buffer, size_t n_bytes);
+    virtual void   close      ();
+};
@@ -0,0 +1,207 @@
+#include "stream_prefetch_reader.hpp"
+#include "../../../tools/colors.hpp"
+#include "../../../tools/CMetrics/CMetrics.hpp"
+#include <cstring>
+#include <algorithm>
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_prefetch_reader::stream_prefetch_reader(stream_reader* inner, const size_t _block_bytes, const int depth)
+    : reader(inner), block_bytes( (_block_bytes + block_alignment - 1) / block_alignment * block_alignment )
+{
+    if( (reader == nullptr) || (depth < 1) )
+    {
+        error_section();
+        printf("(EE) Invalid prefetch configuration (depth = %d)\n", depth);
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+
+    //
+    // Les blocs sont alignés sur une page pour que les lectures brutes restent efficaces
+    //
+    blocks.resize( depth );
+    for(size_t i = 0; i < blocks.size(); i += 1)
+    {
+        blocks[i].data = (char*)std::aligned_alloc(block_alignment, block_bytes);
+        if( blocks[i].data == nullptr )
+        {
+            error_section();
+            printf("(EE) Unable to allocate the prefetch buffers (%d x %zu bytes)\n", depth, block_bytes);
+            printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+            reset_section();
+            exit( EXIT_FAILURE );
+        }
+    }
+
+    is_fopen = reader->is_open();
+    is_foef  = false;
+    worker   = std::thread(&stream_prefetch_reader::prefetch_loop, this);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_prefetch_reader::~stream_prefetch_reader()
+{
+    if( is_open() == true )
+        close();
+    for(size_t i = 0; i < blocks.size(); i += 1)
+        std::free( blocks[i].data );
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void stream_prefetch_reader::prefetch_loop()
+{
+    while( true )
+    {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv_freed.wait(lock, [this] { return (n_filled < blocks.size()) || w_stop; });
+            if( w_stop )
+                return;
+        }
+
+        //
+        // The block at w_block is outside the filled range, the consumer cannot touch it
+        //
+        prefetch_block& blk = blocks[w_block];
+        const int nread = reader->read(blk.data, 1, (int)block_bytes);
+
+        std::unique_lock<std::mutex> lock(mtx);
+        blk.size = (nread > 0) ? nread : 0;
+        if( blk.size != 0 )
+        {
+            w_block   = (w_block + 1) % blocks.size();
+            n_filled += 1;
+        }
+        w_done = (blk.size != block_bytes);
+        cv_filled.notify_one();
+        if( w_done )
+            return;
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool stream_prefetch_reader::is_open ()
+{
+    return is_fopen;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool stream_prefetch_reader::is_eof()
+{
+    return is_foef;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+int stream_prefetch_reader::read(void* buffer, int eSize, int eCount)
+{
+    return read_bytes(buffer, (size_t)eSize * (size_t)eCount) / eSize; // nombre d'éléments lu et NON PAS le nombre de bytes !
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+size_t stream_prefetch_reader::read_bytes(void* buffer, size_t wanted)
+{
+    char*  dst    = (char*)buffer;
+    size_t copied = 0;
+
+    while( copied < wanted )
+    {
+        if( r_owned == false )
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            if( (n_filled == 0) && (w_done == false) )
+            {
+                //
+                // Le consommateur attend le décodage : temps de blocage de la fusion
+                //
+                const uint64_t t_wait = CMetrics::now_ns();
+                cv_filled.wait(lock, [this] { return (n_filled != 0) || w_done; });
+                CMetrics::add(MET_STALL_NS, CMetrics::now_ns() - t_wait);
+            }
+            if( n_filled == 0 )
+                break; // le flux est épuisé
+            r_owned = true;
+        }
+
+        const prefetch_block& blk = blocks[r_block];
+        const size_t n = std::min(blk.size - r_offset, wanted - copied);
+        std::memcpy(dst + copied, blk.data + r_offset, n);
+        copied   += n;
+        r_offset += n;
+
+        if( r_offset == blk.size )
+        {
+            r_offset = 0;
+            r_owned  = false;
+            r_block  = (r_block + 1) % blocks.size();
+            std::unique_lock<std::mutex> lock(mtx);
+            n_filled -= 1;
+            cv_freed.notify_one();
+        }
+    }
+
+    is_foef |= (copied != wanted); // a t'on atteint la fin du fichier ?
+    return copied;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void stream_prefetch_reader::close()
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        w_stop = true;
+        cv_freed.notify_one();
+    }
+    if( worker.joinable() )
+        worker.join();
+    delete reader;
+    reader   = nullptr;
+    is_fopen = false;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
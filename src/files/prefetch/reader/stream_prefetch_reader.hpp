@@ -0,0 +1,55 @@
+#pragma once
+#include "../../stream_reader.hpp"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//
+// Decorator that decodes the next blocks of a stream on a helper thread, so that
+// the consumer (a merger) only pays a memcpy when its small buffers are refilled.
+//
+class stream_prefetch_reader : public stream_reader
+{
+public:
+    static constexpr size_t max_block_bytes =  4 * 1024 * 1024; // bytes decoded per helper read
+    static constexpr size_t min_block_bytes = 64 * 1024;
+    static constexpr size_t block_alignment = 4096;
+    static constexpr int    max_depth       = 16;               // number of blocks read ahead
+
+private:
+    struct prefetch_block
+    {
+        char*  data = nullptr;
+        size_t size = 0;
+    };
+
+    stream_reader*              reader;      // decorated stream (owned)
+    const size_t                block_bytes;
+    std::vector<prefetch_block> blocks;      // ring of decoded blocks
+
+    size_t n_filled = 0;       // blocks ready for the consumer
+    size_t w_block  = 0;       // next block filled by the helper thread
+    size_t r_block  = 0;       // block currently consumed
+    size_t r_offset = 0;       // position in the consumed block
+    bool   r_owned  = false;   // the consumer holds r_block
+    bool   w_done   = false;   // the helper thread reached the end of the stream
+    bool   w_stop   = false;   // close() was requested
+
+    std::mutex              mtx;
+    std::condition_variable cv_filled;
+    std::condition_variable cv_freed;
+    std::thread             worker;
+
+    void prefetch_loop();
+
+public:
+     stream_prefetch_reader(stream_reader* inner, const size_t block_bytes, const int depth);
+    ~stream_prefetch_reader();
+
+    virtual bool is_open();
+    virtual void close  ();
+    virtual bool is_eof ();
+    virtual int  read   (void* buffer, int eSize, int eCount);
+    virtual size_t read_bytes(void* buffer, size_t n_bytes);
+};
@@ -76,6 +76,19 @@ int  stream_raw_reader::read(void* buffer, int eSize, int eCount)
 //
 //
 //
+size_t stream_raw_reader::read_bytes(void* buffer, size_t n_bytes)
+{
+    const size_t nread = fread(buffer, 1, n_bytes, stream);
+    is_foef            = ( nread != n_bytes);
+    return nread;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
 void stream_raw_reader::close()
 {
     fclose( stream );
@@ -16,4 +16,5 @@ public:
     virtual void close  ();
     virtual bool is_eof ();
     virtual int  read   (void* buffer, int eSize, int eCount);
+    virtual size_t read_bytes(void* buffer, size_t n_bytes);
 };
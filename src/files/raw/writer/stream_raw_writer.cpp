@@ -76,6 +76,28 @@ int stream_raw_writer::write(void* buffer, int eSize, int eCount)
 //
 //
 //
+size_t stream_raw_writer::write_bytes(const void* buffer, size_t n_bytes)
+{
+    const size_t nwrite = fwrite(buffer, 1, n_bytes, stream);
+    if( nwrite != n_bytes )
+    {
+        error_section();
+        printf("(EE) An error occured during the data write task:\n");
+        printf("(EE) - Amount of data to write (bytes)  : %zu\n", n_bytes);
+        printf("(EE) - Amount of written data  (nwrite) : %zu\n", nwrite);
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+    return nwrite;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
 void stream_raw_writer::close()
 {
     fflush( stream );
@@ -13,5 +13,6 @@ public:
 
     virtual bool is_open ();
     virtual int  write  (void* buffer, int eSize, int eCount);
+    virtual size_t write_bytes(const void* buffer, size_t n_bytes);
     virtual void close  ();
 };
@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include "io_limits.hpp"
 
 class stream_reader
 {
@@ -20,4 +22,33 @@ public:
     virtual void close   () = 0;
     virtual bool is_eof  () = 0;
     virtual int  read    (void* buffer, int eSize, int eCount) = 0;
+
+    //
+    // 64-bit API : returns the number of bytes read, less than n_bytes only at the end of
+    // the stream. The default implementation splits the request in int sized read() calls.
+    //
+    virtual size_t read_bytes(void* buffer, size_t n_bytes)
+    {
+        char*  ptr   = (char*)buffer;
+        size_t nread = 0;
+        while( nread < n_bytes )
+        {
+            const int length = (int)std::min(n_bytes - nread, io_max_call_bytes);
+            const int got    = read(ptr + nread, 1, length);
+            if( got <= 0 )
+                break;
+            nread += got;
+            if( got != length )
+                break;
+        }
+        return nread;
+    }
+
+    //
+    // Number of complete elements of eSize bytes that were read
+    //
+    size_t read_elements(void* buffer, size_t eSize, size_t eCount)
+    {
+        return read_bytes(buffer, eSize * eCount) / eSize;
+    }
 };
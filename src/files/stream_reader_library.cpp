@@ -1,8 +1,16 @@
 #include "stream_reader_library.hpp"
+#include <algorithm>
 #include "bz2/reader/stream_bz2_reader.hpp"
 #include "gz/reader/stream_gz_reader.hpp"
 #include "lz4/reader/stream_lz4_reader.hpp"
 #include "raw/reader/stream_raw_reader.hpp"
+#include "prefetch/reader/stream_prefetch_reader.hpp"
+#include "metered/reader/stream_metered_reader.hpp"
+#include "../tools/CMetrics/CMetrics.hpp"
+#if defined(_IO_URING_)
+    #include "uring/reader/stream_uring_lz4_reader.hpp"
+    #include "uring/reader/stream_uring_raw_reader.hpp"
+#endif
 
 stream_reader* stream_reader_library::allocate(const std::string& i_file)
 {
@@ -20,11 +28,19 @@ stream_reader* stream_reader_library::allocate(const std::string& i_file)
     }
     else if (i_file.substr(i_file.find_last_of(".") + 1) == "lz4")
     {
+#if defined(_IO_URING_)
+        reader = new stream_uring_lz4_reader(i_file);
+#else
         reader = new stream_lz4_reader(i_file);
+#endif
     }
     else
     {
+#if defined(_IO_URING_)
+        reader = new stream_uring_raw_reader(i_file);
+#else
         reader = new stream_raw_reader(i_file);
+#endif
     }
 /*
     else
@@ -34,5 +50,31 @@ stream_reader* stream_reader_library::allocate(const std::string& i_file)
         exit( EXIT_FAILURE );
     }
 */
+    //
+    // Comptage des octets et du temps passé dans le flux (fichiers de métriques)
+    //
+    if( CMetrics::enabled() == true )
+        reader = new stream_metered_reader(reader, i_file);
+
     return reader;
 }
+
+stream_reader* stream_reader_library::allocate_prefetch(const std::string& i_file, const int fan_in, const uint64_t ram_budget_MB)
+{
+    stream_reader* reader = allocate( i_file );
+
+    //
+    // Each input gets its share of the budget : depth x block_bytes x fan_in <= budget.
+    // Blocks are shrunk first, then the depth is reduced, down to double buffering.
+    //
+    const uint64_t share = (ram_budget_MB * 1024 * 1024) / std::max(1, fan_in);
+    size_t block_bytes   = stream_prefetch_reader::max_block_bytes;
+    while( (block_bytes > stream_prefetch_reader::min_block_bytes) && (share < 2 * block_bytes) )
+        block_bytes /= 2;
+
+    if( share < 2 * block_bytes )
+        return reader; // not enough memory to read ahead, plain blocking reads
+
+    const int depth = (int)std::min((uint64_t)stream_prefetch_reader::max_depth, share / block_bytes);
+    return new stream_prefetch_reader(reader, block_bytes, depth);
+}
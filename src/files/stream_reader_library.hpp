@@ -5,4 +5,11 @@ class stream_reader_library
 {
 public:
     static stream_reader*  allocate(const std::string& file);
+
+    //
+    // Same as allocate() but the stream is decoded ahead of the consumer on a helper
+    // thread. The read-ahead window of each of the fan_in inputs of a merge is sized
+    // from the memory budget of that merge (falls back to allocate() when too small).
+    //
+    static stream_reader*  allocate_prefetch(const std::string& file, const int fan_in, const uint64_t ram_budget_MB);
 };
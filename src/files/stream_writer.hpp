@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include "io_limits.hpp"
 
 class stream_writer
 {
@@ -17,4 +19,26 @@ public:
     virtual bool is_open() = 0;
     virtual int  write  (void* buffer, const int eSize, const int eCount) = 0;
     virtual void close  () = 0;
+
+    //
+    // 64-bit API : the default implementation splits the request in int sized write() calls
+    // (write errors stop the program, so everything is written when the call returns)
+    //
+    virtual size_t write_bytes(const void* buffer, size_t n_bytes)
+    {
+        char*  ptr     = (char*)buffer;
+        size_t written = 0;
+        while( written < n_bytes )
+        {
+            const int length = (int)std::min(n_bytes - written, io_max_call_bytes);
+            write(ptr + written, 1, length);
+            written += length;
+        }
+        return written;
+    }
+
+    size_t write_elements(const void* buffer, size_t eSize, size_t eCount)
+    {
+        return write_bytes(buffer, eSize * eCount) / eSize;
+    }
 };
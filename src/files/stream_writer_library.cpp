@@ -4,6 +4,12 @@
 #include "bz2/writer/stream_bz2_writer.hpp"
 #include "lz4/writer/stream_lz4_writer.hpp"
 #include "gz/writer/stream_gz_writer.hpp"
+#include "metered/writer/stream_metered_writer.hpp"
+#include "../tools/CMetrics/CMetrics.hpp"
+#if defined(_IO_URING_)
+    #include "uring/writer/stream_uring_lz4_writer.hpp"
+    #include "uring/writer/stream_uring_raw_writer.hpp"
+#endif
 
 stream_writer* stream_writer_library::allocate(const std::string& i_file)
 {
@@ -21,10 +27,18 @@ stream_writer* stream_writer_library::allocate(const std::string& i_file)
     }
     else if (i_file.substr(i_file.find_last_of(".") + 1) == "lz4")
     {
+#if defined(_IO_URING_)
+        writer = new stream_uring_lz4_writer(i_file);
+#else
         writer = new stream_lz4_writer(i_file);
+#endif
     }
     else{
+#if defined(_IO_URING_)
+        writer = new stream_uring_raw_writer(i_file);
+#else
         writer = new stream_raw_writer(i_file);
+#endif
     }
     /*
     else
@@ -34,5 +48,11 @@ stream_writer* stream_writer_library::allocate(const std::string& i_file)
         exit( EXIT_FAILURE );
     }*/
 
+    //
+    // Comptage des octets et du temps passé dans le flux (fichiers de métriques)
+    //
+    if( CMetrics::enabled() == true )
+        writer = new stream_metered_writer(writer, i_file);
+
     return writer;
 }
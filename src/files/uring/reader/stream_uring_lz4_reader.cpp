@@ -0,0 +1,123 @@
+#include "stream_uring_lz4_reader.hpp"
+#include "../../../tools/colors.hpp"
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_uring_lz4_reader::stream_uring_lz4_reader(const std::string& filen)
+{
+    file = new uring_file_reader(filen, uring_settings::block_bytes, uring_settings::depth, uring_settings::direct);
+
+    const LZ4F_errorCode_t ret = LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+    if (LZ4F_isError(ret)) {
+        printf("(EE) LZ4F_createDecompressionContext error: %s\n", LZ4F_getErrorName(ret));
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        exit( EXIT_FAILURE );
+    }
+    is_fopen = true; // file
+    is_foef  = false;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_uring_lz4_reader::~stream_uring_lz4_reader()
+{
+    if( is_open() == true )
+        close();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool stream_uring_lz4_reader::is_open ()
+{
+    return is_fopen;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool stream_uring_lz4_reader::is_eof()
+{
+    return is_foef;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+int  stream_uring_lz4_reader::read(void* buffer, int eSize, int eCount)
+{
+    return read_bytes(buffer, (size_t)eSize * eCount) / eSize; // nombre d'éléments lu et NON PAS le nombre de bytes !
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+size_t stream_uring_lz4_reader::read_bytes(void* buffer, size_t length)
+{
+    char*  dst   = (char*)buffer;
+    size_t nread = 0;
+
+    while( nread < length )
+    {
+        const char* src;
+        size_t      avail;
+        if( file->peek(&src, &avail) == false )
+            break; // fin du fichier compressé
+
+        size_t dst_size = length - nread;
+        size_t src_size = avail;
+        const size_t ret = LZ4F_decompress(dctx, dst + nread, &dst_size, src, &src_size, NULL);
+        if (LZ4F_isError(ret)) {
+            error_section();
+            printf("(EE) LZ4F_decompress error: %s\n", LZ4F_getErrorName(ret));
+            printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+            reset_section();
+            exit( EXIT_FAILURE );
+        }
+        file->consume( src_size );
+        nread += dst_size; // ret == 0 : fin de trame, le contexte repart sur la trame suivante
+    }
+
+    is_foef |= ( length != nread ); // a t'on atteint la fin du fichier ?
+    return nread;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void stream_uring_lz4_reader::close()
+{
+    LZ4F_freeDecompressionContext(dctx);
+    delete file;
+    is_fopen = false;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
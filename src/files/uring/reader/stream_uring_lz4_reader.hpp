@@ -0,0 +1,26 @@
+#pragma once
+#include "../../stream_reader.hpp"
+#include "../uring_file.hpp"
+#include "../../../front/fastx_lz4/lz4/lz4frame.h"
+
+//
+// LZ4 frame decoder fed directly from the blocks of the io_uring reader (no intermediate
+// copy of the compressed data). Concatenated frames are decoded one after the other, like
+// LZ4F_read does for the stdio reader.
+//
+class stream_uring_lz4_reader : public stream_reader
+{
+private:
+    uring_file_reader* file;
+    LZ4F_dctx*         dctx;
+
+public:
+     stream_uring_lz4_reader(const std::string& filen);
+    ~stream_uring_lz4_reader();
+
+    virtual bool is_open();
+    virtual void close  ();
+    virtual bool is_eof ();
+    virtual int  read   (void* buffer, int eSize, int eCount);
+    virtual size_t read_bytes(void* buffer, size_t n_bytes);
+};
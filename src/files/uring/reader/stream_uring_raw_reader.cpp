@@ -0,0 +1,92 @@
+#include "stream_uring_raw_reader.hpp"
+#include "../../../tools/colors.hpp"
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_uring_raw_reader::stream_uring_raw_reader(const std::string& filen)
+{
+    file     = new uring_file_reader(filen, uring_settings::block_bytes, uring_settings::depth, uring_settings::direct);
+    is_fopen = true;
+    is_foef  = false;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_uring_raw_reader::~stream_uring_raw_reader()
+{
+    if( is_open() == true )
+        close();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool stream_uring_raw_reader::is_open ()
+{
+    return is_fopen;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool stream_uring_raw_reader::is_eof()
+{
+    return is_foef;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+int  stream_uring_raw_reader::read(void* buffer, int eSize, int eCount)
+{
+    return read_bytes(buffer, (size_t)eSize * eCount) / eSize; // nombre d'éléments de taille eSize
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+size_t stream_uring_raw_reader::read_bytes(void* buffer, size_t n_bytes)
+{
+    const size_t nread = file->read(buffer, n_bytes);
+    is_foef            = ( nread != n_bytes); // a t'on atteint la fin du fichier ?
+    return nread;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void stream_uring_raw_reader::close()
+{
+    delete file;
+    is_fopen = false;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
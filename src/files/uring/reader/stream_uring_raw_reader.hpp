@@ -0,0 +1,19 @@
+#pragma once
+#include "../../stream_reader.hpp"
+#include "../uring_file.hpp"
+
+class stream_uring_raw_reader : public stream_reader
+{
+private:
+    uring_file_reader* file;
+
+public:
+     stream_uring_raw_reader(const std::string& filen);
+    ~stream_uring_raw_reader();
+
+    virtual bool is_open();
+    virtual void close  ();
+    virtual bool is_eof ();
+    virtual int  read   (void* buffer, int eSize, int eCount);
+    virtual size_t read_bytes(void* buffer, size_t n_bytes);
+};
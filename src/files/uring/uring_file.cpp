@@ -0,0 +1,398 @@
+#include "uring_file.hpp"
+#include "../../tools/colors.hpp"
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const size_t uring_alignment = 4096;
+
+size_t uring_settings::block_bytes = 256 * 1024;
+int    uring_settings::depth       = 4;
+bool   uring_settings::direct      = false;
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+static int open_file(const std::string& filen, int flags, const bool direct)
+{
+#if defined(O_DIRECT)
+    //
+    // Certains systèmes de fichiers (tmpfs, ...) refusent O_DIRECT, on repasse alors par le cache
+    //
+    if( direct )
+    {
+        const int fd = open(filen.c_str(), flags | O_DIRECT, 0644);
+        if( (fd >= 0) || (errno != EINVAL) )
+            return fd;
+    }
+#endif
+    (void)direct;
+    return open(filen.c_str(), flags, 0644);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+static char* aligned_block(const size_t block_bytes)
+{
+    char* ptr = (char*)std::aligned_alloc(uring_alignment, block_bytes);
+    if( ptr == nullptr )
+    {
+        error_section();
+        printf("(EE) Unable to allocate an I/O block (%zu bytes)\n", block_bytes);
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+    return ptr;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uring_file_reader::uring_file_reader(const std::string& filen, const size_t _block_bytes, const int depth, const bool direct)
+    : queue(depth), block_bytes( (_block_bytes + uring_alignment - 1) / uring_alignment * uring_alignment ), name(filen)
+{
+    fd = open_file(filen, O_RDONLY, direct);
+    if( fd < 0 )
+    {
+        printf("(EE) File does not exist (%s))\n", filen.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        exit( EXIT_FAILURE );
+    }
+
+    struct stat file_status;
+    fstat(fd, &file_status);
+    file_size = file_status.st_size;
+
+    blocks.resize( depth );
+    for(size_t i = 0; i < blocks.size(); i += 1)
+    {
+        blocks[i].data = aligned_block( block_bytes );
+        if( next_offset < file_size )
+            issue( blocks[i] );
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uring_file_reader::~uring_file_reader()
+{
+    close();
+    for(size_t i = 0; i < blocks.size(); i += 1)
+        std::free( blocks[i].data );
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_file_reader::issue(block& b)
+{
+    //
+    // On demande toujours un bloc complet (aligné pour O_DIRECT), la fin de fichier tronque la lecture
+    //
+    b.offset     = next_offset;
+    b.size       = std::min((uint64_t)block_bytes, file_size - next_offset);
+    b.active     = true;
+    next_offset += block_bytes;
+    queue.read(fd, b.data, block_bytes, b.offset, &b.req);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_file_reader::complete(block& b)
+{
+    queue.wait( &b.req );
+    int64_t done = b.req.result;
+
+    //
+    // Une lecture courte hors fin de fichier reste possible, on complete le bloc de maniere synchrone
+    //
+    while( (done >= 0) && ((size_t)done < b.size) )
+    {
+        const ssize_t n = pread(fd, b.data + done, b.size - done, b.offset + done);
+        if( n <= 0 ) { done = (n < 0) ? -errno : -EIO; break; }
+        done += n;
+    }
+
+    if( done < 0 )
+    {
+        error_section();
+        printf("(EE) An error occured while reading (%s): %s\n", name.c_str(), strerror(-done));
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool uring_file_reader::peek(const char** data, size_t* size)
+{
+    block& b = blocks[head];
+    if( b.active == false )
+        return false; // fin de fichier
+
+    if( ready == false )
+    {
+        complete( b );
+        ready = true;
+    }
+    *data = b.data + pos;
+    *size = b.size - pos;
+    return true;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_file_reader::consume(const size_t n)
+{
+    block& b = blocks[head];
+    pos += n;
+    if( pos != b.size )
+        return;
+
+    //
+    // Le bloc est épuisé, on le recycle pour la suite du fichier
+    //
+    pos      = 0;
+    ready    = false;
+    b.active = false;
+    if( next_offset < file_size )
+        issue( b );
+    head = (head + 1) % blocks.size();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+size_t uring_file_reader::read(void* buffer, const size_t n)
+{
+    char*  dst    = (char*)buffer;
+    size_t copied = 0;
+    while( copied < n )
+    {
+        const char* src;
+        size_t      avail;
+        if( peek(&src, &avail) == false )
+            break;
+        const size_t len = std::min(avail, n - copied);
+        memcpy(dst + copied, src, len);
+        consume( len );
+        copied += len;
+    }
+    return copied;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_file_reader::close()
+{
+    if( fd < 0 )
+        return;
+    queue.wait_all();
+    ::close( fd );
+    fd = -1;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uring_file_writer::uring_file_writer(const std::string& filen, const size_t _block_bytes, const int depth, const bool _direct)
+    : queue(depth), block_bytes( (_block_bytes + uring_alignment - 1) / uring_alignment * uring_alignment ), name(filen)
+{
+    fd = open_file(filen, O_WRONLY | O_CREAT | O_TRUNC, _direct);
+    if( fd < 0 )
+    {
+        error_section();
+        printf("(EE) It is impossible to create the file (%s))\n", filen.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+#if defined(O_DIRECT)
+    direct = (fcntl(fd, F_GETFL) & O_DIRECT) != 0;
+#else
+    direct = false;
+#endif
+
+    blocks.resize( depth );
+    for(size_t i = 0; i < blocks.size(); i += 1)
+        blocks[i].data = aligned_block( block_bytes );
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uring_file_writer::~uring_file_writer()
+{
+    close();
+    for(size_t i = 0; i < blocks.size(); i += 1)
+        std::free( blocks[i].data );
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_file_writer::issue(block& b)
+{
+    //
+    // Avec O_DIRECT seul le dernier bloc peut être partiel, il est complété par des zéros et
+    // le fichier est tronqué à sa taille réelle lors de la fermeture
+    //
+    b.length = b.size;
+    if( direct && (b.size % uring_alignment) != 0 )
+    {
+        b.length = (b.size + uring_alignment - 1) / uring_alignment * uring_alignment;
+        memset(b.data + b.size, 0, b.length - b.size);
+    }
+    b.offset     = next_offset;
+    b.active     = true;
+    next_offset += b.size;
+    queue.write(fd, b.data, b.length, b.offset, &b.req);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_file_writer::complete(block& b)
+{
+    if( b.active == false )
+        return;
+    queue.wait( &b.req );
+    int64_t done = b.req.result;
+
+    while( (done >= 0) && ((size_t)done < b.length) )
+    {
+        const ssize_t n = pwrite(fd, b.data + done, b.length - done, b.offset + done);
+        if( n <= 0 ) { done = (n < 0) ? -errno : -EIO; break; }
+        done += n;
+    }
+
+    if( done < 0 )
+    {
+        error_section();
+        printf("(EE) An error occured during the data write task (%s): %s\n", name.c_str(), strerror(-done));
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+    b.active = false;
+    b.size   = 0;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_file_writer::write(const void* buffer, const size_t n)
+{
+    const char* src  = (const char*)buffer;
+    size_t      left = n;
+    while( left != 0 )
+    {
+        block& b = blocks[curr];
+        if( b.active )
+            complete( b ); // le bloc est encore en cours d'écriture
+
+        const size_t len = std::min(left, block_bytes - b.size);
+        memcpy(b.data + b.size, src, len);
+        b.size += len;
+        src    += len;
+        left   -= len;
+
+        if( b.size == block_bytes )
+        {
+            issue( b );
+            curr = (curr + 1) % blocks.size();
+        }
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_file_writer::close()
+{
+    if( fd < 0 )
+        return;
+
+    block& b = blocks[curr];
+    if( (b.active == false) && (b.size != 0) )
+        issue( b );
+    for(size_t i = 0; i < blocks.size(); i += 1)
+        complete( blocks[i] );
+
+    if( direct && (ftruncate(fd, next_offset) != 0) )
+    {
+        error_section();
+        printf("(EE) Unable to set the final size of the file (%s)\n", name.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+    ::close( fd );
+    fd = -1;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
@@ -0,0 +1,91 @@
+#pragma once
+#include "uring_queue.hpp"
+#include <string>
+#include <vector>
+
+//
+// Process-wide parameters of the io_uring streams (set once, before the first file is opened)
+//
+struct uring_settings
+{
+    static size_t block_bytes; // size of one in-flight request
+    static int    depth;       // requests kept in flight per stream
+    static bool   direct;      // bypass the page cache (O_DIRECT) when the file system allows it
+};
+
+//
+// Sequential reader that keeps `depth` block reads in flight on its own io_uring.
+// Blocks are page-aligned so the file can be opened with O_DIRECT.
+//
+class uring_file_reader
+{
+private:
+    struct block
+    {
+        char*         data   = nullptr;
+        size_t        size   = 0;      // bytes expected for the block
+        uint64_t      offset = 0;
+        bool          active = false;  // a read was issued for the block
+        uring_request req;
+    };
+
+    uring_queue        queue;
+    int                fd;
+    uint64_t           file_size;
+    uint64_t           next_offset = 0;
+    const size_t       block_bytes;
+    std::vector<block> blocks;
+    size_t             head = 0;  // block being consumed
+    size_t             pos  = 0;  // bytes consumed in the head block
+    bool               ready = false;
+    std::string        name;
+
+    void issue   (block& b);
+    void complete(block& b);
+
+public:
+     uring_file_reader(const std::string& filen, const size_t block_bytes, const int depth, const bool direct);
+    ~uring_file_reader();
+
+    bool   peek   (const char** data, size_t* size); // bytes available in the current block
+    void   consume(const size_t n);
+    size_t read   (void* buffer, const size_t n);
+    void   close  ();
+};
+
+//
+// Sequential writer, full blocks are written behind the producer while the next ones are
+// being filled.
+//
+class uring_file_writer
+{
+private:
+    struct block
+    {
+        char*         data   = nullptr;
+        size_t        size   = 0;      // bytes stored in the block
+        size_t        length = 0;      // bytes submitted (padded with O_DIRECT)
+        uint64_t      offset = 0;
+        bool          active = false;  // a write was issued for the block
+        uring_request req;
+    };
+
+    uring_queue        queue;
+    int                fd;
+    bool               direct;
+    uint64_t           next_offset = 0;
+    const size_t       block_bytes;
+    std::vector<block> blocks;
+    size_t             curr = 0;
+    std::string        name;
+
+    void issue   (block& b);
+    void complete(block& b);
+
+public:
+     uring_file_writer(const std::string& filen, const size_t block_bytes, const int depth, const bool direct);
+    ~uring_file_writer();
+
+    void write(const void* buffer, const size_t n);
+    void close();
+};
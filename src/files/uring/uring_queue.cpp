@@ -0,0 +1,294 @@
+#include "uring_queue.hpp"
+#include "../../tools/colors.hpp"
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+static int64_t sync_transfer(const bool is_read, const int fd, void* buffer, const size_t length, const uint64_t offset)
+{
+    const ssize_t n = is_read ? pread (fd, buffer, length, offset)
+                              : pwrite(fd, buffer, length, offset);
+    return (n < 0) ? -errno : n;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+//
+// IORING_OP_READ/WRITE only exist since Linux 5.6, as the probe : on 5.1-5.5 the ring is
+// created but these requests complete with -EINVAL, the probe fails there too
+//
+static bool supports_read_write(const int ring_fd)
+{
+    const size_t n_ops = 256;
+    std::vector<uint8_t> storage( sizeof(io_uring_probe) + n_ops * sizeof(io_uring_probe_op), 0 );
+    io_uring_probe* probe = (io_uring_probe*)storage.data();
+    if( syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, n_ops) < 0 )
+        return false;
+    for(const int op : { IORING_OP_READ, IORING_OP_WRITE })
+    {
+        if( (op > probe->last_op) || ((probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) )
+            return false;
+    }
+    return true;
+}
+#endif
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uring_queue::uring_queue(const unsigned depth)
+{
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd = syscall(__NR_io_uring_setup, depth, &params);
+    if( ring_fd < 0 )
+    {
+        ring_fd = -1; // io_uring is not available, pread/pwrite are used instead
+        return;
+    }
+    sq_entries = params.sq_entries;
+
+    sq_bytes  = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_bytes  = params.cq_off.cqes  + params.cq_entries * sizeof(io_uring_cqe);
+    sqe_bytes = params.sq_entries   * sizeof(io_uring_sqe);
+
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if( single_mmap )
+        sq_bytes = cq_bytes = (sq_bytes > cq_bytes) ? sq_bytes : cq_bytes;
+
+    sq_ptr  = mmap(0, sq_bytes,  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    cq_ptr  = single_mmap ? sq_ptr
+                          : mmap(0, cq_bytes,  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    sqe_ptr = mmap(0, sqe_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if( (sq_ptr == MAP_FAILED) || (cq_ptr == MAP_FAILED) || (sqe_ptr == MAP_FAILED) || (supports_read_write(ring_fd) == false) )
+    {
+        if( sqe_ptr != MAP_FAILED ) munmap(sqe_ptr, sqe_bytes);
+        if( (cq_ptr != MAP_FAILED) && (cq_ptr != sq_ptr) ) munmap(cq_ptr, cq_bytes);
+        if( sq_ptr  != MAP_FAILED ) munmap(sq_ptr, sq_bytes);
+        sq_ptr = cq_ptr = sqe_ptr = nullptr;
+        close( ring_fd );
+        ring_fd = -1;
+        return;
+    }
+
+    char* sq = (char*)sq_ptr;
+    char* cq = (char*)cq_ptr;
+    sq_head  = (unsigned*)(sq + params.sq_off.head);
+    sq_tail  = (unsigned*)(sq + params.sq_off.tail);
+    sq_mask  = (unsigned*)(sq + params.sq_off.ring_mask);
+    sq_array = (unsigned*)(sq + params.sq_off.array);
+    cq_head  = (unsigned*)(cq + params.cq_off.head);
+    cq_tail  = (unsigned*)(cq + params.cq_off.tail);
+    cq_mask  = (unsigned*)(cq + params.cq_off.ring_mask);
+    cqes     = (void*)    (cq + params.cq_off.cqes);
+#else
+    (void)depth;
+#endif
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uring_queue::~uring_queue()
+{
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+    if( ring_fd < 0 )
+        return;
+    wait_all();
+    munmap(sqe_ptr, sqe_bytes);
+    if( cq_ptr != sq_ptr )
+        munmap(cq_ptr, cq_bytes);
+    munmap(sq_ptr, sq_bytes);
+    close( ring_fd );
+#endif
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_queue::enter(const unsigned to_submit, const unsigned min_complete)
+{
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+    const unsigned flags = (min_complete != 0) ? IORING_ENTER_GETEVENTS : 0;
+    while( syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0) < 0 )
+    {
+        if( (errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY) )
+            continue;
+        error_section();
+        printf("(EE) io_uring_enter failed (%s)\n", strerror(errno));
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+#else
+    (void)to_submit; (void)min_complete;
+#endif
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_queue::reap()
+{
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+    unsigned head = *cq_head;
+    while( head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) )
+    {
+        const io_uring_cqe* cqe = (const io_uring_cqe*)cqes + (head & *cq_mask);
+        uring_request*      req = (uring_request*)cqe->user_data;
+        req->result  = cqe->res;
+        req->pending = false;
+        n_in_flight -= 1;
+        head        += 1;
+    }
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+#endif
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_queue::submit(const int opcode, const int fd, void* buffer, const size_t length, const uint64_t offset, uring_request* req)
+{
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+    //
+    // On garde au plus sq_entries requêtes en vol pour ne jamais déborder la file de complétion
+    //
+    while( n_in_flight >= sq_entries )
+    {
+        reap();
+        if( n_in_flight >= sq_entries )
+            enter(0, 1);
+    }
+
+    const unsigned tail  = *sq_tail;
+    const unsigned index = tail & *sq_mask;
+    io_uring_sqe*  sqe   = (io_uring_sqe*)sqe_ptr + index;
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode    = opcode;
+    sqe->fd        = fd;
+    sqe->addr      = (uint64_t)buffer;
+    sqe->len       = length;
+    sqe->off       = offset;
+    sqe->user_data = (uint64_t)req;
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    req->pending = true;
+    n_in_flight += 1;
+    enter(1, 0);
+#else
+    (void)opcode; (void)fd; (void)buffer; (void)length; (void)offset; (void)req;
+#endif
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_queue::read(const int fd, void* buffer, const size_t length, const uint64_t offset, uring_request* req)
+{
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+    if( ring_fd >= 0 )
+    {
+        submit(IORING_OP_READ, fd, buffer, length, offset, req);
+        return;
+    }
+#endif
+    req->result  = sync_transfer(true, fd, buffer, length, offset);
+    req->pending = false;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_queue::write(const int fd, const void* buffer, const size_t length, const uint64_t offset, uring_request* req)
+{
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+    if( ring_fd >= 0 )
+    {
+        submit(IORING_OP_WRITE, fd, (void*)buffer, length, offset, req);
+        return;
+    }
+#endif
+    req->result  = sync_transfer(false, fd, (void*)buffer, length, offset);
+    req->pending = false;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_queue::wait(uring_request* req)
+{
+    while( req->pending )
+    {
+        reap();
+        if( req->pending )
+            enter(0, 1);
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void uring_queue::wait_all()
+{
+    while( n_in_flight != 0 )
+    {
+        reap();
+        if( n_in_flight != 0 )
+            enter(0, 1);
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+
+//
+// Completion slot of an asynchronous request. The caller owns it and must keep it alive
+// (and not reuse it) until uring_queue::wait() returned for it.
+//
+struct uring_request
+{
+    int64_t result  = 0;     // number of bytes transferred or -errno
+    bool    pending = false;
+};
+
+//
+// Minimal io_uring submission/completion queue built on the raw system calls (no liburing
+// dependency). When the kernel does not provide io_uring or its read/write requests (before
+// Linux 5.6, seccomp, non Linux system) the requests are served synchronously with pread/pwrite.
+//
+class uring_queue
+{
+private:
+    int       ring_fd     = -1;
+    unsigned  sq_entries  = 0;
+    unsigned  n_in_flight = 0;   // submitted requests whose completion was not reaped yet
+
+    void*     sq_ptr      = nullptr;
+    size_t    sq_bytes    = 0;
+    void*     cq_ptr      = nullptr;
+    size_t    cq_bytes    = 0;
+    void*     sqe_ptr     = nullptr;
+    size_t    sqe_bytes   = 0;
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    void*     cqes;
+
+    void submit (const int opcode, const int fd, void* buffer, const size_t length, const uint64_t offset, uring_request* req);
+    void enter  (const unsigned to_submit, const unsigned min_complete);
+    void reap   ();
+
+public:
+     uring_queue(const unsigned depth);
+    ~uring_queue();
+
+    bool is_uring() const { return ring_fd >= 0; }
+
+    void read    (const int fd, void*       buffer, const size_t length, const uint64_t offset, uring_request* req);
+    void write   (const int fd, const void* buffer, const size_t length, const uint64_t offset, uring_request* req);
+    void wait    (uring_request* req);
+    void wait_all();
+};
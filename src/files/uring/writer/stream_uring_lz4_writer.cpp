@@ -0,0 +1,122 @@
+#include "stream_uring_lz4_writer.hpp"
+#include "../../../tools/colors.hpp"
+#include <algorithm>
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_uring_lz4_writer::stream_uring_lz4_writer(const std::string& filen)
+{
+    file = new uring_file_writer(filen, uring_settings::block_bytes, uring_settings::depth, uring_settings::direct);
+
+    //
+    // Ouverture du flux compréssé avec les parametres par défaut
+    //
+    check( LZ4F_createCompressionContext(&cctx, LZ4F_VERSION), __LINE__ );
+    dst_bytes = LZ4F_compressBound(chunk_bytes, NULL);
+    dst       = new char[dst_bytes];
+
+    const size_t header = LZ4F_compressBegin(cctx, dst, dst_bytes, NULL);
+    check( header, __LINE__ );
+    file->write(dst, header);
+    is_fopen = true;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_uring_lz4_writer::~stream_uring_lz4_writer()
+{
+    if( is_open() == true )
+        close();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void stream_uring_lz4_writer::check(const size_t ret, const int line)
+{
+    if (LZ4F_isError(ret)) {
+        error_section();
+        printf("(EE) An error occured during the LZ4 compression task: %s\n", LZ4F_getErrorName(ret));
+        printf("(EE) Error location : %s %d\n", __FILE__, line);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool stream_uring_lz4_writer::is_open ()
+{
+    return is_fopen;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+int stream_uring_lz4_writer::write(void* buffer, int eSize, int eCount)
+{
+    write_bytes(buffer, (size_t)eSize * eCount);
+    return eCount; // nombre d'éléments de taille eSize
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+size_t stream_uring_lz4_writer::write_bytes(const void* buffer, size_t length)
+{
+    const char* src = (const char*)buffer;
+    for(size_t i = 0; i < length; i += chunk_bytes)
+    {
+        const size_t n    = std::min(chunk_bytes, length - i);
+        const size_t size = LZ4F_compressUpdate(cctx, dst, dst_bytes, src + i, n, NULL);
+        check( size, __LINE__ );
+        file->write(dst, size);
+    }
+    return length;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void stream_uring_lz4_writer::close()
+{
+    const size_t size = LZ4F_compressEnd(cctx, dst, dst_bytes, NULL);
+    check( size, __LINE__ );
+    file->write(dst, size);
+
+    LZ4F_freeCompressionContext(cctx);
+    delete[] dst;
+    delete file;
+    is_fopen = false;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
@@ -0,0 +1,30 @@
+#pragma once
+#include "../../stream_writer.hpp"
+#include "../uring_file.hpp"
+#include "../../../front/fastx_lz4/lz4/lz4frame.h"
+
+//
+// LZ4 frame encoder (same frame parameters as LZ4F_writeOpen with default preferences) whose
+// compressed blocks are handed to the io_uring writer
+//
+class stream_uring_lz4_writer : public stream_writer
+{
+private:
+    static constexpr size_t chunk_bytes = 64 * 1024;
+
+    uring_file_writer* file;
+    LZ4F_cctx*         cctx;
+    char*              dst;
+    size_t             dst_bytes;
+
+    void check(const size_t ret, const int line);
+
+public:
+     stream_uring_lz4_writer(const std::string& filen);
+    ~stream_uring_lz4_writer();
+
+    virtual bool is_open();
+    virtual int  write  (void* buffer, int eSize, int eCount);
+    virtual size_t write_bytes(const void* buffer, size_t n_bytes);
+    virtual void close  ();
+};
@@ -0,0 +1,80 @@
+#include "stream_uring_raw_writer.hpp"
+#include "../../../tools/colors.hpp"
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_uring_raw_writer::stream_uring_raw_writer(const std::string& filen)
+{
+    file     = new uring_file_writer(filen, uring_settings::block_bytes, uring_settings::depth, uring_settings::direct);
+    is_fopen = true;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+stream_uring_raw_writer::~stream_uring_raw_writer()
+{
+    if( is_open() == true )
+        close();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool stream_uring_raw_writer::is_open ()
+{
+    return is_fopen;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+int stream_uring_raw_writer::write(void* buffer, int eSize, int eCount)
+{
+    file->write(buffer, (size_t)eSize * eCount);
+    return eCount; // nombre d'éléments de taille eSize
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+size_t stream_uring_raw_writer::write_bytes(const void* buffer, size_t n_bytes)
+{
+    file->write(buffer, n_bytes);
+    return n_bytes;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void stream_uring_raw_writer::close()
+{
+    delete file;
+    is_fopen = false;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
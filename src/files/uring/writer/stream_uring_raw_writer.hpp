@@ -0,0 +1,18 @@
+#pragma once
+#include "../../stream_writer.hpp"
+#include "../uring_file.hpp"
+
+class stream_uring_raw_writer : public stream_writer
+{
+private:
+    uring_file_writer* file;
+
+public:
+     stream_uring_raw_writer(const std::string& filen);
+    ~stream_uring_raw_writer();
+
+    virtual bool is_open();
+    virtual int  write  (void* buffer, int eSize, int eCount);
+    virtual size_t write_bytes(const void* buffer, size_t n_bytes);
+    virtual void close  ();
+};
@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <tuple>
 #include <string>
 #include <vector>
 #include <zlib.h>
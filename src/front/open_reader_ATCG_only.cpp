@@ -0,0 +1,29 @@
+#include "./open_reader_ATCG_only.hpp"
+#include "./fastx/read_fastx_ATCG_only.hpp"
+#include "./fastx_gz/read_fastx_gz_ATCG_only.hpp"
+#include "./fastx_bz2/read_fastx_bz2_ATCG_only.hpp"
+#include "./fastx_lz4/read_fastx_lz4_ATCG_only.hpp"
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+file_reader_ATCG_only* open_reader_ATCG_only(const std::string& filen, const uint64_t buff_size)
+{
+    const std::string ext = filen.substr(filen.find_last_of(".") + 1);
+    if( ext == "bz2" ) return new read_fastx_bz2_ATCG_only(filen, buff_size);
+    if( ext == "gz"  ) return new read_fastx_gz_ATCG_only (filen, buff_size);
+    if( ext == "lz4" ) return new read_fastx_lz4_ATCG_only(filen, buff_size);
+    if( (ext == "fastx") || (ext == "fasta") || (ext == "fastq") || (ext == "fna") )
+        return new read_fastx_ATCG_only(filen, buff_size);
+    return nullptr;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
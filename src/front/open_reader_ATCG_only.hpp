@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "./file_reader_ATCG_only.hpp"
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+//
+// Sequence reader selected from the extension of the file (bz2, gz, lz4 or a plain
+// fastx/fasta/fastq/fna file), nullptr when the extension is not supported
+//
+extern file_reader_ATCG_only* open_reader_ATCG_only(const std::string& filen, const uint64_t buff_size);
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
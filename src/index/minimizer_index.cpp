@@ -0,0 +1,336 @@
+#include "minimizer_index.hpp"
+#include "tier_stream.hpp"
+#include "../merger/hybrid/color_row.hpp"
+#include "../files/stream_writer_library.hpp"
+#include "../front/fastx_lz4/lz4/lz4.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+//
+// Footer : [table offset][blocks][rows][policy ...][magic]
+//
+static bool write_footer(FILE* f, const uint64_t table, const uint64_t n_blocks, const uint64_t n_rows, const tier_policy& p)
+{
+    const uint64_t footer[INDEX_FOOTER] = {
+        table, n_blocks, n_rows,
+        p.n_colors, p.level_1, p.bitmap_words, p.sparse_bits,
+        p.sparse_max, p.delta_max, p.complement_min, (uint64_t)p.sparse_vbyte,
+        INDEX_MAGIC
+    };
+    return fwrite(footer, sizeof(uint64_t), INDEX_FOOTER, f) == INDEX_FOOTER;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+minimizer_index_writer::minimizer_index_writer(const std::string& filen, const tier_policy& i_policy, const uint64_t block_bytes)
+    : filename   ( filen    ),
+      policy     ( i_policy ),
+      block_words( std::max((uint64_t)512, block_bytes / sizeof(uint64_t)) )
+{
+    file = fopen(filen.c_str(), "wb");
+    if( file == NULL )
+        throw std::runtime_error("Cannot open index: " + filen);
+}
+
+//
+// close() may throw, it is never called from here : a writer that was not closed
+// left an incomplete index behind, which is removed
+//
+minimizer_index_writer::~minimizer_index_writer()
+{
+    if( file == nullptr )
+        return;
+    fclose( file );
+    std::remove( filename.c_str() );
+}
+
+void minimizer_index_writer::add(const uint64_t minimizer, const int tier, const uint64_t* payload, const uint64_t n_words)
+{
+    if( (n_rows != 0) && (minimizer <= last) )
+        throw std::runtime_error("Index rows are not in increasing minimizer order");
+    last = minimizer;
+
+    keys    .push_back( minimizer );
+    offsets .push_back( payloads.size() | ((uint64_t)tier << 56) );
+    payloads.insert(payloads.end(), payload, payload + n_words);
+    n_rows += 1;
+
+    if( 2 + 2 * keys.size() + payloads.size() >= block_words )
+        flush_block();
+}
+
+void minimizer_index_writer::flush_block()
+{
+    const uint64_t n = keys.size();
+    if( n == 0 )
+        return;
+
+    raw.clear();
+    raw.push_back( n );
+    raw.insert(raw.end(), keys   .begin(), keys   .end());
+    raw.insert(raw.end(), offsets.begin(), offsets.end());
+    raw.push_back( payloads.size() );
+    raw.insert(raw.end(), payloads.begin(), payloads.end());
+
+    const int src_bytes = raw.size() * sizeof(uint64_t);
+    packed.resize( LZ4_compressBound(src_bytes) );
+    const int bytes = LZ4_compress_default((const char*)raw.data(), packed.data(), src_bytes, packed.size());
+    if( bytes <= 0 )
+        throw std::runtime_error("LZ4 compression of an index block failed");
+    if( fwrite(packed.data(), 1, bytes, file) != (size_t)bytes )
+        throw std::runtime_error("Cannot write an index block");
+
+    fences.push_back( {keys[0], position, (uint64_t)bytes, raw.size()} );
+    position += bytes;
+
+    keys    .clear();
+    offsets .clear();
+    payloads.clear();
+}
+
+void minimizer_index_writer::close()
+{
+    if( file == nullptr )
+        return;
+    flush_block();
+    const bool ok_table  = fwrite(fences.data(), sizeof(index_fence), fences.size(), file) == fences.size();
+    const bool ok_footer = write_footer(file, position, fences.size(), n_rows, policy);
+    const bool ok_close  = fclose( file ) == 0;
+    file = nullptr;
+    if( (ok_table && ok_footer && ok_close) == false )
+    {
+        std::remove( filename.c_str() );
+        throw std::runtime_error("Cannot write the index footer: " + filename);
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t build_minimizer_index(const std::vector<std::string>& files, const tier_policy& policy, const std::string& index_file)
+{
+    std::vector<std::unique_ptr<tier_stream>> streams;
+    for(int t = 0; t < (int)files.size(); t += 1)
+        if( files[t].empty() == false )
+            streams.emplace_back( new tier_stream(files[t], t, policy) );
+
+    //
+    // The tier files hold disjoint minimizers, at most 4 of them : linear search of the smallest
+    //
+    minimizer_index_writer writer(index_file, policy);
+    while( true )
+    {
+        tier_stream* best = nullptr;
+        for(auto& s : streams)
+            if( s->valid && ((best == nullptr) || (s->minimizer() < best->minimizer())) )
+                best = s.get();
+        if( best == nullptr )
+            break;
+        writer.add(best->minimizer(), best->tier, best->payload(), best->words);
+        best->next();
+    }
+    writer.close();
+    return writer.rows();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+minimizer_index::minimizer_index(const std::string& filen)
+{
+    fd = open(filen.c_str(), O_RDONLY);
+    struct stat st;
+    if( (fd < 0) || (fstat(fd, &st) != 0) || ((uint64_t)st.st_size < INDEX_FOOTER * sizeof(uint64_t)) )
+        throw std::runtime_error("Cannot open index: " + filen);
+
+    uint64_t footer[INDEX_FOOTER];
+    if( pread(fd, footer, sizeof(footer), st.st_size - sizeof(footer)) != (ssize_t)sizeof(footer) || (footer[INDEX_FOOTER - 1] != INDEX_MAGIC) )
+        throw std::runtime_error("Not a minimizer index: " + filen);
+
+    const uint64_t table    = footer[0];
+    const uint64_t n_blocks = footer[1];
+    n_rows                  = footer[2];
+    policy.n_colors         = footer[3];
+    policy.level_1          = footer[4];
+    policy.bitmap_words     = footer[5];
+    policy.sparse_bits      = footer[6];
+    policy.sparse_max       = footer[7];
+    policy.delta_max        = footer[8];
+    policy.complement_min   = footer[9];
+    policy.sparse_vbyte     = (footer[10] != 0);
+
+    fences.resize( n_blocks );
+    const ssize_t table_bytes = n_blocks * sizeof(index_fence);
+    if( pread(fd, fences.data(), table_bytes, table) != table_bytes )
+        throw std::runtime_error("Cannot read the fence table of: " + filen);
+}
+
+minimizer_index::~minimizer_index()
+{
+    if( fd >= 0 )
+        ::close( fd );
+}
+
+void minimizer_index::load(const uint64_t b)
+{
+    if( loaded == b )
+        return;
+    const index_fence& f = fences[b];
+    packed.resize( f.bytes );
+    block .resize( f.words );
+    if( pread(fd, packed.data(), f.bytes, f.offset) != (ssize_t)f.bytes )
+        throw std::runtime_error("Cannot read an index block");
+    const int got = LZ4_decompress_safe(packed.data(), (char*)block.data(), f.bytes, f.words * sizeof(uint64_t));
+    if( got != (int)(f.words * sizeof(uint64_t)) )
+        throw std::runtime_error("Corrupted index block");
+    loaded = b;
+}
+
+uint64_t minimizer_index::block_of(const uint64_t minimizer) const
+{
+    auto it = std::upper_bound(fences.begin(), fences.end(), minimizer,
+                               [](const uint64_t m, const index_fence& f) { return m < f.first; });
+    return (it == fences.begin()) ? UINT64_MAX : (it - fences.begin()) - 1;
+}
+
+bool minimizer_index::lookup(const uint64_t minimizer, std::vector<uint32_t>& colors)
+{
+    colors.clear();
+    bool found = false;
+    join(&minimizer, 1, [&](const uint64_t, const std::vector<uint32_t>& c) { colors = c; found = true; });
+    return found;
+}
+
+void minimizer_index::lookup_batch(const uint64_t* minimizers, const uint64_t n, std::vector<std::vector<uint32_t>>& colors)
+{
+    colors.assign(n, std::vector<uint32_t>());
+
+    std::vector<uint64_t> order( n );
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](const uint64_t a, const uint64_t b) { return minimizers[a] < minimizers[b]; });
+
+    std::vector<uint64_t> sorted( n );
+    for(uint64_t i = 0; i < n; i += 1)
+        sorted[i] = minimizers[ order[i] ];
+
+    join(sorted.data(), n, [&](const uint64_t q, const std::vector<uint32_t>& c) { colors[ order[q] ] = c; });
+}
+
+void minimizer_index::join(const uint64_t* sorted, const uint64_t n, const hit_fn& hit)
+{
+    std::vector<uint32_t> colors;
+    uint64_t i = 0;
+    while( i < n )
+    {
+        const uint64_t b = block_of( sorted[i] );
+        if( b == UINT64_MAX ){ i += 1; continue; }
+
+        load( b );
+        const uint64_t  rows    = block[0];
+        const uint64_t* keys    = block.data() + 1;
+        const uint64_t* offsets = keys + rows;
+        const uint64_t* payload = offsets + rows + 1;
+        const uint64_t  end     = (b + 1 < fences.size()) ? fences[b + 1].first : UINT64_MAX;
+
+        //
+        // All the queries falling in this block, both sides are sorted
+        //
+        uint64_t j = 0;
+        for(; (i < n) && ((sorted[i] < end) || (b + 1 == fences.size())); i += 1)
+        {
+            j = std::lower_bound(keys + j, keys + rows, sorted[i]) - keys;
+            if( (j < rows) && (keys[j] == sorted[i]) )
+            {
+                const uint64_t off  = offsets[j] & ((1ULL << 56) - 1);
+                const int      tier = offsets[j] >> 56;
+                policy.decode(tier, payload + off, colors);
+                hit(i, colors);
+            }
+        }
+    }
+}
+
+void minimizer_index::scan(const row_fn& row)
+{
+    std::vector<uint32_t> colors;
+    for(uint64_t b = 0; b < fences.size(); b += 1)
+    {
+        load( b );
+        const uint64_t  rows    = block[0];
+        const uint64_t* keys    = block.data() + 1;
+        const uint64_t* offsets = keys + rows;
+        const uint64_t* payload = offsets + rows + 1;
+        for(uint64_t j = 0; j < rows; j += 1)
+        {
+            const uint64_t off  = offsets[j] & ((1ULL << 56) - 1);
+            const int      tier = offsets[j] >> 56;
+            policy.decode(tier, payload + off, colors);
+            row(keys[j], colors);
+        }
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t export_color_rows(const std::string& index_file, const std::string& o_file)
+{
+    minimizer_index index( index_file );
+    const uint64_t  n_colors = index.colors();
+
+    std::unique_ptr<stream_writer> out( stream_writer_library::allocate(o_file) );
+    if( !out || !out->is_open() )
+        throw std::runtime_error("Cannot open: " + o_file);
+
+    //
+    // Each row is given to the builder as a list of ids, encode() keeps the smallest of the
+    // list, bitmap and runs representations
+    //
+    const uint64_t        max_row = 2 + (n_colors + 63) / 64;
+    std::vector<uint64_t> list( 1 + (n_colors + 1) / 2 );
+    std::vector<uint64_t> stage;
+    stage.reserve( std::max((uint64_t)64 * 1024, 16 * max_row) );
+    color_row_builder     row( n_colors );
+
+    index.scan([&](const uint64_t minimizer, const std::vector<uint32_t>& colors) {
+        list[0] = colors.size(); // ROW_SPARSE
+        for(size_t i = 0; i < colors.size(); i += 2)
+            list[1 + i / 2] = colors[i] | ((i + 1 < colors.size()) ? (uint64_t)colors[i + 1] << 32 : 0);
+        row.clear();
+        row.add_row(list.data(), 0);
+
+        if( stage.size() + max_row > stage.capacity() )
+        {
+            out->write_elements(stage.data(), sizeof(uint64_t), stage.size());
+            stage.clear();
+        }
+        const size_t pos = stage.size();
+        stage.resize( pos + max_row );
+        stage[pos] = minimizer;
+        stage.resize( pos + 1 + row.encode(stage.data() + pos + 1) );
+    });
+
+    if( stage.empty() == false )
+        out->write_elements(stage.data(), sizeof(uint64_t), stage.size());
+    return n_colors;
+}
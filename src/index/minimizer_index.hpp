@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "../merger/hybrid/tier_policy.hpp"
+
+//
+// Random access index of the final minimizer-colors rows, ordered by minimizer.
+//
+// The rows are grouped into blocks of about block_bytes raw bytes, each block being LZ4
+// compressed on its own :
+//
+//   raw block = [n][minimizers : n words][offsets : n + 1 words][payloads]
+//
+// offsets[i] gives the first payload word of row i in its 56 lower bits and the tier of the
+// row (representation of its payload, see tier_policy.hpp) in the 8 upper ones.
+//
+// The blocks are followed by the fence table, one entry per block :
+//
+//   [first minimizer][file offset][compressed bytes][raw words]
+//
+// and by a fixed size footer holding the table position and the tier policy needed to decode
+// the payloads. The table is loaded when the index is opened, a lookup decompresses a single
+// block.
+//
+static constexpr uint64_t INDEX_MAGIC   = 0x315844494d485a42ULL; // "BZHMIDX1"
+static constexpr uint64_t INDEX_FOOTER  = 12;                    // words
+
+struct index_fence
+{
+    uint64_t first;      // minimizer of the first row
+    uint64_t offset;     // in the file
+    uint64_t bytes;      // compressed
+    uint64_t words;      // raw
+};
+
+class minimizer_index_writer
+{
+private:
+    FILE*                    file;
+    const std::string        filename;
+    const tier_policy        policy;
+    const uint64_t           block_words;
+    std::vector<uint64_t>    keys;
+    std::vector<uint64_t>    offsets;
+    std::vector<uint64_t>    payloads;
+    std::vector<uint64_t>    raw;
+    std::vector<char>        packed;
+    std::vector<index_fence> fences;
+    uint64_t                 position = 0;
+    uint64_t                 n_rows   = 0;
+    uint64_t                 last     = 0; // minimizer of the last row
+
+    void flush_block();
+
+public:
+     minimizer_index_writer(const std::string& filen, const tier_policy& policy, const uint64_t block_bytes = 65536);
+    ~minimizer_index_writer();
+
+    //
+    // Rows have to be added in increasing minimizer order
+    //
+    void     add  (const uint64_t minimizer, const int tier, const uint64_t* payload, const uint64_t n_words);
+
+    //
+    // Has to be called explicitly : the destructor does not finish the index, it removes it
+    //
+    void     close();
+
+    uint64_t rows () const { return n_rows; }
+};
+
+//
+// Index of the rows of files sorted by minimizer, files[t] holding rows of tier t (an empty
+// name for a tier without file). Returns the number of rows.
+//
+extern uint64_t build_minimizer_index(const std::vector<std::string>& files, const tier_policy& policy, const std::string& index_file);
+
+//
+// Reader side, an object keeps the last decompressed block : one object per thread
+//
+class minimizer_index
+{
+private:
+    int                      fd = -1;
+    tier_policy              policy;
+    uint64_t                 n_rows = 0;
+    std::vector<index_fence> fences;
+    std::vector<uint64_t>    block;             // decompressed block
+    std::vector<char>        packed;
+    uint64_t                 loaded = UINT64_MAX; // block held by block
+
+    void     load    (const uint64_t b);
+    uint64_t block_of(const uint64_t minimizer) const; // UINT64_MAX when before the first row
+
+public:
+    typedef std::function<void(const uint64_t query,     const std::vector<uint32_t>& colors)> hit_fn;
+    typedef std::function<void(const uint64_t minimizer, const std::vector<uint32_t>& colors)> row_fn;
+
+     minimizer_index(const std::string& filen);
+    ~minimizer_index();
+
+    minimizer_index(const minimizer_index&) = delete;
+    minimizer_index& operator=(const minimizer_index&) = delete;
+
+    uint64_t           rows    () const { return n_rows;          }
+    uint64_t           colors  () const { return policy.n_colors; }
+    uint64_t           blocks  () const { return fences.size();   }
+    const tier_policy& tiers   () const { return policy;          }
+
+    //
+    // Colors of a minimizer, false (and no color) when it is not indexed
+    //
+    bool lookup      (const uint64_t minimizer, std::vector<uint32_t>& colors);
+
+    //
+    // colors[i] receives the colors of minimizers[i], empty when it is not indexed. The
+    // queries are visited in minimizer order, each block is decompressed at most once
+    //
+    void lookup_batch(const uint64_t* minimizers, const uint64_t n, std::vector<std::vector<uint32_t>>& colors);
+
+    //
+    // Merge join of n minimizers sorted in increasing order against the index : hit(i, colors)
+    // is called for each indexed sorted[i], blocks holding no query are not read
+    //
+    void join        (const uint64_t* sorted, const uint64_t n, const hit_fn& hit);
+
+    //
+    // All the rows, in increasing minimizer order
+    //
+    void scan        (const row_fn& row);
+};
+
+//
+// Rows of an index rewritten as a Step 2 file of adaptive color rows (see color_row.hpp),
+// ready to be merged with new colors. Returns the number of colors of the index.
+//
+extern uint64_t export_color_rows(const std::string& index_file, const std::string& o_file);
@@ -0,0 +1,411 @@
+#include "minimizer_mphf.hpp"
+#include "tier_stream.hpp"
+#include "../hash/CustomMurmurHash3.hpp"
+#include "../tools/CMemoryBudget/CMemoryBudget.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <omp.h>
+
+static constexpr uint64_t RANK_WORDS = 8;   // one rank sample per 512 bits
+static constexpr uint64_t FP_SEED    = 0x6a09e667f3bcc909ULL;
+
+static uint64_t bits_needed(const uint64_t value)
+{
+    return 64 - __builtin_clzll( std::max(value, (uint64_t)1) );
+}
+
+//
+// Position of a key in a level of n_bits bits, the seed changes with the level
+//
+static inline uint64_t level_position(const uint64_t key, const uint64_t level, const uint64_t n_bits)
+{
+    const uint64_t h = fmix64( key + (level + 1) * BIG_CONSTANT(0x9e3779b97f4a7c15) );
+    return (uint64_t)(((unsigned __int128)h * n_bits) >> 64);
+}
+
+static inline uint64_t fingerprint(const uint64_t key, const uint64_t fp_bits)
+{
+    return (fp_bits == 0) ? 0 : fmix64(key ^ FP_SEED) >> (64 - fp_bits);
+}
+
+//
+// Packed arrays of fixed width values, LSB first
+//
+static inline uint64_t get_bits(const uint64_t* array, const uint64_t i, const uint64_t width)
+{
+    if( width == 0 )
+        return 0;
+    const uint64_t bit = i * width;
+    const uint64_t sh  = bit & 63;
+    uint64_t value = array[bit >> 6] >> sh;
+    if( sh + width > 64 )
+        value |= array[(bit >> 6) + 1] << (64 - sh);
+    return (width == 64) ? value : value & ((1ULL << width) - 1);
+}
+
+static inline void set_bits(uint64_t* array, const uint64_t i, const uint64_t width, const uint64_t value)
+{
+    if( width == 0 )
+        return;
+    const uint64_t bit = i * width;
+    const uint64_t sh  = bit & 63;
+    array[bit >> 6] |= value << sh;
+    if( sh + width > 64 )
+        array[(bit >> 6) + 1] |= value >> (64 - sh);
+}
+
+//
+// Slot of a key : rank of its bit in the first level where it is set, or its place in the
+// fallback keys
+//
+static inline uint64_t slot_of(const uint64_t key, const uint64_t n_levels, const uint64_t* level_first,
+                               const uint64_t* bits, const uint64_t* ranks,
+                               const uint64_t* fallback, const uint64_t n_fallback, const uint64_t n_ranked)
+{
+    for(uint64_t l = 0; l < n_levels; l += 1)
+    {
+        const uint64_t p = level_first[l] + level_position(key, l, level_first[l + 1] - level_first[l]);
+        const uint64_t w = p >> 6;
+        if( (bits[w] >> (p & 63)) & 1 )
+        {
+            uint64_t rank = ranks[w / RANK_WORDS];
+            for(uint64_t x = w - (w % RANK_WORDS); x < w; x += 1)
+                rank += __builtin_popcountll( bits[x] );
+            return rank + __builtin_popcountll( bits[w] & ((1ULL << (p & 63)) - 1) );
+        }
+    }
+    if( n_fallback == 0 )
+        return 0; // not a key of the set
+    const uint64_t* f = std::lower_bound(fallback, fallback + n_fallback, key);
+    return n_ranked + std::min((uint64_t)(f - fallback), n_fallback - 1);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t build_minimizer_mphf(const std::vector<std::string>& files, const tier_policy& policy, const std::string& mphf_file,
+                              const int threads, const uint64_t fp_bits, const double gamma)
+{
+    if( fp_bits > 32 )
+        throw std::runtime_error("Fingerprints are limited to 32 bits");
+
+    //
+    // The builder leases its memory from the process budget (-M). A lease alone is granted
+    // beyond the limit, the limit is checked here : the option is refused when it cannot fit.
+    //
+    CMemoryBudget::lease memory(0, 0);
+    auto reserve = [&](const uint64_t bytes)
+    {
+        if( bytes <= memory.bytes() )
+            return;
+        const uint64_t need = bytes - memory.bytes();
+        if( ((CMemoryBudget::limit() != 0) && (bytes > CMemoryBudget::limit())) || (memory.grow(need, need) == 0) )
+            throw std::runtime_error("The minimal perfect hash needs " + std::to_string(bytes / (1024 * 1024) + 1) +
+                                     " MB, more than the memory budget (-M)");
+    };
+
+    //
+    // Keys and color classes : rows of a file are grouped by color set, a class starts when
+    // the payload differs from the one of the previous row. A color set always has the same
+    // representation, the classes of different tiers are distinct. The class of each key is
+    // not kept, the second pass finds it again.
+    //
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> class_offs;
+    std::vector<uint64_t> payloads;
+
+    auto same_class = [&](const uint64_t c, const tier_stream& stream) -> bool
+    {
+        const uint64_t off = class_offs[c] & ((1ULL << 56) - 1);
+        const uint64_t end = (c + 1 < class_offs.size()) ? class_offs[c + 1] & ((1ULL << 56) - 1) : payloads.size();
+        return (end - off == stream.words) &&
+               (std::memcmp(payloads.data() + off, stream.payload(), stream.words * sizeof(uint64_t)) == 0);
+    };
+
+    reserve( (1 << 16) * sizeof(uint64_t) );
+    keys.reserve( 1 << 16 );
+    for(int t = 0; t < (int)files.size(); t += 1)
+    {
+        if( files[t].empty() == true )
+            continue;
+        tier_stream stream(files[t], t, policy);
+        uint64_t current = UINT64_MAX; // class of the previous row
+        for(; stream.valid == true; stream.next())
+        {
+            const bool new_class = (current == UINT64_MAX) || (same_class(current, stream) == false);
+
+            // a vector that grows holds its old and its new buffer during the copy
+            const bool grows = (keys.size() == keys.capacity()) ||
+                               (new_class && ((class_offs.size() == class_offs.capacity()) || (payloads.size() + stream.words > payloads.capacity())));
+            if( grows == true )
+                reserve( 3 * (keys.capacity() + class_offs.capacity() + std::max(payloads.capacity(), payloads.size() + stream.words)) * sizeof(uint64_t) );
+
+            if( new_class == true )
+            {
+                current = class_offs.size();
+                class_offs.push_back( payloads.size() | ((uint64_t)t << 56) );
+                payloads  .insert(payloads.end(), stream.payload(), stream.payload() + stream.words);
+            }
+            keys.push_back( stream.minimizer() );
+        }
+    }
+    const uint64_t n_keys    = keys.size();
+    const uint64_t n_classes = class_offs.size();
+    class_offs.push_back( payloads.size() );
+    const uint64_t class_bytes = (class_offs.capacity() + payloads.capacity()) * sizeof(uint64_t);
+
+    //
+    // Levels : the keys colliding in a level are passed to the next one, the keys themselves
+    // are only needed by the first level
+    //
+    std::vector<uint64_t> level_bits;
+    std::vector<uint64_t> bits;
+    std::vector<uint64_t> rest;
+    while( (level_bits.size() < MPHF_MAX_LEVELS) && (((level_bits.empty() == true) ? keys : rest).empty() == false) )
+    {
+        const std::vector<uint64_t>& cur = (level_bits.empty() == true) ? keys : rest;
+        const uint64_t l      = level_bits.size();
+        const uint64_t n_bits = std::max((uint64_t)64, ((uint64_t)(gamma * cur.size()) + 63) / 64 * 64);
+
+        // keys of the level, its two bit arrays, and the colliding keys (twice while they are gathered)
+        reserve( class_bytes + (keys.capacity() + rest.capacity() + bits.size() + 3 * n_bits / 64 + 2 * cur.size()) * sizeof(uint64_t) );
+
+        std::vector<uint64_t> seen     ( n_bits / 64, 0 );
+        std::vector<uint64_t> collision( n_bits / 64, 0 );
+
+#pragma omp parallel for num_threads(threads)
+        for(uint64_t i = 0; i < cur.size(); i += 1)
+        {
+            const uint64_t p = level_position(cur[i], l, n_bits);
+            const uint64_t b = 1ULL << (p & 63);
+            uint64_t old;
+#pragma omp atomic capture
+            { old = seen[p >> 6]; seen[p >> 6] |= b; }
+            if( old & b )
+            {
+#pragma omp atomic update
+                collision[p >> 6] |= b;
+            }
+        }
+
+#pragma omp parallel for num_threads(threads)
+        for(uint64_t w = 0; w < seen.size(); w += 1)
+            seen[w] &= ~collision[w];
+
+        std::vector<uint64_t> next;
+#pragma omp parallel num_threads(threads)
+        {
+            std::vector<uint64_t> local;
+#pragma omp for nowait
+            for(uint64_t i = 0; i < cur.size(); i += 1)
+            {
+                const uint64_t p = level_position(cur[i], l, n_bits);
+                if( (collision[p >> 6] >> (p & 63)) & 1 )
+                    local.push_back( cur[i] );
+            }
+#pragma omp critical
+            next.insert(next.end(), local.begin(), local.end());
+        }
+
+        level_bits.push_back( n_bits );
+        bits.insert(bits.end(), seen.begin(), seen.end());
+        rest.swap( next );
+        std::vector<uint64_t>().swap( keys );
+    }
+    std::vector<uint64_t>().swap( keys );
+    std::sort(rest.begin(), rest.end());
+    const uint64_t n_levels   = level_bits.size();
+    const uint64_t n_fallback = rest.size();
+
+    std::vector<uint64_t> ranks(bits.size() / RANK_WORDS + 1, 0);
+    for(uint64_t w = 0, r = 0; w < bits.size(); w += 1)
+    {
+        if( (w % RANK_WORDS) == 0 ) ranks[w / RANK_WORDS] = r;
+        r += __builtin_popcountll( bits[w] );
+    }
+
+    uint64_t level_first[MPHF_MAX_LEVELS + 1] = { 0 };
+    for(uint64_t l = 0; l < n_levels; l += 1)
+        level_first[l + 1] = level_first[l] + level_bits[l];
+
+    //
+    // Class id and fingerprint of every slot, packed as they are found : a second pass over
+    // the tier files gives the keys and their class again. The slots of a batch of keys are
+    // computed in parallel, the packed words they share are written by one thread.
+    //
+    const uint64_t id_bits = (n_classes > 1) ? bits_needed(n_classes - 1) : 0;
+    const uint64_t batch   = 1 << 16;
+
+    std::vector<uint64_t> ids( (n_keys * id_bits + 63) / 64 );
+    std::vector<uint64_t> fps( (n_keys * fp_bits + 63) / 64 );
+    reserve( class_bytes + (bits.size() + ranks.size() + rest.size() + ids.size() + fps.size() + 3 * batch) * sizeof(uint64_t) );
+
+    std::vector<uint64_t> batch_keys, batch_class, batch_slot( batch );
+    batch_keys .reserve( batch );
+    batch_class.reserve( batch );
+    auto flush_batch = [&]()
+    {
+        const uint64_t n = batch_keys.size();
+#pragma omp parallel for num_threads(threads)
+        for(uint64_t i = 0; i < n; i += 1)
+            batch_slot[i] = slot_of(batch_keys[i], n_levels, level_first, bits.data(), ranks.data(), rest.data(), n_fallback, n_keys - n_fallback);
+        for(uint64_t i = 0; i < n; i += 1)
+        {
+            set_bits(ids.data(), batch_slot[i], id_bits, batch_class[i]);
+            set_bits(fps.data(), batch_slot[i], fp_bits, fingerprint(batch_keys[i], fp_bits));
+        }
+        batch_keys .clear();
+        batch_class.clear();
+    };
+
+    uint64_t n_seen   = 0;
+    uint64_t n_class  = 0;
+    for(int t = 0; t < (int)files.size(); t += 1)
+    {
+        if( files[t].empty() == true )
+            continue;
+        tier_stream stream(files[t], t, policy);
+        uint64_t current = UINT64_MAX;
+        for(; stream.valid == true; stream.next())
+        {
+            if( (current == UINT64_MAX) || (same_class(current, stream) == false) )
+                current = n_class++;
+            batch_keys .push_back( stream.minimizer() );
+            batch_class.push_back( current );
+            n_seen += 1;
+            if( batch_keys.size() == batch )
+                flush_batch();
+        }
+    }
+    flush_batch();
+    if( (n_seen != n_keys) || (n_class != n_classes) )
+        throw std::runtime_error("The tier files changed while building the mphf file: " + mphf_file);
+
+    //
+    // The sections are written in place, without gathering them in one buffer
+    //
+    const uint64_t header[MPHF_HEADER] = {
+        MPHF_MAGIC, n_keys, n_levels, n_classes, n_fallback, id_bits, fp_bits, payloads.size(),
+        policy.n_colors, policy.level_1, policy.bitmap_words, policy.sparse_bits,
+        policy.sparse_max, policy.delta_max, policy.complement_min, (uint64_t)policy.sparse_vbyte
+    };
+
+    FILE* f = fopen(mphf_file.c_str(), "wb");
+    if( f == NULL )
+        throw std::runtime_error("Cannot open mphf file: " + mphf_file);
+    const std::pair<const uint64_t*, uint64_t> sections[] = {
+        {header, MPHF_HEADER}, {level_bits.data(), level_bits.size()}, {bits.data(), bits.size()},
+        {ranks.data(), ranks.size()}, {rest.data(), rest.size()}, {ids.data(), ids.size()}, {fps.data(), fps.size()},
+        {class_offs.data(), class_offs.size()}, {payloads.data(), payloads.size()}
+    };
+    bool ok = true;
+    for(const auto& section : sections)
+        ok = ok && (fwrite(section.first, sizeof(uint64_t), section.second, f) == section.second);
+    ok = (fclose( f ) == 0) && ok;
+    if( ok == false )
+    {
+        std::remove( mphf_file.c_str() );
+        throw std::runtime_error("Cannot write mphf file: " + mphf_file);
+    }
+    return n_keys;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+minimizer_mphf::minimizer_mphf(const std::string& filen)
+{
+    FILE* f = fopen(filen.c_str(), "rb");
+    if( f == NULL )
+        throw std::runtime_error("Cannot open mphf file: " + filen);
+    fseek(f, 0, SEEK_END);
+    const uint64_t n_words = ftell(f) / sizeof(uint64_t);
+    fseek(f, 0, SEEK_SET);
+    data.resize( n_words );
+    const bool ok = (fread(data.data(), sizeof(uint64_t), n_words, f) == n_words);
+    fclose( f );
+    if( (ok == false) || (n_words < MPHF_HEADER) || (data[0] != MPHF_MAGIC) )
+        throw std::runtime_error("Not a minimizer mphf file: " + filen);
+
+    n_keys                  = data[1];
+    n_levels                = data[2];
+    n_classes               = data[3];
+    n_fallback              = data[4];
+    id_bits                 = data[5];
+    fp_bits                 = data[6];
+    const uint64_t n_payload= data[7];
+    policy.n_colors         = data[8];
+    policy.level_1          = data[9];
+    policy.bitmap_words     = data[10];
+    policy.sparse_bits      = data[11];
+    policy.sparse_max       = data[12];
+    policy.delta_max        = data[13];
+    policy.complement_min   = data[14];
+    policy.sparse_vbyte     = (data[15] != 0);
+
+    if( n_levels > MPHF_MAX_LEVELS )
+        throw std::runtime_error("Not a minimizer mphf file: " + filen);
+
+    level_first[0] = 0;
+    for(uint64_t l = 0; l < n_levels; l += 1)
+        level_first[l + 1] = level_first[l] + data[MPHF_HEADER + l];
+    const uint64_t bit_words = level_first[n_levels] / 64;
+
+    uint64_t pos = MPHF_HEADER + n_levels;
+    const uint64_t sizes[] = {
+        bit_words, bit_words / RANK_WORDS + 1, n_fallback,
+        (n_keys * id_bits + 63) / 64, (n_keys * fp_bits + 63) / 64, n_classes + 1, n_payload
+    };
+    const uint64_t** sections[] = { &bits, &ranks, &fallback, &ids, &fps, &class_offs, &payloads };
+    for(int s = 0; s < 7; s += 1)
+    {
+        *sections[s] = data.data() + pos;
+        pos += sizes[s];
+    }
+    if( pos != n_words )
+        throw std::runtime_error("Truncated minimizer mphf file: " + filen);
+}
+
+uint64_t minimizer_mphf::slot(const uint64_t minimizer) const
+{
+    return slot_of(minimizer, n_levels, level_first, bits, ranks, fallback, n_fallback, n_keys - n_fallback);
+}
+
+uint64_t minimizer_mphf::class_of(const uint64_t minimizer) const
+{
+    if( n_keys == 0 )
+        return UINT64_MAX;
+    const uint64_t s = slot( minimizer );
+    if( get_bits(fps, s, fp_bits) != fingerprint(minimizer, fp_bits) )
+        return UINT64_MAX;
+    return get_bits(ids, s, id_bits);
+}
+
+void minimizer_mphf::decode(const uint64_t color_class, std::vector<uint32_t>& colors) const
+{
+    const uint64_t off  = class_offs[color_class] & ((1ULL << 56) - 1);
+    const int      tier = class_offs[color_class] >> 56;
+    policy.decode(tier, payloads + off, colors);
+}
+
+bool minimizer_mphf::lookup(const uint64_t minimizer, std::vector<uint32_t>& colors) const
+{
+    const uint64_t c = class_of( minimizer );
+    if( c == UINT64_MAX )
+    {
+        colors.clear();
+        return false;
+    }
+    decode(c, colors);
+    return true;
+}
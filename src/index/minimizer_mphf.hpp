@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../merger/hybrid/tier_policy.hpp"
+
+//
+// Memory resident minimizer -> colors map built over the final outputs (rows grouped by color
+// set, see external_sort) :
+//
+//  - a minimal perfect hash function over the minimizers, BBHash style : level l is a bit array
+//    of gamma x (keys left) bits, a key goes to the first level where its hash does not collide
+//    with another one. The rank of its bit in the concatenated levels is its slot in [0, n). The
+//    few keys left after max_levels are kept in a sorted array, slots n - n_fallback and above.
+//  - per slot, the color class id (id_bits bits) and a fingerprint of the minimizer (fp_bits
+//    bits) that rejects most of the keys that were not in the set.
+//  - the color classes, one payload per distinct color set in its tier representation.
+//
+// File layout (64-bit words) :
+//
+//   [header : MPHF_HEADER words][level sizes in bits][level bit arrays][rank samples]
+//   [fallback keys][class ids, packed][fingerprints, packed]
+//   [class offsets : n_classes + 1, tier in the 8 upper bits][class payloads]
+//
+static constexpr uint64_t MPHF_MAGIC      = 0x314648504d485a42ULL; // "BZHMPHF1"
+static constexpr uint64_t MPHF_HEADER     = 16;                    // words
+static constexpr uint64_t MPHF_MAX_LEVELS = 32;
+
+//
+// files[t] holds the rows of tier t (an empty name for a tier without file), the rows of each
+// file are grouped by color set. Returns the number of keys. The builder reads the files twice
+// and leases its memory (mostly the keys, 8 bytes each) from CMemoryBudget, it throws when
+// it does not fit in the budget.
+//
+extern uint64_t build_minimizer_mphf(const std::vector<std::string>& files, const tier_policy& policy, const std::string& mphf_file,
+                                     const int threads, const uint64_t fp_bits = 8, const double gamma = 2.0);
+
+class minimizer_mphf
+{
+private:
+    std::vector<uint64_t> data;
+    tier_policy           policy;
+
+    uint64_t        n_keys     = 0;
+    uint64_t        n_levels   = 0;
+    uint64_t        n_classes  = 0;
+    uint64_t        n_fallback = 0;
+    uint64_t        id_bits    = 0;
+    uint64_t        fp_bits    = 0;
+    uint64_t        level_first[MPHF_MAX_LEVELS + 1]; // first bit of each level
+    const uint64_t* bits       = nullptr;
+    const uint64_t* ranks      = nullptr;
+    const uint64_t* fallback   = nullptr;
+    const uint64_t* ids        = nullptr;
+    const uint64_t* fps        = nullptr;
+    const uint64_t* class_offs = nullptr;
+    const uint64_t* payloads   = nullptr;
+
+public:
+    minimizer_mphf(const std::string& filen);
+
+    uint64_t           keys   () const { return n_keys;          }
+    uint64_t           classes() const { return n_classes;       }
+    uint64_t           colors () const { return policy.n_colors; }
+    const tier_policy& tiers  () const { return policy;          }
+    uint64_t           bytes  () const { return data.size() * sizeof(uint64_t); }
+
+    //
+    // Slot in [0, keys()) for a key of the set, any value in this range for the others
+    //
+    uint64_t slot    (const uint64_t minimizer) const;
+
+    //
+    // Color class of a minimizer, UINT64_MAX when the fingerprint rejects it
+    //
+    uint64_t class_of(const uint64_t minimizer) const;
+
+    void     decode  (const uint64_t color_class, std::vector<uint32_t>& colors) const;
+
+    //
+    // Colors of a minimizer, false (and no color) when it is rejected. An absent minimizer is
+    // accepted with a probability of 2^-fp_bits
+    //
+    bool     lookup  (const uint64_t minimizer, std::vector<uint32_t>& colors) const;
+};
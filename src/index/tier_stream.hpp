@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../files/stream_reader_library.hpp"
+#include "../merger/hybrid/tier_policy.hpp"
+
+//
+// Rows of a tier file, the current one is entirely in the buffer
+//
+class tier_stream
+{
+private:
+    std::unique_ptr<stream_reader> reader;
+    const tier_policy&             policy;
+    std::vector<uint64_t>          buffer;
+    size_t                         pos   = 0;
+    size_t                         limit = 0;
+    bool                           eof   = false;
+
+    bool ensure(const size_t n)
+    {
+        if( pos + n <= limit ) return true;
+        if( eof == true      ) return false;
+        const size_t remaining = limit - pos;
+        if( pos + n > buffer.size() )
+            buffer.resize( std::max(2 * buffer.size(), remaining + n) );
+        std::copy(buffer.begin() + pos, buffer.begin() + limit, buffer.begin());
+        pos   = 0;
+        limit = remaining;
+        const size_t got = reader->read_elements(buffer.data() + limit, sizeof(uint64_t), buffer.size() - limit);
+        eof   = (got < buffer.size() - limit);
+        limit += got;
+        return pos + n <= limit;
+    }
+
+public:
+    const int tier;
+    bool      valid = false;
+    uint64_t  words = 0;     // payload words of the current row
+
+    tier_stream(const std::string& filen, const int i_tier, const tier_policy& i_policy)
+        : policy( i_policy ), buffer( 1 << 16 ), tier( i_tier )
+    {
+        reader.reset( stream_reader_library::allocate(filen) );
+        if( !reader || !reader->is_open() )
+            throw std::runtime_error("Cannot open tier file: " + filen);
+        next( true );
+    }
+
+    uint64_t        minimizer() const { return buffer[pos];     }
+    const uint64_t* payload  () const { return &buffer[pos + 1]; }
+
+    void next(const bool first = false)
+    {
+        if( first == false )
+            pos += 1 + words;
+        valid = ensure( 2 );
+        if( valid == false )
+            return;
+        words = policy.payload_words(tier, &buffer[pos + 1]);
+        valid = ensure( 1 + words );
+        if( valid == false )
+            throw std::runtime_error("Truncated row in a tier file");
+    }
+};
@@ -0,0 +1,77 @@
+#include "minimizer_hash_set.hpp"
+#include "../sorting/crumsort/crumsort.hpp"
+
+#include <algorithm>
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+minimizer_hash_set::minimizer_hash_set(const uint64_t capacity)
+{
+    allocate( capacity );
+}
+
+void minimizer_hash_set::allocate(const uint64_t capacity)
+{
+    uint64_t bits = 10;
+    while( (bits < 63) && ((1ULL << (bits + 1)) <= capacity) )
+        bits += 1;
+
+    table.assign( 1ULL << bits, 0 );
+    shift    = 64 - bits;
+    mask     = (1ULL << bits) - 1;
+    max_load = (table.size() * 7) / 10;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+std::vector<uint64_t>& minimizer_hash_set::sorted(uint64_t& n_elements)
+{
+    uint64_t o = 0;
+    for(uint64_t i = 0; i < table.size(); i += 1)
+    {
+        const uint64_t v = table[i];
+        if( v != 0 )
+        {
+            table[i]   = 0;
+            table[o++] = v;
+        }
+    }
+    if( has_zero )
+        table[o++] = 0; // the table is never full, sorted in front
+
+    crumsort_prim( table.data(), o, 9 /*uint64*/ );
+
+    n_values   = o;   // the table is no longer a hash table, clear() has to be called
+    has_zero   = false;
+    n_elements = o;
+    return table;
+}
+
+void minimizer_hash_set::rehash(const uint64_t capacity)
+{
+    std::vector<uint64_t> values;
+    values.swap( table );
+    allocate( capacity );
+
+    n_values = 0;
+    for(const uint64_t v : values)
+    {
+        if( v != 0 )
+            insert( v );
+    }
+}
+
+void minimizer_hash_set::clear()
+{
+    std::fill(table.begin(), table.end(), 0);
+    n_values = 0;
+    has_zero = false;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//
+// Set of minimizers deduplicated on insertion (open addressing, linear probing), an
+// alternative to the occurrence list of minimizer_processing_v4 when most of the minimizers
+// of a sample are repeated (sequencing reads at high coverage). The memory then grows with
+// the distinct minimizers instead of the occurrences, and the values are only sorted once,
+// when the set is flushed.
+//
+// The slot is given by a multiplicative hash of the value (the minimizer hashes are skewed
+// towards the small values, their high bits are not uniform). 0 marks the empty slots, the
+// value 0 itself is kept aside.
+//
+class minimizer_hash_set
+{
+private:
+    std::vector<uint64_t> table;
+    uint64_t              shift;      // 64 - log2(capacity)
+    uint64_t              mask;
+    uint64_t              n_values  = 0;
+    uint64_t              max_load;
+    bool                  has_zero  = false;
+
+    void allocate(const uint64_t capacity);
+
+public:
+    //
+    // capacity : memory budget in values, the table holds up to 70% of its power of two
+    //
+    minimizer_hash_set(const uint64_t capacity);
+
+    inline void insert(const uint64_t value)
+    {
+        if( value == 0 )
+        {
+            has_zero = true;
+            return;
+        }
+        uint64_t slot = (value * 0x9E3779B97F4A7C15ULL) >> shift;
+        while( true )
+        {
+            const uint64_t v = table[slot];
+            if( v == value )
+                return;
+            if( v == 0 )
+            {
+                table[slot] = value;
+                n_values   += 1;
+                return;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    inline bool full() const { return n_values >= max_load; }
+
+    uint64_t size() const { return n_values + (has_zero ? 1 : 0); }
+
+    uint64_t memory() const { return table.size() * sizeof(uint64_t); }
+
+    //
+    // Moves the values to a table sized for the new capacity (the old table is freed after)
+    //
+    void rehash(const uint64_t capacity);
+
+    //
+    // Sorted distinct values, moved to the start of the table (valid until the next insert
+    // or clear) : returns the table and their number in n_elements
+    //
+    std::vector<uint64_t>& sorted(uint64_t& n_elements);
+
+    void clear();
+};
@@ -0,0 +1,315 @@
+#include "color_row.hpp"
+#include <cstring>
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t row_density(const uint64_t* row)
+{
+    const uint64_t  header  = row[0];
+    const uint64_t  count   = row_count( header );
+    const uint64_t* payload = row + 1;
+    uint64_t        density = 0;
+    switch( row_tag(header) )
+    {
+        case ROW_SPARSE:
+            return count;
+        case ROW_BITMAP:
+            for(uint64_t i = 0; i < count; i += 1)
+                density += __builtin_popcountll( payload[i] );
+            return density;
+        default:
+            for(uint64_t i = 0; i < count; i += 1)
+                density += payload[i] >> 32;
+            return density;
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+color_row_builder::color_row_builder(const uint64_t n_colors) : n_words( (n_colors + 63) / 64 )
+{
+    list.reserve  ( 2 * n_words + 1 );
+    bitmap.resize ( n_words         );
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void color_row_builder::clear()
+{
+    if( dense == true )
+    {
+        std::fill(bitmap.begin(), bitmap.end(), 0);
+        dense = false;
+    }
+    list.clear();
+    sorted = true;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void color_row_builder::to_dense()
+{
+    for(size_t i = 0; i < list.size(); i += 1)
+        bitmap[list[i] >> 6] |= (1ULL << (list[i] & 63));
+    list.clear();
+    sorted = true;
+    dense  = true;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void color_row_builder::add_color(const uint32_t color)
+{
+    if( dense == true )
+    {
+        bitmap[color >> 6] |= (1ULL << (color & 63));
+        return;
+    }
+    if( (list.empty() == false) && (color < list.back()) )
+        sorted = false;
+    list.push_back( color );
+    if( list.size() > 2 * n_words ) // la liste devient plus grosse que le bitmap
+        to_dense();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void color_row_builder::add_range(const uint32_t start, const uint32_t length)
+{
+    if( (dense == false) && (list.size() + length > 2 * n_words) )
+        to_dense();
+
+    if( dense == false )
+    {
+        for(uint32_t i = 0; i < length; i += 1)
+            add_color( start + i );
+        return;
+    }
+
+    uint64_t pos = start;
+    uint64_t end = (uint64_t)start + length;
+    while( pos < end )
+    {
+        const uint64_t w     = pos >> 6;
+        const uint64_t first = pos & 63;
+        const uint64_t n     = std::min((uint64_t)64 - first, end - pos);
+        const uint64_t mask  = (n == 64) ? ~0ULL : (((1ULL << n) - 1) << first);
+        bitmap[w] |= mask;
+        pos       += n;
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void color_row_builder::add_bitmap(const uint64_t* words, const uint64_t n, const uint64_t offset)
+{
+    if( dense == false )
+    {
+        uint64_t pop = 0;
+        for(uint64_t w = 0; w < n; w += 1)
+            pop += __builtin_popcountll( words[w] );
+        if( list.size() + pop > 2 * n_words )
+            to_dense();
+    }
+
+    if( (dense == true) && ((offset & 63) == 0) )
+    {
+        uint64_t* dst = bitmap.data() + (offset >> 6);
+        for(uint64_t w = 0; w < n; w += 1)
+            dst[w] |= words[w];
+        return;
+    }
+
+    for(uint64_t w = 0; w < n; w += 1)
+    {
+        uint64_t bits = words[w];
+        while( bits )
+        {
+            add_color( (uint32_t)(offset + 64 * w + __builtin_ctzll(bits)) );
+            bits &= bits - 1;
+        }
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void color_row_builder::add_row(const uint64_t* row, const uint64_t offset)
+{
+    const uint64_t  header  = row[0];
+    const uint64_t  count   = row_count( header );
+    const uint64_t* payload = row + 1;
+
+    switch( row_tag(header) )
+    {
+        case ROW_SPARSE:
+            if( (dense == false) && (list.size() + count > 2 * n_words) )
+                to_dense();
+            for(uint64_t i = 0; i < count; i += 1)
+                add_color( (uint32_t)(offset + ((payload[i / 2] >> (32 * (i & 1))) & 0xFFFFFFFF)) );
+            break;
+
+        case ROW_BITMAP:
+            add_bitmap(payload, count, offset);
+            break;
+
+        case ROW_RUNS:
+            for(uint64_t i = 0; i < count; i += 1)
+                add_range( (uint32_t)(offset + (payload[i] & 0xFFFFFFFF)), (uint32_t)(payload[i] >> 32) );
+            break;
+
+        default:
+            printf("(EE) Unknown color row representation (%lu)\n", row_tag(header));
+            printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+            exit( EXIT_FAILURE );
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t color_row_builder::density()
+{
+    if( dense == false )
+        return list.size();
+    uint64_t pop = 0;
+    for(uint64_t w = 0; w < n_words; w += 1)
+        pop += __builtin_popcountll( bitmap[w] );
+    return pop;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t color_row_builder::encode(uint64_t* dst)
+{
+    //
+    // On mesure le coût des trois représentations
+    //
+    uint64_t n_colors = 0;
+    uint64_t n_runs   = 0;
+    uint64_t width    = 0;
+    if( dense == false )
+    {
+        if( sorted == false ){ std::sort(list.begin(), list.end()); sorted = true; }
+        n_colors = list.size();
+        for(size_t i = 0; i < list.size(); i += 1)
+            n_runs += (i == 0) || (list[i] != list[i - 1] + 1);
+        width    = (n_colors != 0) ? (list.back() / 64 + 1) : 0;
+    }
+    else
+    {
+        uint64_t carry = 0;
+        for(uint64_t w = 0; w < n_words; w += 1)
+        {
+            const uint64_t bits = bitmap[w];
+            n_colors += __builtin_popcountll( bits );
+            n_runs   += __builtin_popcountll( bits & ~((bits << 1) | carry) ); // debuts de plage
+            carry     = bits >> 63;
+            if( bits != 0 )
+                width = w + 1;
+        }
+    }
+
+    const uint64_t sparse_words = (n_colors + 1) / 2;
+    uint64_t*      payload      = dst + 1;
+
+    if( (sparse_words <= width) && (sparse_words <= n_runs) )
+    {
+        dst[0] = (ROW_SPARSE << 62) | n_colors;
+        if( n_colors & 1 )
+            payload[sparse_words - 1] = 0;
+        uint64_t i = 0;
+        for_each_color([&](const uint32_t color) {
+            if( (i & 1) == 0 ) payload[i / 2]  = color;
+            else               payload[i / 2] |= (uint64_t)color << 32;
+            i += 1;
+        });
+        return 1 + sparse_words;
+    }
+
+    if( n_runs < width )
+    {
+        dst[0] = (ROW_RUNS << 62) | n_runs;
+        int64_t  r    = -1;
+        uint64_t prev = 0;
+        for_each_color([&](const uint32_t color) {
+            if( (r >= 0) && (color == prev + 1) )
+                payload[r] += (1ULL << 32);
+            else
+                payload[++r] = color | (1ULL << 32);
+            prev = color;
+        });
+        return 1 + n_runs;
+    }
+
+    dst[0] = (ROW_BITMAP << 62) | width;
+    write_bitmap(payload, width);
+    return 1 + width;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void color_row_builder::write_bitmap(uint64_t* dst, const uint64_t n)
+{
+    if( dense == true )
+    {
+        const uint64_t copy = std::min(n, n_words);
+        std::memcpy(dst, bitmap.data(), copy * sizeof(uint64_t));
+        for(uint64_t w = copy; w < n; w += 1)
+            dst[w] = 0;
+        return;
+    }
+    for(uint64_t w = 0; w < n; w += 1)
+        dst[w] = 0;
+    for(size_t i = 0; i < list.size(); i += 1)
+        dst[list[i] >> 6] |= (1ULL << (list[i] & 63));
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
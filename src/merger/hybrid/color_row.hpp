@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+//
+// Adaptive color set of a minimizer, used by the files of Step 2 that carry more than 64
+// colors. A row is [minimizer][header][payload ...] where the two upper bits of the header
+// give the representation and the lower ones its number of entries :
+//
+//  - ROW_SPARSE : list of color ids, 32 bits each, two per payload word (low half first)
+//  - ROW_BITMAP : bitmap words, trailing zero words are not stored
+//  - ROW_RUNS   : one payload word per run of consecutive colors (start | length << 32)
+//
+// The encoder always keeps the smallest of the three, so a row never exceeds the size of the
+// full bitmap.
+//
+static constexpr uint64_t ROW_SPARSE = 0;
+static constexpr uint64_t ROW_BITMAP = 1;
+static constexpr uint64_t ROW_RUNS   = 2;
+
+inline uint64_t row_tag  (const uint64_t header) { return header >> 62;                 }
+inline uint64_t row_count(const uint64_t header) { return header & ((1ULL << 62) - 1); }
+
+inline uint64_t row_payload_words(const uint64_t header)
+{
+    const uint64_t count = row_count( header );
+    return (row_tag(header) == ROW_SPARSE) ? (count + 1) / 2 : count;
+}
+
+//
+// Number of colors of a row (row points to the header)
+//
+extern uint64_t row_density(const uint64_t* row);
+
+//
+// Union of color sets coming from several inputs, each one shifted by the color offset of its
+// input. Small sets are kept as a list of ids, they switch to a bitmap as soon as the list
+// would become larger than it.
+//
+class color_row_builder
+{
+private:
+    const uint64_t        n_words;      // bitmap width of the output (words)
+    std::vector<uint32_t> list;
+    std::vector<uint64_t> bitmap;
+    bool                  dense  = false;
+    bool                  sorted = true;
+
+    void to_dense  ();
+    void add_color (const uint32_t color);
+    void add_range (const uint32_t start, const uint32_t length);
+
+public:
+    color_row_builder(const uint64_t n_colors);
+
+    void     clear     ();
+    void     add_bitmap(const uint64_t* words, const uint64_t n, const uint64_t offset);
+    void     add_row   (const uint64_t* row, const uint64_t offset); // row points to the header
+    uint64_t density   ();
+
+    uint64_t encode      (uint64_t* dst);                 // header + payload, returns the number of words
+    void     write_bitmap(uint64_t* dst, const uint64_t n); // plain bitmap of n words
+
+    //
+    // Calls f(color) for each color, in increasing order
+    //
+    template <class F> void for_each_color(F f)
+    {
+        if( dense == false )
+        {
+            if( sorted == false ){ std::sort(list.begin(), list.end()); sorted = true; }
+            for(size_t i = 0; i < list.size(); i += 1)
+                f( list[i] );
+            return;
+        }
+        for(uint64_t w = 0; w < n_words; w += 1)
+        {
+            uint64_t bits = bitmap[w];
+            while( bits )
+            {
+                f( (uint32_t)(64 * w + __builtin_ctzll(bits)) );
+                bits &= bits - 1;
+            }
+        }
+    }
+};
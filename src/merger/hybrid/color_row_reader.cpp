@@ -0,0 +1,148 @@
+#include "color_row_reader.hpp"
+#include "../../files/stream_reader_library.hpp"
+#include <cstring>
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+color_row_reader::color_row_reader(const std::string& filen, const uint64_t n_colors, const bool _hybrid, const int fan_in, const uint64_t ram_budget_MB)
+    : hybrid(_hybrid), plain_words( (n_colors + 63) / 64 )
+{
+    stream = stream_reader_library::allocate_prefetch(filen, fan_in, ram_budget_MB);
+    if( stream == NULL )
+    {
+        printf("(EE) File does not exist (%s))\n", filen.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        exit( EXIT_FAILURE );
+    }
+
+    //
+    // Le buffer doit pouvoir contenir plusieurs lignes de taille maximum (minimizer + entête + bitmap)
+    //
+    buffer.resize( std::max((uint64_t)64 * 1024, 16 * (2 + plain_words)) );
+    load();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+color_row_reader::~color_row_reader()
+{
+    delete stream;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+bool color_row_reader::ensure(const size_t n)
+{
+    if( pos + n <= limit )
+        return true;
+    if( eof == true )
+        return false;
+
+    //
+    // On décale les données restantes au début du buffer avant de le recharger
+    //
+    const size_t remaining = limit - pos;
+    std::memmove(buffer.data(), buffer.data() + pos, remaining * sizeof(uint64_t));
+    pos   = 0;
+    limit = remaining;
+
+    const size_t capacity = buffer.size() - limit;
+    const size_t nread    = stream->read_elements(buffer.data() + limit, sizeof(uint64_t), capacity);
+    limit += nread;
+    eof    = (nread != capacity);
+    return (pos + n <= limit);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+size_t color_row_reader::row_words() const
+{
+    if( hybrid == false )
+        return 1 + plain_words;
+    return 2 + row_payload_words( buffer[pos + 1] );
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void color_row_reader::load()
+{
+    valid = ensure( hybrid ? 2 : 1 + plain_words );
+    if( (valid == true) && (hybrid == true) )
+    {
+        if( ensure( row_words() ) == false )
+        {
+            printf("(EE) A color row is truncated (end of file reached)\n");
+            printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+            exit( EXIT_FAILURE );
+        }
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void color_row_reader::next()
+{
+    pos += row_words();
+    load();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t color_row_reader::density() const
+{
+    if( hybrid == true )
+        return row_density(buffer.data() + pos + 1);
+    uint64_t pop = 0;
+    for(uint64_t w = 0; w < plain_words; w += 1)
+        pop += __builtin_popcountll( buffer[pos + 1 + w] );
+    return pop;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void color_row_reader::add_to(color_row_builder& row, const uint64_t offset) const
+{
+    if( hybrid == false )
+        row.add_bitmap(buffer.data() + pos + 1, plain_words, offset);
+    else
+        row.add_row   (buffer.data() + pos + 1, offset);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
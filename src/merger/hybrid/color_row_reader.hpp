@@ -0,0 +1,37 @@
+#pragma once
+#include "color_row.hpp"
+#include "../../files/stream_reader.hpp"
+#include <string>
+
+//
+// Buffered reader of a Step 2 file. Plain files (output of the 64-way merge) hold fixed size
+// rows [minimizer][bitmap words], the other ones hold adaptive rows (see color_row.hpp).
+// The current row is always entirely loaded in the buffer.
+//
+class color_row_reader
+{
+private:
+    stream_reader*        stream;
+    const bool            hybrid;
+    const uint64_t        plain_words;  // bitmap words of a plain row
+    std::vector<uint64_t> buffer;
+    size_t                pos   = 0;
+    size_t                limit = 0;
+    bool                  eof   = false;
+    bool                  valid = false;
+
+    bool   ensure    (const size_t n);
+    size_t row_words () const;
+    void   load      ();
+
+public:
+     color_row_reader(const std::string& filen, const uint64_t n_colors, const bool hybrid, const int fan_in = 1, const uint64_t ram_budget_MB = 0);
+    ~color_row_reader();
+
+    bool     is_valid () const { return valid;       }
+    uint64_t minimizer() const { return buffer[pos]; }
+
+    void     add_to   (color_row_builder& row, const uint64_t offset) const;
+    uint64_t density  () const;
+    void     next     ();
+};
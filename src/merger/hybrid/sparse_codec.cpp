@@ -0,0 +1,156 @@
+#include "sparse_codec.hpp"
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+static inline uint32_t gap_code(const uint32_t gap)
+{
+    // (bytes needed - 1), a null gap (first id = 0) takes 1 byte
+    return (gap < (1U << 8)) ? 0 : (gap < (1U << 16)) ? 1 : (gap < (1U << 24)) ? 2 : 3;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t vbyte_bytes(const uint32_t* ids, const uint64_t count)
+{
+    uint64_t bytes = (count + 3) / 4;
+    uint32_t prev  = 0;
+    for(uint64_t i = 0; i < count; i += 1)
+    {
+        bytes += 1 + gap_code( ids[i] - prev );
+        prev   = ids[i];
+    }
+    return bytes;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t vbyte_encode(const uint32_t* ids, const uint64_t count, uint8_t* dst)
+{
+    uint8_t* ctrl = dst;
+    uint8_t* data = ctrl + (count + 3) / 4;
+    uint32_t prev = 0;
+    for(uint64_t i = 0; i < count; i += 1)
+    {
+        const uint32_t gap  = ids[i] - prev;
+        const uint32_t code = gap_code( gap );
+        ctrl[i / 4] |= code << (2 * (i % 4));
+        std::memcpy(data, &gap, code + 1); // little endian
+        data += code + 1;
+        prev  = ids[i];
+    }
+    return data - dst;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+#if defined(__SSSE3__)
+//
+// For each control byte : the shuffle spreading its 4 gaps over 4 lanes of 32 bits, and the
+// number of data bytes they take
+//
+struct vbyte_tables
+{
+    alignas(16) uint8_t shuffle[256][16];
+                uint8_t length [256];
+
+    vbyte_tables()
+    {
+        for(int c = 0; c < 256; c += 1)
+        {
+            uint8_t pos = 0;
+            for(int lane = 0; lane < 4; lane += 1)
+            {
+                const int len = ((c >> (2 * lane)) & 3) + 1;
+                for(int b = 0; b < 4; b += 1)
+                    shuffle[c][4 * lane + b] = (b < len) ? pos++ : 0x80;
+            }
+            length[c] = pos;
+        }
+    }
+};
+static const vbyte_tables tables;
+#endif
+
+void vbyte_decode(const uint8_t* src, const uint64_t n_bytes, const uint64_t count, uint32_t* ids)
+{
+    const uint8_t* ctrl = src;
+    const uint8_t* data = ctrl + (count + 3) / 4;
+    const uint8_t* end  = ctrl + n_bytes;
+    uint32_t       prev = 0;
+    uint64_t       i    = 0;
+
+#if defined(__SSSE3__)
+    //
+    // 4 gaps per control byte, as long as a 16-byte load stays inside the payload
+    //
+    __m128i last = _mm_setzero_si128();
+    while( (i + 4 <= count) && (data + 16 <= end) )
+    {
+        const uint8_t c = ctrl[i / 4];
+        __m128i v = _mm_loadu_si128( (const __m128i*)data );
+        v = _mm_shuffle_epi8(v, _mm_load_si128( (const __m128i*)tables.shuffle[c] ));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4)); // prefix sum of the 4 gaps
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, last);
+        _mm_storeu_si128((__m128i*)(ids + i), v);
+        last  = _mm_shuffle_epi32(v, 0xFF);
+        data += tables.length[c];
+        i    += 4;
+    }
+    if( i != 0 )
+        prev = ids[i - 1];
+#endif
+
+    for(; i < count; i += 1)
+    {
+        const uint32_t len = ((ctrl[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        uint32_t gap = 0;
+        std::memcpy(&gap, data, len);
+        data  += len;
+        prev  += gap;
+        ids[i] = prev;
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t vbyte_write_row(const uint32_t* ids, const uint64_t count, uint64_t* row)
+{
+    const uint64_t bytes = vbyte_bytes(ids, count);
+    const uint64_t extra = vbyte_extra_words_of( bytes );
+    if( (count > VBYTE_MAX_COUNT) || (extra > VBYTE_MAX_EXTRA) )
+        return 0;
+
+    for(uint64_t w = 0; w <= extra; w += 1)
+        row[w] = 0;
+    vbyte_encode(ids, count, (uint8_t*)row + 5); // little endian : bytes 5..7 of the header
+    row[0] |= count | (extra << 24);
+    return 1 + extra;
+}
+
+uint64_t vbyte_read_row(const uint64_t* row, uint32_t* ids)
+{
+    const uint64_t count = vbyte_count      ( row[0] );
+    const uint64_t extra = vbyte_extra_words( row[0] );
+    vbyte_decode((const uint8_t*)row + 5, 3 + 8 * extra, count, ids);
+    return count;
+}
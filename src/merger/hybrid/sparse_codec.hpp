@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+
+//
+// Variable width coding of the sorted color ids of a sparse row, StreamVByte style. The ids
+// are stored as gaps (the first one counted from color 0), each gap on 1 to 4 bytes :
+//
+//   [control bytes : 2 bits per gap, (len - 1), 4 gaps per byte LSB first][data bytes]
+//
+// A final row of this layout is [minimizer][header][extra words], the byte stream starting in
+// the 3 upper bytes of the header so that the rows of 1 or 2 colors take no extra word :
+//
+//   header = count | extra << 24 | first 3 bytes of the stream << 40
+//
+// Decoding reads the gaps of 4 ids with a single shuffle when SSSE3 is available.
+//
+static constexpr uint64_t VBYTE_MAX_COUNT = (1ULL << 24) - 1;
+static constexpr uint64_t VBYTE_MAX_EXTRA = (1ULL << 16) - 1;
+
+inline uint64_t vbyte_count      (const uint64_t header) { return header & VBYTE_MAX_COUNT;           }
+inline uint64_t vbyte_extra_words(const uint64_t header) { return (header >> 24) & VBYTE_MAX_EXTRA;   }
+
+//
+// Stream bytes of count sorted ids, words of the row after the header
+//
+extern uint64_t vbyte_bytes (const uint32_t* ids, const uint64_t count);
+
+inline uint64_t vbyte_extra_words_of(const uint64_t bytes) { return (bytes > 3) ? (bytes - 3 + 7) / 8 : 0; }
+
+//
+// Writes the stream of count sorted ids to dst (zeroed by the caller), returns its size
+//
+extern uint64_t vbyte_encode(const uint32_t* ids, const uint64_t count, uint8_t* dst);
+
+//
+// Decodes the count ids of a stream of n_bytes bytes
+//
+extern void     vbyte_decode(const uint8_t* src, const uint64_t n_bytes, const uint64_t count, uint32_t* ids);
+
+//
+// Row level helpers, row points to the header. vbyte_write_row returns the words written
+// (header included) or 0 when the ids do not fit the header fields
+//
+extern uint64_t vbyte_write_row (const uint32_t* ids, const uint64_t count, uint64_t* row);
+extern uint64_t vbyte_read_row  (const uint64_t* row, uint32_t* ids);
@@ -0,0 +1,333 @@
+#include "tier_policy.hpp"
+#include "sparse_codec.hpp"
+#include <algorithm>
+
+static uint64_t bits_needed(const uint64_t value)
+{
+    return 64 - __builtin_clzll( std::max(value, (uint64_t)1) );
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+const char* tier_name(const int tier)
+{
+    switch( tier )
+    {
+        case TIER_SPARSE     : return "sparse";
+        case TIER_DELTA      : return "delta";
+        case TIER_DENSE      : return "dense";
+        default              : return "complement";
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t tier_policy::list_words(const uint64_t d) const
+{
+    const uint64_t granularity = 64 / sparse_bits;
+    return (d + granularity) / granularity; // the list size shares the first word
+}
+
+uint64_t tier_policy::sparse_words(const uint64_t d) const
+{
+    if( sparse_vbyte == false )
+        return list_words( d );
+    const uint64_t mean_gap  = n_colors / std::max(d, (uint64_t)1);
+    const uint64_t gap_bytes = std::min((bits_needed( mean_gap ) + 7) / 8, (uint64_t)4);
+    return 1 + vbyte_extra_words_of( (d + 3) / 4 + d * gap_bytes );
+}
+
+uint64_t tier_policy::complement_words(const uint64_t d) const
+{
+    return list_words( n_colors - d );
+}
+
+uint64_t tier_policy::delta_words(const uint64_t d) const
+{
+    const uint64_t mean_gap = (n_colors + d - 1) / std::max(d, (uint64_t)1);
+    const uint64_t gap_bits = std::min(bits_needed( mean_gap ) + 1, (uint64_t)32);
+    return 1 + (d * gap_bits + 63) / 64;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+static tier_policy base_policy(const uint64_t level_1, const uint64_t level_2)
+{
+    tier_policy p;
+    p.n_colors     = level_1 + level_2;
+    p.level_1      = level_1;
+    p.bitmap_words = (level_1 + 63) / 64 + (level_2 + 63) / 64;
+    p.sparse_vbyte = false;
+
+    const uint64_t bits = bits_needed( p.n_colors - 1 );
+    if      (bits <=  8) p.sparse_bits =  8;
+    else if (bits <= 16) p.sparse_bits = 16;
+    else if (bits <= 32) p.sparse_bits = 32;
+    else                 p.sparse_bits = 64;
+    return p;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+tier_policy tier_policy::legacy(const uint64_t level_1, const uint64_t level_2)
+{
+    tier_policy p = base_policy(level_1, level_2);
+    const uint64_t granularity = 64 / p.sparse_bits;
+    p.sparse_max     = (p.bitmap_words - 1) * granularity - 1; // -1 because we encode listsize aswell
+    p.delta_max      = p.sparse_max;
+    p.complement_min = p.n_colors + 1;
+    return p;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+static void set_thresholds(tier_policy& p, const bool use_delta, const bool use_complement)
+{
+    const uint64_t W = p.bitmap_words;
+
+    //
+    // Cheapest representation of each density, the bitmap wins ties so that the sparse tier
+    // matches the legacy split when the other tiers are disabled
+    //
+    auto best = [&](const uint64_t d) {
+        int      tier = TIER_DENSE;
+        uint64_t cost = W;
+        if(                   p.sparse_words    (d) < cost ){ tier = TIER_SPARSE;     cost = p.sparse_words    (d); }
+        if( use_delta      && p.delta_words     (d) < cost ){ tier = TIER_DELTA;      cost = p.delta_words     (d); }
+        if( use_complement && p.complement_words(d) < cost ){ tier = TIER_COMPLEMENT; cost = p.complement_words(d); }
+        return tier;
+    };
+
+    //
+    // Tiers have to be contiguous ranges : once the delta lists win, the densities where the
+    // sparse lists are back in front (rounding) stay in the delta tier. A density that does
+    // not fit anywhere is sent to the bitmaps, which are never larger than expected
+    //
+    uint64_t d = 1;
+    while( (d <= p.n_colors) && (best(d) == TIER_SPARSE) ) d += 1;
+    p.sparse_max = d - 1;
+    if( use_delta == true )
+        while( (d <= p.n_colors) && (best(d) != TIER_DENSE) && (best(d) != TIER_COMPLEMENT) ) d += 1;
+    p.delta_max  = d - 1;
+
+    uint64_t c = p.n_colors;
+    while( (c > p.delta_max) && (best(c) == TIER_COMPLEMENT) ) c -= 1;
+    p.complement_min = c + 1;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+tier_policy tier_policy::from_histogram(const uint64_t level_1, const uint64_t level_2, const std::vector<uint64_t>& histo, const bool sparse_vbyte,
+                                       const double min_fraction)
+{
+    uint64_t n_rows = 0;
+    for(uint64_t v : histo) n_rows += v;
+    if( n_rows == 0 )
+        return legacy(level_1, level_2);
+
+    tier_policy p  = base_policy(level_1, level_2);
+    p.sparse_vbyte = sparse_vbyte;
+
+    auto rows_of = [&](const int tier) {
+        uint64_t n = 0;
+        for(uint64_t d = 0; d < histo.size(); d += 1)
+            if( p.tier_of(d) == tier ) n += histo[d];
+        return n;
+    };
+
+    bool use_delta      = true;
+    bool use_complement = true;
+    set_thresholds(p, use_delta, use_complement);
+
+    const double min_rows = min_fraction * (double)n_rows;
+    if( (double)rows_of(TIER_DELTA     ) < min_rows ) use_delta      = false;
+    if( (double)rows_of(TIER_COMPLEMENT) < min_rows ) use_complement = false;
+    if( (use_delta == false) || (use_complement == false) )
+        set_thresholds(p, use_delta, use_complement);
+
+    return p;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t tier_policy::payload_words(const int tier, const uint64_t* payload) const
+{
+    const uint64_t header = payload[0];
+    switch( tier )
+    {
+        case TIER_DENSE      : return bitmap_words;
+        case TIER_DELTA      : return 1 + (header >> 40);
+        case TIER_SPARSE     : if( sparse_vbyte ) return 1 + vbyte_extra_words( header );
+                               [[fallthrough]];
+        default              : return list_words( header >> (64 - sparse_bits) );
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void tier_policy::decode(const int tier, const uint64_t* payload, std::vector<uint32_t>& ids) const
+{
+    ids.clear();
+    const uint64_t header = payload[0];
+
+    if( tier == TIER_DENSE )
+    {
+        //
+        // The colors of the 2nd input start at word (level_1+63)/64 of the bitmap
+        //
+        const uint64_t shift = 64 * ((level_1 + 63) / 64) - level_1;
+        for(uint64_t w = 0; w < bitmap_words; w += 1)
+        {
+            uint64_t word = payload[w];
+            while( word != 0 )
+            {
+                const uint64_t bit = 64 * w + __builtin_ctzll( word );
+                ids.push_back( (bit < level_1) ? bit : bit - shift );
+                word &= word - 1;
+            }
+        }
+    }
+    else if( tier == TIER_DELTA )
+    {
+        const uint64_t gap_bits = (header >> 32) & 0xFF;
+        const uint64_t count    = header & 0xFFFFFFFF;
+        const uint64_t mask     = (gap_bits == 64) ? ~0ULL : (1ULL << gap_bits) - 1;
+        const uint64_t* gaps    = payload + 1;
+        uint64_t bit  = 0;
+        uint64_t prev = 0;
+        for(uint64_t i = 0; i < count; i += 1)
+        {
+            const uint64_t sh = bit & 63;
+            uint64_t gap = gaps[bit >> 6] >> sh;
+            if( sh + gap_bits > 64 )
+                gap |= gaps[(bit >> 6) + 1] << (64 - sh);
+            prev += gap & mask;
+            ids.push_back( prev );
+            bit  += gap_bits;
+        }
+    }
+    else if( (tier == TIER_SPARSE) && (sparse_vbyte == true) )
+    {
+        ids.resize( vbyte_count(header) );
+        vbyte_read_row(payload, ids.data());
+    }
+    else
+    {
+        //
+        // Fixed width list, the size shares the first word and the ids are sent MSB first
+        //
+        const uint64_t granularity = 64 / sparse_bits;
+        const uint64_t mask        = (sparse_bits == 64) ? ~0ULL : (1ULL << sparse_bits) - 1;
+        const uint64_t count       = header >> (64 - sparse_bits);
+        for(uint64_t i = 1; i <= count; i += 1)
+        {
+            const uint64_t shift = (granularity - (i % granularity) - 1) * sparse_bits;
+            ids.push_back( (payload[i / granularity] >> shift) & mask );
+        }
+
+        if( tier == TIER_COMPLEMENT )
+        {
+            std::vector<uint32_t> absent;
+            absent.swap( ids );
+            uint64_t next = 0;
+            for(const uint32_t a : absent)
+            {
+                for(; next < a; next += 1) ids.push_back( next );
+                next = (uint64_t)a + 1;
+            }
+            for(; next < n_colors; next += 1) ids.push_back( next );
+        }
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void tier_policy::print() const
+{
+    printf("[III] - color tiers : %lu colors, %lu bitmap words, %lu-bit ids, %s sparse lists\n", n_colors, bitmap_words, sparse_bits,
+           sparse_vbyte ? "vbyte" : "fixed");
+    printf("[III]   - sparse     : 1 .. %lu\n", sparse_max);
+    if( delta_max > sparse_max )
+        printf("[III]   - delta      : %lu .. %lu\n", sparse_max + 1, delta_max);
+    printf("[III]   - dense      : %lu .. %lu\n", delta_max + 1, std::min(complement_min - 1, n_colors));
+    if( complement_min <= n_colors )
+        printf("[III]   - complement : %lu .. %lu\n", complement_min, n_colors);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void tier_policy::write_manifest(const std::string& filen, const std::vector<std::string>& files, const std::vector<uint64_t>& rows,
+                                 const std::vector<uint64_t>& min_colors, const std::vector<uint64_t>& max_colors,
+                                 const std::string& class_table) const
+{
+    FILE* f = fopen(filen.c_str(), "w");
+    if( f == NULL )
+    {
+        printf("(EE) An error happened when opening the manifest file (%s)\n", filen.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        exit( EXIT_FAILURE );
+    }
+
+    const uint64_t low [N_TIERS] = { 1, sparse_max + 1, delta_max + 1, complement_min };
+    const uint64_t high[N_TIERS] = { sparse_max, delta_max, std::min(complement_min - 1, n_colors), n_colors };
+
+    fprintf(f, "colors %lu\n",       n_colors    );
+    fprintf(f, "bitmap_words %lu\n", bitmap_words);
+    fprintf(f, "colors_1 %lu\n",     level_1     ); // the colors of the 2nd input start at this id in the lists
+    fprintf(f, "dense_offset %lu\n", (level_1 + 63) / 64); // and at this word in the bitmaps
+    fprintf(f, "sparse_bits %lu\n",  sparse_bits );
+    fprintf(f, "sparse_codec %s\n", sparse_vbyte ? "vbyte" : "fixed");
+    if( class_table.empty() == false )
+        fprintf(f, "dense_classes %s\n", class_table.c_str());
+    fprintf(f, "# tier min_colors max_colors rows file (color counts of the rows of the file)\n");
+    for(int t = 0; t < N_TIERS; t += 1)
+    {
+        if( low[t] > high[t] )
+            continue; // tier disabled
+        if( rows[t] == 0 )
+            fprintf(f, "%s - - 0 -\n", tier_name(t));
+        else
+            fprintf(f, "%s %lu %lu %lu %s\n", tier_name(t), min_colors[t], max_colors[t], rows[t], files[t].empty() ? "-" : files[t].c_str());
+    }
+    fclose( f );
+}
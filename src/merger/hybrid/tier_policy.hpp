@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// Split of the final minimizer-colors rows into representation tiers, chosen from the number
+// of colors d of each row (N colors in total, W bitmap words per dense row) :
+//
+//  - TIER_SPARSE     : d <= sparse_max             list of ids, [header = d << (64-bits)][ids MSB first]
+//                                                  or when sparse_vbyte is set, variable width gaps
+//                                                  [header = d | extra << 24 | stream][StreamVByte
+//                                                  stream] (see sparse_codec.hpp)
+//  - TIER_DELTA      : d <= delta_max              gaps between sorted ids, fixed width per row,
+//                                                  [header = words << 40 | gap_bits << 32 | d][gaps LSB first]
+//  - TIER_DENSE      : otherwise                   bitmap of W words
+//  - TIER_COMPLEMENT : d >= complement_min         sparse list of the N - d absent colors
+//
+// The thresholds come from the payload size of each representation, a tier is only kept when
+// the color-count histogram says it is worth a file of its own.
+//
+static constexpr int TIER_SPARSE     = 0;
+static constexpr int TIER_DELTA      = 1;
+static constexpr int TIER_DENSE      = 2;
+static constexpr int TIER_COMPLEMENT = 3;
+static constexpr int N_TIERS         = 4;
+
+struct tier_policy
+{
+    uint64_t n_colors;        // N
+    uint64_t level_1;         // colors of the first input, file 2 bitmap starts at word (level_1+63)/64
+    uint64_t bitmap_words;    // W
+    uint64_t sparse_bits;     // bits per id in the sparse and complement lists (8/16/32/64)
+    uint64_t sparse_max;
+    uint64_t delta_max;       // == sparse_max when the delta tier is disabled
+    uint64_t complement_min;  // >  n_colors when the complement tier is disabled
+    bool     sparse_vbyte;    // codec of the sparse tier, the complement lists keep the fixed width
+
+    int tier_of(const uint64_t density) const
+    {
+        if( density <= sparse_max     ) return TIER_SPARSE;
+        if( density <= delta_max      ) return TIER_DELTA;
+        if( density >= complement_min ) return TIER_COMPLEMENT;
+        return TIER_DENSE;
+    }
+
+    //
+    // Payload words (header included) of each representation for a row of d colors
+    //
+    uint64_t list_words      (const uint64_t d) const; // fixed width list
+    uint64_t sparse_words    (const uint64_t d) const; // estimation for the vbyte lists
+    uint64_t delta_words     (const uint64_t d) const; // estimation, assumes evenly spread ids
+    uint64_t complement_words(const uint64_t d) const;
+
+    //
+    // The split used up to now : sparse lists while smaller than the bitmap, dense otherwise
+    //
+    static tier_policy legacy        (const uint64_t level_1, const uint64_t level_2);
+
+    //
+    // histo[d] = number of rows having d colors, tiers holding less than min_fraction of the
+    // rows are folded into their neighbour
+    //
+    static tier_policy from_histogram(const uint64_t level_1, const uint64_t level_2,
+                                      const std::vector<uint64_t>& histo, const bool sparse_vbyte = false,
+                                      const double min_fraction = 0.001);
+
+    //
+    // Row payload (the words following the minimizer) of a tier : its size in words, and the
+    // color ids it holds, in increasing order
+    //
+    uint64_t payload_words(const int tier, const uint64_t* payload) const;
+    void     decode       (const int tier, const uint64_t* payload, std::vector<uint32_t>& ids) const;
+
+    void print() const;
+
+    //
+    // Plain text description of the final index (color counts, rows and file of each tier).
+    // The color counts are the ones found in the files (see merge_level_hybrid_final), the
+    // dense file also holds the delta and vbyte rows too long for their tier. When the dense
+    // rows are stored as color classes, files[TIER_DENSE] is the class id stream and
+    // class_table the table of distinct bitmaps
+    //
+    void write_manifest(const std::string& filen, const std::vector<std::string>& files, const std::vector<uint64_t>& rows,
+                        const std::vector<uint64_t>& min_colors, const std::vector<uint64_t>& max_colors,
+                        const std::string& class_table = "") const;
+};
+
+extern const char* tier_name(const int tier);
@@ -0,0 +1,291 @@
+#include "merger_level_hybrid_final.hpp"
+#include "../hybrid/color_row_reader.hpp"
+#include "../hybrid/sparse_codec.hpp"
+#include "../../files/stream_writer_library.hpp"
+
+//
+// Write buffer of a tier
+//
+class tier_output
+{
+public:
+    stream_writer* file = nullptr;
+    uint64_t*      buff = nullptr;
+    uint64_t       size = 0;
+    uint64_t       used = 0;
+    uint64_t       rows = 0;
+    uint64_t       low  = UINT64_MAX; // color counts of the rows written
+    uint64_t       high = 0;
+
+    void open(const std::string& filen, const uint64_t words)
+    {
+        file = stream_writer_library::allocate( filen );
+        size = words;
+        buff = new uint64_t[size];
+    }
+
+    uint64_t* reserve(const uint64_t words, const uint64_t density)
+    {
+        if( used + words > size )
+        {
+            file->write_elements(buff, sizeof(uint64_t), used);
+            used = 0;
+        }
+        rows += 1;
+        low   = std::min(low,  density);
+        high  = std::max(high, density);
+        return buff + used;
+    }
+
+    void close()
+    {
+        if( file == nullptr )
+            return;
+        file->write_elements(buff, sizeof(uint64_t), used);
+        delete file;
+        delete [] buff;
+        file = nullptr;
+    }
+};
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+std::vector<uint64_t> final_color_histogram(
+        const std::string& ifile_1,
+        const std::string& ifile_2,
+        const int level_1,
+        const int level_2)
+{
+    std::vector<uint64_t> histo(level_1 + level_2 + 1, 0);
+
+    color_row_reader fin_1(ifile_1, level_1, true);
+    color_row_reader fin_2(ifile_2, level_2, true);
+
+    while( fin_1.is_valid() || fin_2.is_valid() )
+    {
+        uint64_t curr_value;
+        if( fin_1.is_valid() && fin_2.is_valid() ) curr_value = std::min(fin_1.minimizer(), fin_2.minimizer());
+        else if( fin_1.is_valid()                ) curr_value = fin_1.minimizer();
+        else                                       curr_value = fin_2.minimizer();
+
+        uint64_t density = 0; // color sets of the 2 files are disjoint
+        if( fin_1.is_valid() && (fin_1.minimizer() == curr_value) ){ density += fin_1.density(); fin_1.next(); }
+        if( fin_2.is_valid() && (fin_2.minimizer() == curr_value) ){ density += fin_2.density(); fin_2.next(); }
+        histo[density] += 1;
+    }
+    return histo;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+std::vector<uint64_t> merge_level_hybrid_final(
+    /*
+        Merges 2 files of adaptive color rows
+        splitting the rows into the tiers of the policy
+    */
+        const std::string& ifile_1, // bigger
+        const std::string& ifile_2, // smaller
+        const std::vector<std::string>& o_files,
+        const tier_policy& policy,
+        const int level_1,
+        const int level_2,
+        std::vector<uint64_t>& min_colors,
+        std::vector<uint64_t>& max_colors)
+{
+    const uint64_t n_u64_per_cols_1 = (level_1+63) / 64;
+    const uint64_t n_u64_per_cols   = policy.bitmap_words;
+
+    const uint64_t total_colors       = policy.n_colors;
+    const uint64_t sparse_colors_bits = policy.sparse_bits;
+    const uint64_t granularity        = 64 / sparse_colors_bits;
+
+    //
+    // Dans le bitmap de sortie les couleurs du fichier 2 commencent au mot n_u64_per_cols_1,
+    // alors que dans les listes elles commencent à level_1
+    //
+    const bool     aligned        = ((uint64_t)level_1 == 64 * n_u64_per_cols_1);
+    const uint64_t dense_shift    = 64 * n_u64_per_cols_1 - level_1;
+
+    //
+    // Only the tiers that can receive rows get a file, a delta or vbyte row too long for its
+    // tier falls back to the bitmaps
+    //
+    const bool has_tier[N_TIERS] = {
+        policy.sparse_max     >= 1,
+        policy.delta_max      >  policy.sparse_max,
+        true,
+        policy.complement_min <= total_colors
+    };
+
+    const uint64_t max_row = 2 + n_u64_per_cols; // no tier is larger than the bitmap
+    tier_output out[N_TIERS];
+    for(int t = 0; t < N_TIERS; t += 1)
+        if( has_tier[t] == true )
+            out[t].open(o_files[t], std::max((uint64_t)10240, max_row * 1024));
+
+    color_row_reader fin_1(ifile_1, level_1, true);
+    color_row_reader fin_2(ifile_2, level_2, true);
+
+    //
+    // Sparse list of ids, the list size shares the first word (values are sent MSB first)
+    //
+    auto write_list = [&](tier_output& o, const uint64_t minimizer, const uint64_t density, const uint64_t count, auto&& for_each_id)
+    {
+        uint64_t* dst = o.reserve( 1 + (count + granularity) / granularity, density );
+        uint64_t  n   = 0;
+        dst[n++] = minimizer;
+        dst[n++] = count << (64 - sparse_colors_bits);
+        uint64_t cnt = 1;
+        for_each_id([&](const uint64_t color) {
+            const uint64_t shift = (granularity - (cnt & (granularity - 1)) - 1) * sparse_colors_bits;
+            if ((cnt & (granularity - 1)) == 0) {
+                // = if (cnt % granularity == 0)
+                dst[n++] = (color << shift);
+            } else {
+                dst[n - 1] |= (color << shift);
+            }
+            cnt++;
+        });
+        o.used += n;
+    };
+
+    auto write_dense = [&](const uint64_t minimizer, color_row_builder& row)
+    {
+        uint64_t* dst = out[TIER_DENSE].reserve( 1 + n_u64_per_cols, row.density() );
+        dst[0] = minimizer;
+        if( aligned == true )
+        {
+            row.write_bitmap(dst + 1, n_u64_per_cols);
+        }
+        else
+        {
+            uint64_t* bitmap = dst + 1;
+            for(uint64_t c = 0; c < n_u64_per_cols; c += 1)
+                bitmap[c] = 0;
+            row.for_each_color([&](const uint32_t color) {
+                const uint64_t bit = (color < (uint64_t)level_1) ? color : color + dense_shift;
+                bitmap[bit >> 6] |= (1ULL << (bit & 63));
+            });
+        }
+        out[TIER_DENSE].used += 1 + n_u64_per_cols;
+    };
+
+    color_row_builder     row( total_colors );
+    std::vector<uint32_t> ids;
+    while( fin_1.is_valid() || fin_2.is_valid() )
+    {
+        uint64_t curr_value;
+        if( fin_1.is_valid() && fin_2.is_valid() ) curr_value = std::min(fin_1.minimizer(), fin_2.minimizer());
+        else if( fin_1.is_valid()                ) curr_value = fin_1.minimizer();
+        else                                       curr_value = fin_2.minimizer();
+
+        row.clear();
+        if( fin_1.is_valid() && (fin_1.minimizer() == curr_value) ){ fin_1.add_to(row, 0      ); fin_1.next(); }
+        if( fin_2.is_valid() && (fin_2.minimizer() == curr_value) ){ fin_2.add_to(row, level_1); fin_2.next(); }
+
+        const uint64_t density = row.density();
+        const int      tier    = policy.tier_of( density );
+
+        if( (tier == TIER_SPARSE) && (policy.sparse_vbyte == true) )
+        {
+            ids.clear();
+            row.for_each_color([&](const uint32_t color) { ids.push_back( color ); });
+            const uint64_t extra = vbyte_extra_words_of( vbyte_bytes(ids.data(), density) );
+
+            if( (1 + extra >= n_u64_per_cols) || (density > VBYTE_MAX_COUNT) || (extra > VBYTE_MAX_EXTRA) )
+            {
+                write_dense(curr_value, row);
+                continue;
+            }
+
+            uint64_t* dst = out[TIER_SPARSE].reserve( 2 + extra, density );
+            dst[0] = curr_value;
+            out[TIER_SPARSE].used += 1 + vbyte_write_row(ids.data(), density, dst + 1);
+        }
+        else if( tier == TIER_SPARSE )
+        {
+            write_list(out[TIER_SPARSE], curr_value, density, density, [&](auto&& emit) {
+                row.for_each_color([&](const uint32_t color) { emit( color ); });
+            });
+        }
+        else if( tier == TIER_COMPLEMENT )
+        {
+            write_list(out[TIER_COMPLEMENT], curr_value, density, total_colors - density, [&](auto&& emit) {
+                uint64_t next = 0;
+                row.for_each_color([&](const uint32_t color) {
+                    for(; next < color; next += 1) emit( next );
+                    next = (uint64_t)color + 1;
+                });
+                for(; next < total_colors; next += 1) emit( next );
+            });
+        }
+        else if( tier == TIER_DELTA )
+        {
+            //
+            // Width of the gaps is fixed by the largest one of the row (the first gap is
+            // counted from color 0)
+            //
+            uint64_t max_gap = 0;
+            uint64_t prev    = 0;
+            row.for_each_color([&](const uint32_t color) {
+                max_gap = std::max(max_gap, color - prev);
+                prev    = color;
+            });
+            const uint64_t gap_bits = 64 - __builtin_clzll( std::max(max_gap, (uint64_t)1) );
+            const uint64_t n_words  = (density * gap_bits + 63) / 64;
+
+            if( 1 + n_words >= n_u64_per_cols )
+            {
+                write_dense(curr_value, row);
+                continue;
+            }
+
+            uint64_t* dst = out[TIER_DELTA].reserve( 2 + n_words, density );
+            dst[0] = curr_value;
+            dst[1] = (n_words << 40) | (gap_bits << 32) | density;
+            uint64_t* gaps = dst + 2;
+            for(uint64_t w = 0; w < n_words; w += 1)
+                gaps[w] = 0;
+
+            uint64_t bit = 0;
+            prev = 0;
+            row.for_each_color([&](const uint32_t color) {
+                const uint64_t gap = color - prev;
+                const uint64_t sh  = bit & 63;
+                gaps[bit >> 6] |= gap << sh;
+                if( sh + gap_bits > 64 )
+                    gaps[(bit >> 6) + 1] |= gap >> (64 - sh);
+                bit += gap_bits;
+                prev = color;
+            });
+            out[TIER_DELTA].used += 2 + n_words;
+        }
+        else
+        {
+            write_dense(curr_value, row);
+        }
+    }
+
+    std::vector<uint64_t> rows(N_TIERS, 0);
+    min_colors.assign(N_TIERS, 0);
+    max_colors.assign(N_TIERS, 0);
+    for(int t = 0; t < N_TIERS; t += 1)
+    {
+        rows[t] = out[t].rows;
+        if( rows[t] != 0 )
+        {
+            min_colors[t] = out[t].low;
+            max_colors[t] = out[t].high;
+        }
+        out[t].close();
+    }
+    return rows;
+}
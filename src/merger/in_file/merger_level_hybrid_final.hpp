@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../hybrid/tier_policy.hpp"
+
+//
+// Color-count histogram of the final 2-way merge (histo[d] = number of minimizers having d
+// colors), computed without writing anything. It is the input of tier_policy::from_histogram.
+//
+extern std::vector<uint64_t> final_color_histogram(
+        const std::string& ifile_1,
+        const std::string& ifile_2,
+        const int level_1,
+        const int level_2);
+
+//
+// Final 2-way merge of adaptive files (see merger_n_files_hybrid.hpp), splitting the rows
+// into the tiers of the policy. o_files[tier] is the output of each tier, the files of the
+// disabled tiers are not created. Returns the number of rows written in each tier, and their
+// smallest and largest color counts in min_colors / max_colors (0 for an empty tier) : the
+// delta and vbyte rows too long for their tier go to the dense file.
+//
+extern std::vector<uint64_t> merge_level_hybrid_final(
+        const std::string& ifile_1,
+        const std::string& ifile_2,
+        const std::vector<std::string>& o_files,
+        const tier_policy& policy,
+        const int level_1,
+        const int level_2,
+        std::vector<uint64_t>& min_colors,
+        std::vector<uint64_t>& max_colors);
@@ -0,0 +1,90 @@
+#include "merger_level_k.hpp"
+#include "../../files/stream_reader_library.hpp"
+#include "../../files/stream_writer_library.hpp"
+#include "../../sorting/external_sort/loser_tree.hpp"
+
+#include <algorithm>
+#include <memory>
+
+void merge_level_k(
+        const std::vector<std::string>& ifiles,
+        const std::string& o_file,
+        const uint64_t ram_budget_MB)
+{
+    const size_t  k       = ifiles.size();
+    // up to the 512 KB buffers of merge_level_0, at least 32 KB per input
+    const int64_t _iBuff_ = std::max<int64_t>(4 * 1024, std::min<int64_t>(64 * 1024, (ram_budget_MB * 1024 * 1024) / sizeof(uint64_t) / (k + 1)));
+    const int64_t _oBuff_ = 64 * 1024;
+
+    std::vector<std::unique_ptr<stream_reader>> fin( k );
+    std::vector<std::vector<uint64_t>>          in ( k );
+    std::vector<int64_t> nElements( k, 0 ); // nombre d'éléments chargés en mémoire
+    std::vector<int64_t> counter  ( k, 0 ); // nombre de données lues dans le flux
+
+    std::vector<uint64_t> dest( _oBuff_ );
+    int64_t ndst = 0;                       // nombre de données écrites dans le flux
+
+    std::unique_ptr<stream_writer> fdst( stream_writer_library::allocate( o_file ) );
+    if( (fdst == nullptr) || (fdst->is_open() == false) )
+    {
+        printf("(EE) An error occurred while creating the file (%s)\n", o_file.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        exit( EXIT_FAILURE );
+    }
+
+    // The head values are the keys of the tree, equal heads are all consumed before the next value
+    auto tie = [](const size_t a, const size_t b) { return a < b; };
+    loser_tree<decltype(tie)> tree(k, tie);
+
+    for(size_t i = 0; i < k; i += 1)
+    {
+        fin[i].reset( stream_reader_library::allocate( ifiles[i] ) );
+        if( (fin[i] == nullptr) || (fin[i]->is_open() == false) )
+        {
+            printf("(EE) An error occurred while opening the file (%s)\n", ifiles[i].c_str());
+            printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+            exit( EXIT_FAILURE );
+        }
+        in[i].resize( _iBuff_ );
+        nElements[i] = fin[i]->read_elements(in[i].data(), sizeof(uint64_t), _iBuff_);
+        if( nElements[i] != 0 )
+            tree.set(i, in[i][0]);
+    }
+    tree.build();
+
+    uint64_t last_value = 0;
+    bool     first      = true;
+    while( tree.empty() == false )
+    {
+        const size_t   i = tree.top();
+        const uint64_t v = in[i][counter[i]];
+
+        if( (v != last_value) || first )
+        {
+            dest[ndst++] = v;
+            last_value   = v;
+            first        = false;
+            if( ndst == _oBuff_ )
+            {
+                fdst->write(dest.data(), sizeof(uint64_t), ndst);
+                ndst = 0;
+            }
+        }
+
+        counter[i] += 1;
+        if( counter[i] == nElements[i] )
+        {
+            nElements[i] = fin[i]->read_elements(in[i].data(), sizeof(uint64_t), _iBuff_);
+            counter  [i] = 0;
+            if( nElements[i] == 0 )
+            {
+                tree.pop_top();
+                continue;
+            }
+        }
+        tree.replace_top( in[i][counter[i]] );
+    }
+
+    if( ndst != 0 )
+        fdst->write(dest.data(), sizeof(uint64_t), ndst);
+}
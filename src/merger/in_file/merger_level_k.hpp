@@ -0,0 +1,15 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// Single pass k-way merge of sorted and deduplicated minimizer files (the spills of a sample
+// that exceeded its RAM share), the values present in several files are written once. The
+// input buffers share ram_budget_MB.
+//
+extern void merge_level_k(
+        const std::vector<std::string>& ifiles,
+        const std::string& o_file,
+        const uint64_t ram_budget_MB);
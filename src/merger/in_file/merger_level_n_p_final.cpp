@@ -81,7 +81,7 @@ void merge_level_n_p_final(
     uint64_t *in_1 = new uint64_t[_iBuffA_];
     uint64_t *in_2 = new uint64_t[_iBuffB_];
     uint64_t *dest = new uint64_t[_oBuff_ ];
-    uint64_t *dest_sparse = new uint64_t[_oBuff_ ];
+    uint64_t *dest_sparse = new uint64_t[_o_sparse_Buff_ + 2]; // +2 : a sparse row can overshoot the flush test by 2 words
 
     uint64_t nElementsA = 0; // nombre d'éléments chargés en mémoire
     uint64_t nElementsB = 0; // nombre d'éléments chargés en mémoire
@@ -285,10 +285,10 @@ void merge_level_n_p_final(
                 } 
                 else { //encode w/ bitmap
                     dest[ndst++] = v2;
+                    for(int c = 0; c < n_u64_per_cols_1; c +=1)
+                        dest[ndst++] = 0;
                     for(int c = 0; c < n_u64_per_cols_2; c +=1)
                         dest[ndst++] = in_2[counterB + 1 + c];
-                    for(int c = 0; c < n_u64_per_cols_2; c +=1)
-                        dest[ndst++] = 0;
                 }
                 counterB  += (1 + n_u64_per_cols_2);
             }           
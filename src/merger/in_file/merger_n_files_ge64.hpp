@@ -15,4 +15,5 @@
 extern void merge_n_files_greater_than_64_colors(
         const std::vector<std::string>& file_list,
         const int64_t n_in_colors,
-        const std::string& o_file);
+        const std::string& o_file,
+        const uint64_t ram_budget_MB = 0); // memory granted to the read-ahead of the inputs (0 = none)
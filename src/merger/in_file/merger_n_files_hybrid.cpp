@@ -0,0 +1,153 @@
+#include "merger_n_files_hybrid.hpp"
+#include "../hybrid/color_row_reader.hpp"
+#include "../../files/stream_writer_library.hpp"
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+static void merge_color_rows(
+        std::vector<color_row_reader*>& i_files,
+        std::vector<uint64_t>&          offset,
+        const uint64_t                  n_out_colors,
+        const std::string&              o_file)
+{
+    const uint64_t max_row = 2 + (n_out_colors + 63) / 64; // minimizer + entête + bitmap complet
+    const uint64_t _oBuff_ = std::max((uint64_t)64 * 1024, 16 * max_row);
+
+    uint64_t* dest = new uint64_t[_oBuff_];
+    uint64_t  ndst = 0;
+
+    stream_writer* fdst = stream_writer_library::allocate( o_file );
+    if( fdst == NULL )
+    {
+        printf("(EE) File does not exist (%s))\n", o_file.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        exit( EXIT_FAILURE );
+    }
+
+    //
+    // On retire les flux vides avant de commencer
+    //
+    for(size_t i = 0; i < i_files.size(); i += 1)
+    {
+        if( i_files[i]->is_valid() == false )
+        {
+            delete i_files[i];
+            i_files.erase( i_files.begin() + i );
+            offset.erase ( offset.begin()  + i );
+            i -= 1;
+        }
+    }
+
+    color_row_builder row( n_out_colors );
+    while( i_files.size() != 0 )
+    {
+        //
+        // On recherche dans tous les flux ouverts la valeur minimum
+        //
+        uint64_t curr_value = i_files[0]->minimizer();
+        for(size_t i = 1; i < i_files.size(); i += 1)
+            curr_value = std::min(curr_value, i_files[i]->minimizer());
+
+        //
+        // Union des couleurs de tous les flux qui partagent ce minimizer
+        //
+        row.clear();
+        for(size_t i = 0; i < i_files.size(); i += 1)
+        {
+            if( i_files[i]->minimizer() != curr_value )
+                continue;
+            i_files[i]->add_to(row, offset[i]);
+            i_files[i]->next();
+            if( i_files[i]->is_valid() == false )
+            {
+                // On est arrivé à la fin du fichier, donc on supprime le flux du processus de fusion...
+                delete i_files[i];
+                i_files.erase( i_files.begin() + i );
+                offset.erase ( offset.begin()  + i );
+                i -= 1;
+            }
+        }
+
+        if( ndst + max_row > _oBuff_ )
+        {
+            fdst->write_elements(dest, sizeof(uint64_t), ndst);
+            ndst = 0;
+        }
+        dest[ndst++] = curr_value;
+        ndst        += row.encode( dest + ndst );
+    }
+
+    //
+    // On flush les données restantes avant de quitter
+    //
+    if( ndst != 0 )
+        fdst->write_elements(dest, sizeof(uint64_t), ndst);
+
+    delete [] dest;
+    delete fdst;    // on détruit le fichier de sortie (fclose)
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void merge_n_files_hybrid(
+        const std::vector<std::string>& file_list,
+        const int64_t n_in_colors,
+        const bool hybrid_inputs,
+        const std::string& o_file,
+        const uint64_t ram_budget_MB)
+{
+    if( n_in_colors < 64 )
+    {
+        printf("(EE) The number of colors of input files is not in the accepted range (< 64)\n");
+        printf("(EE) The current value is : %ld\n", n_in_colors);
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        exit( EXIT_FAILURE );
+    }
+
+    std::vector<color_row_reader*> i_files( file_list.size() );
+    std::vector<uint64_t>          offset ( file_list.size() );
+    for(size_t i = 0; i < file_list.size(); i += 1)
+    {
+        i_files[i] = new color_row_reader(file_list[i], n_in_colors, hybrid_inputs, file_list.size(), ram_budget_MB);
+        offset [i] = i * n_in_colors;
+    }
+
+    merge_color_rows(i_files, offset, n_in_colors * file_list.size(), o_file);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void merge_level_hybrid(
+        const std::string& ifile_1,
+        const std::string& ifile_2,
+        const std::string& o_file,
+        const int level_1,
+        const int level_2)
+{
+    std::vector<color_row_reader*> i_files = {
+        new color_row_reader(ifile_1, level_1, true),
+        new color_row_reader(ifile_2, level_2, true)
+    };
+    std::vector<uint64_t> offset = { 0, (uint64_t)level_1 };
+
+    merge_color_rows(i_files, offset, level_1 + level_2, o_file);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
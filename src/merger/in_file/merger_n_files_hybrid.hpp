@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// n-way merge of Step 2 files producing adaptive color rows (see ../hybrid/color_row.hpp).
+// Input i gets the colors [i * n_in_colors, (i + 1) * n_in_colors). The inputs are plain
+// 64-color files (output of the 64-way merge) when hybrid_inputs is false.
+//
+extern void merge_n_files_hybrid(
+        const std::vector<std::string>& file_list,
+        const int64_t n_in_colors,
+        const bool hybrid_inputs,
+        const std::string& o_file,
+        const uint64_t ram_budget_MB = 0); // memory granted to the read-ahead of the inputs (0 = none)
+
+//
+// 2-way merge of adaptive files, the colors of ifile_2 are placed after the level_1 ones
+//
+extern void merge_level_hybrid(
+        const std::string& ifile_1,
+        const std::string& ifile_2,
+        const std::string& o_file,
+        const int level_1,
+        const int level_2);
@@ -4,7 +4,8 @@
 
 void merge_n_files_less_than_64_colors(
         const std::vector<std::string>& file_list,
-        const std::string& o_file)
+        const std::string& o_file,
+        const uint64_t ram_budget_MB)
 {
     if( (file_list.size() < 1) || (file_list.size() > 64) )
     {
@@ -23,7 +24,7 @@ void merge_n_files_less_than_64_colors(
     std::vector<stream_reader*> i_files (file_list.size());
     for(size_t i = 0; i < file_list.size(); i += 1)
     {
-        stream_reader* f = stream_reader_library::allocate( file_list[i] );
+        stream_reader* f = stream_reader_library::allocate_prefetch( file_list[i], file_list.size(), ram_budget_MB );
         if( f == NULL )
         {
             printf("(EE) File does not exist (%s))\n", file_list[i].c_str());
@@ -1,29 +1,58 @@
 
 #include "../kmer_list/smer_deduplication.hpp"
+#include "../kmer_list/minimizer_hash_set.hpp"
 
-#include "../front/fastx/read_fastx_ATCG_only.hpp"
-#include "../front/fastx_gz/read_fastx_gz_ATCG_only.hpp"
-#include "../front/fastx_bz2/read_fastx_bz2_ATCG_only.hpp"
-#include "../front/fastx_lz4/read_fastx_lz4_ATCG_only.hpp"
+#include <atomic>
+#include <memory>
+
+#include "../front/open_reader_ATCG_only.hpp"
 #include "../front/count_file_lines.hpp"
 
-#include "../hash/CustomMurmurHash3.hpp"
+#include "./minimizer_walk.hpp"
 #include "../back/txt/SaveMiniToTxtFile.hpp"
 #include "../back/raw/SaveRawToFile.hpp"
 
 #include "../sorting/std_2cores/std_2cores.hpp"
 #include "../sorting/std_4cores/std_4cores.hpp"
 #include "../sorting/crumsort_2cores/crumsort_2cores.hpp"
-#include "../merger/in_file/merger_level_0.hpp"
+#include "../sorting/radix_lsd/radix_lsd.hpp"
+#include "../sorting/std_parallel/std_parallel.hpp"
+#include "../sorting/radix_par/radix_par.hpp"
+#include "../merger/in_file/merger_level_k.hpp"
+#include "../tools/CMetrics/CMetrics.hpp"
+#include "../tools/CMemoryBudget/CMemoryBudget.hpp"
 
-#define MEM_UNIT 64
 #define _debug_ 0
 #define _murmurhash_
 
-inline uint64_t mask_right(const uint64_t numbits)
+//
+// Step 1 workers currently in minimizer_processing_v4 : once the small samples are done,
+// the idle threads are lent to the parallel sort (radix_par) of the large ones
+//
+static std::atomic<int> active_workers( 0 );
+
+struct active_worker
+{
+     active_worker() { active_workers.fetch_add(1); }
+    ~active_worker() { active_workers.fetch_sub(1); }
+};
+
+static int lent_threads()
 {
-    uint64_t mask = -(numbits >= MEM_UNIT) | ((1ULL << numbits) - 1ULL);
-    return mask;
+    return std::max(1, omp_get_max_threads() - active_workers.load() + 1);
+}
+
+//
+// Temporary file of a RAM flush, the index goes before the extension so that the flushes
+// and their merges are written in the format of the output file they are renamed to
+//
+static std::string spill_file(const std::string& o_file, const uint64_t index)
+{
+    const size_t dot   = o_file.find_last_of('.');
+    const size_t slash = o_file.find_last_of('/');
+    if( (dot == std::string::npos) || ((slash != std::string::npos) && (dot < slash)) )
+        return o_file + "." + std::to_string( index );
+    return o_file.substr(0, dot) + ".s" + std::to_string( index ) + o_file.substr(dot);
 }
 
 
@@ -35,271 +64,210 @@ void minimizer_processing_v4(
         const bool      file_save_output  = true,
         const bool      file_save_debug   = false,
         const uint64_t  kmer = 31,
-        const uint64_t  mmer = 19
+        const uint64_t  mmer = 19,
+        const std::string& accumulator = "list"
 )
 {
     // =========================================================================
     // 1. SETUP & ALLOCATION
     // =========================================================================
+    const active_worker worker;
     uint64_t buff_size = 2 * 1024 * 1024; // 2MB buffer for reading sequences
-    uint64_t max_in_ram = 1024 * 1024 * (uint64_t)ram_limit_in_MB / sizeof(uint64_t);
-    uint64_t z = kmer - mmer; // Window size for minimizer selection
-    uint64_t mask = mask_right(2 * mmer); 
 
-    // Output Buffer (stores minimizers before flushing/saving)
-    std::vector<uint64_t> liste_mini(max_in_ram);
+    // The accumulator starts with a grain of the process budget and grows while the budget
+    // allows it, up to ram_limit_in_MB (all of it at once when no budget is set)
+    const uint64_t max_bytes = 1024 * 1024 * (uint64_t)ram_limit_in_MB;
+    const uint64_t grain     = (CMemoryBudget::grain() == 0) ? max_bytes : std::min(CMemoryBudget::grain(), max_bytes);
+    CMemoryBudget::lease memory(grain, grain);
+    uint64_t max_in_ram = memory.bytes() / sizeof(uint64_t);
+    if( (accumulator != "list") && (accumulator != "hash") )
+    {
+        printf("(EE) Minimizer accumulator is invalid (%s)\n", accumulator.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        exit( EXIT_FAILURE );
+    }
+    const bool hashed = (accumulator == "hash");
+
+    // A worker grows up to its share of the budget : the Step 1 workers (those waiting for
+    // their first grain included) split the limit, a new file always finds its grain
+    auto share = [&]() -> uint64_t
+    {
+        const uint64_t limit = CMemoryBudget::limit();
+        if( limit == 0 )
+            return max_bytes;
+        return std::min(max_bytes, std::max(grain, limit / std::max(1, active_workers.load())));
+    };
+
+    // Output Buffer (stores minimizers before flushing/saving), the size of the lease
+    std::vector<uint64_t> liste_mini;
+    if( hashed == false ){
+        liste_mini.resize( max_in_ram );
+    }
     uint64_t n_minizer = 0;
+
+    // Deduplicating accumulator, same memory budget (distinct minimizers only)
+    std::unique_ptr<minimizer_hash_set> mini_set( hashed ? new minimizer_hash_set(max_in_ram) : nullptr );
     
     // List of temporary files created during RAM flush
     std::vector<std::string> file_list;
 
-    // =========================================================================
-    // 2. READER INITIALIZATION
-    // =========================================================================
-    // We request an overlap of (kmer - 1) to ensure no k-mer is lost 
-    // when a sequence spans across two file chunks.
-    file_reader_ATCG_only* reader;
+    // The set is full : its sorted content becomes a temporary file
+    auto flush_set = [&]()
+    {
+        if( mini_set->size() == 0 )
+            return;
+        const std::string t_file = spill_file(o_file, file_list.size());
+        uint64_t n_elements = 0;
+        const std::vector<uint64_t>& values = mini_set->sorted( n_elements );
+        SaveRawToFile(t_file, values, n_elements);
+        mini_set->clear();
+        file_list.push_back( t_file );
+    };
 
-    if (i_file.substr(i_file.find_last_of(".") + 1) == "bz2")
+    // The buffer is full : it is sorted, deduplicated and becomes a temporary file
+    auto flush_list = [&]()
     {
-        reader = new read_fastx_bz2_ATCG_only(i_file, buff_size);
-    }
-    else if (i_file.substr(i_file.find_last_of(".") + 1) == "gz")
+        if( n_minizer == 0 )
+            return;
+        const std::string t_file = spill_file(o_file, file_list.size());
+        crumsort_prim( liste_mini.data(), n_minizer, 9 /*uint64*/ );
+        const uint64_t n_elements = smer_deduplication(liste_mini, n_minizer);
+        SaveRawToFile(t_file, liste_mini, n_elements);
+        file_list.push_back( t_file );
+        n_minizer = 0;
+    };
+
+    // The buffer is full : it grows by at least a grain (at most doubles) up to the share of
+    // the worker, it is flushed otherwise. The old buffer is alive during the copy, the lease
+    // covers both until it is freed
+    auto grow_list = [&]() -> bool
     {
-        reader = new read_fastx_gz_ATCG_only(i_file, buff_size);
-    }
-    else if (i_file.substr(i_file.find_last_of(".") + 1) == "lz4")
+        const uint64_t held = memory.bytes();
+        const uint64_t cap  = share();
+        if( held + grain > cap )
+            return false;
+        const uint64_t bytes = memory.grow(held + grain, held + std::min(cap - held, held));
+        if( bytes == 0 )
+            return false;
+        max_in_ram = bytes / sizeof(uint64_t);
+        {
+            std::vector<uint64_t> larger( max_in_ram );
+            std::copy(liste_mini.begin(), liste_mini.begin() + n_minizer, larger.begin());
+            liste_mini.swap( larger );
+        }
+        memory.release( held );
+        return true;
+    };
+
+    // The set doubles its table, the old one is alive during the rehash
+    auto grow_set = [&]() -> bool
     {
-        reader = new read_fastx_lz4_ATCG_only(i_file, buff_size);
-    }
-    else if(
-            (i_file.substr(i_file.find_last_of(".") + 1) == "fastx") ||
-            (i_file.substr(i_file.find_last_of(".") + 1) == "fasta") ||
-            (i_file.substr(i_file.find_last_of(".") + 1) == "fastq") ||
-            (i_file.substr(i_file.find_last_of(".") + 1) == "fna")
-            )
+        const uint64_t table = mini_set->memory();
+        if( (2 * table > share()) || (memory.bytes() >= 3 * table) )
+            return false;
+        const uint64_t need = 3 * table - memory.bytes();
+        if( memory.grow(need, need) == 0 )
+            return false;
+        mini_set->rehash( 2 * table / sizeof(uint64_t) );
+        memory.release( table );
+        return true;
+    };
+
+    // New workers came in and this one holds more than its share : the accumulator is flushed
+    // and what is above the share is given back
+    auto shrink_to_share = [&]()
     {
-        reader = new read_fastx_ATCG_only(i_file, buff_size);
-    }
-    else
+        const uint64_t cap = share();
+        if( memory.bytes() <= cap )
+            return;
+        if( hashed == true ){
+            flush_set();
+            mini_set.reset();
+            memory.release( memory.bytes() - cap );
+            mini_set.reset( new minimizer_hash_set(memory.bytes() / sizeof(uint64_t)) );
+        }else{
+            flush_list();
+            std::vector<uint64_t>().swap( liste_mini );
+            memory.release( memory.bytes() - cap );
+            max_in_ram = memory.bytes() / sizeof(uint64_t);
+            liste_mini.resize( max_in_ram );
+        }
+    };
+    uint64_t n_inserted = 0;
+
+    // =========================================================================
+    // 2. READER INITIALIZATION
+    // =========================================================================
+    std::unique_ptr<file_reader_ATCG_only> reader( open_reader_ATCG_only(i_file, buff_size) );
+    if( reader == nullptr )
     {
         printf("(EE) File extension is not supported (%s)\n", i_file.c_str());
         printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
         exit( EXIT_FAILURE );
     }
-    
-    char*    seq_buffer = nullptr;
-    uint64_t seq_size   = 0;
-
-    bool eof_and_finished = false;
 
     // =========================================================================
     // 3. MAIN PROCESSING LOOP
     // =========================================================================
-    while( true ) {
-
-        // Check if the previous iteration marked global EOF
-        if (eof_and_finished) {
-            break;
-        }
-
-        // Load the initial chunk for this sequence
-        // Returns tuple: <End of File (EOF), End of Sequence (EOS)>
-        std::tuple<bool, bool> tuple_eof_eos = reader->load_next_chunk(&seq_buffer, &seq_size); 
-
-        // ---------------------------------------------------------------------
-        // 3.1. SKIP TINY SEQS
-        // ---------------------------------------------------------------------
-        // If the chunk is smaller than kmer, we can't compute any minimizers.
-        // We loop until we get a valid chunk or hit EOF.
-        while (seq_size < kmer){
-            if (std::get<0>(tuple_eof_eos) == true) { // EOF reached
-                eof_and_finished = true;
-                break;
-            }
-            // Sequence ended (EOS), but was too short. Try next seq.
-            tuple_eof_eos = reader->load_next_chunk(&seq_buffer, &seq_size);
-        }
-
-        if (eof_and_finished) {
-            break;
-        }
-
-        // ---------------------------------------------------------------------
-        // 3.2. INITIALIZE ROLLING HASH (Phase 1: First M-mer)
-        // ---------------------------------------------------------------------
-        // Prepare the sliding window buffer
-        uint64_t hash_window[z + 1]; 
-        for(uint64_t x = 0; x <= z; x += 1)
-            hash_window[x] = UINT64_MAX;
-        
-        uint64_t current_mmer = 0;
-        uint64_t cur_inv_mmer = 0;
-        uint64_t cnt = 0;
-
-        // Prepare the very first m-mer (first 18 bases if m=19)
-        for(uint64_t x = 0; x < mmer - 1; x += 1)
-        {
-            const uint64_t encoded = ((seq_buffer[cnt] >> 1) & 0b11);
-            current_mmer <<= 2;
-            current_mmer |= encoded; // ASCII => 2-bit encoding
-            current_mmer &= mask;
-            cur_inv_mmer >>= 2;
-            cur_inv_mmer |= ( (0x2 ^ encoded) << (2 * (mmer - 1))); 
-            cnt          += 1;
-        }
-
-        // ---------------------------------------------------------------------
-        // 3.3. FILL HASH WINDOW (Phase 2: First K-mer)
-        // ---------------------------------------------------------------------
-        // Compute hashes for the first 'z' m-mers to fill the window and find the first minimizer
-        uint64_t minv = UINT64_MAX;
-        for(uint64_t m_pos = 0; m_pos <= z; m_pos += 1)
-        {
-            const uint64_t encoded = ((seq_buffer[cnt] >> 1) & 0b11); 
-            current_mmer <<= 2;
-            current_mmer |= encoded;
-            current_mmer &= mask;
-            cur_inv_mmer >>= 2;
-            cur_inv_mmer |= ( (0x2 ^ encoded) << (2 * (mmer - 1))); 
-            
-            const uint64_t canon  = (current_mmer < cur_inv_mmer) ? current_mmer : cur_inv_mmer;
-
-            uint64_t tab[2];
-            CustomMurmurHash3_x64_128<8> ( &canon, 42, tab );
-
-            const uint64_t s_hash = tab[0];
-            hash_window[m_pos]    = s_hash; // Store hash in window
-            minv                  = (s_hash < minv) ? s_hash : minv;
-            cnt                   += 1; 
-        }
-
-        // Store the first minimizer found
-        if( n_minizer == 0 ){
-            liste_mini[n_minizer++] = minv;
-        }else if( liste_mini[n_minizer-1] != minv ){
+    // The walk (see minimizer_walk.hpp) hands over the minimizers that differ from the previous one
+    const minimizer_walk_stats stats = minimizer_walk(*reader, kmer, mmer, [&](const uint64_t minv)
+    {
+        if( hashed == true ){
+            mini_set->insert( minv );
+            if( mini_set->full() && (grow_set() == false) )
+                flush_set();
+        }else{
             liste_mini[n_minizer++] = minv;
+            if( (n_minizer == max_in_ram) && (grow_list() == false) )
+                flush_list();
         }
 
-        // ---------------------------------------------------------------------
-        // 3.4. ROLLING HASH LOOP (Phase 3: All other K-mers)
-        // ---------------------------------------------------------------------
-        while ( true ) { // Loop for the rest of the sequence (across chunks)
-            
-            // Process all remaining bases in the CURRENT buffer
-            while (cnt < seq_size) { 
-                const uint64_t encoded = ((seq_buffer[cnt] >> 1) & 0b11); 
-                current_mmer <<= 2;                                     
-                current_mmer |= encoded;
-                current_mmer &= mask;
-                cur_inv_mmer >>= 2;
-                cur_inv_mmer |= ( (0x2 ^ encoded) << (2 * (mmer - 1))); 
-
-                const uint64_t canon  = (current_mmer < cur_inv_mmer) ? current_mmer : cur_inv_mmer;
-
-                uint64_t tab[2];
-                CustomMurmurHash3_x64_128<8> ( &canon, 42, tab );
-
-                const uint64_t s_hash = tab[0];
-                minv                  = (s_hash < minv) ? s_hash : minv;
-
-                // Update Window
-                if( minv == hash_window[0] ) // Outgoing m-mer was the minimum; rescan window
-                {
-                    minv = s_hash;
-                    for(uint64_t p = 0; p < z; p += 1) {
-                        const uint64_t value = hash_window[p + 1];
-                        minv = (minv < value) ? minv : value;
-                        hash_window[p] = value;
-                    }
-                    hash_window[z] = s_hash; 
-                }else{ // Standard shift
-                    for(uint64_t p = 0; p < z; p += 1) {
-                        hash_window[p] = hash_window[p+1]; 
-                    }
-                    hash_window[z] = s_hash; 
-                }
-
-                // Store Minimizer (if new)
-                if( liste_mini[n_minizer-1] != minv ){
-                    liste_mini[n_minizer++] = minv;
-
-                    // Handle RAM overflow
-                    if( n_minizer >= (max_in_ram - 2) )
-                    {
-                        std::string t_file = o_file + "." + std::to_string( file_list.size() );
-                        
-                        // Sort and deduplicate in RAM before flushing
-                        crumsort_prim( liste_mini.data(), n_minizer - 1, 9 /*uint64*/ );
-                        uint64_t n_elements = smer_deduplication(liste_mini, n_minizer - 1);
-
-                        SaveRawToFile(t_file, liste_mini, n_elements - 1);
-
-                        file_list.push_back( t_file );
-                        liste_mini[0] = liste_mini[n_minizer-1]; // Keep last min for continuity
-                        n_minizer     = 1;
-                    }
-                }
-
-                cnt += 1; 
-            }
-
-            // -----------------------------------------------------------------
-            // 3.5. HANDLE CHUNK BOUNDARIES
-            // -----------------------------------------------------------------
-            
-            // If EOF reached, signal to break outer loop
-            if ( std::get<0>(tuple_eof_eos) == true ) {
-                eof_and_finished = true; 
-                break;
-            }
-
-            // If End of Sequence (EOS) reached, prepare for next sequence
-            if ( std::get<1>(tuple_eof_eos) == true ) {
-                break; // Break inner loop to restart Phase 1 for new seq
-            }
-
-            // Load NEXT chunk for the SAME sequence
-            tuple_eof_eos = reader->load_next_chunk(&seq_buffer, &seq_size);
-            
-            // Set 'cnt' to skip the overlap we already processed (first k-1 bases)
-            cnt = 0; 
-        }
-    }
+        // The share is checked every 64K minimizers
+        n_inserted += 1;
+        if( (n_inserted & 0xFFFF) == 0 )
+            shrink_to_share();
+    });
 
 
     // =========================================================================
     // 4. FINALIZATION & SAVING
     // =========================================================================
+    CMetrics::add(MET_BASES,      stats.n_bases);
+    CMetrics::add(MET_MMERS,      stats.n_mmers);
+    CMetrics::add(MET_MINIMIZERS, stats.n_emitted);
     
     // CASE A: Temporary files exist (RAM limit was exceeded)
     if( file_list.size() != 0 )
     {
-        std::string t_file = o_file + "." + std::to_string( file_list.size() );
-        crumsort_prim( liste_mini.data(), n_minizer, 9 );
-
-        uint64_t n_elements = smer_deduplication(liste_mini, n_minizer);
-        SaveRawToFile(t_file, liste_mini, n_elements);
-
-        file_list.push_back( t_file );
-
-        // Merge all temporary files
-        uint64_t name_c = file_list.size();
-        while(file_list.size() > 1)
+        if( hashed == true )
+            flush_set();
+        else
+            flush_list();
+
+        // The accumulator is given back before the merge, which leases its own buffers
+        std::vector<uint64_t>().swap( liste_mini );
+        mini_set.reset();
+        memory.release( memory.bytes() );
+
+        // Merge all temporary files in a single pass
+        if( file_list.size() == 1 )
         {
-            const std::string t_file = o_file + "." + std::to_string( name_c++ );
-            merge_level_0(file_list[0], file_list[1], t_file);
-            std::remove(file_list[0].c_str());
-            std::remove(file_list[1].c_str());
-            file_list.erase(file_list.begin());
-            file_list.erase(file_list.begin());
-            file_list.push_back( t_file );
+            std::rename(file_list[0].c_str(), o_file.c_str());
+        }
+        else
+        {
+            CMemoryBudget::lease merge_memory(1024 * 1024, (file_list.size() + 1) * 512 * 1024);
+            merge_level_k(file_list, o_file, (merge_memory.bytes() + 1024 * 1024 - 1) / (1024 * 1024));
+            for(const std::string& t_file : file_list)
+                std::remove(t_file.c_str());
         }
-        std::rename(file_list[file_list.size()-1].c_str(), o_file.c_str());
         return;
     }
 
     // CASE B: Everything fit in RAM (Direct Save)
+    if( hashed == true ){
+        liste_mini.swap( mini_set->sorted(n_minizer) ); // already sorted and distinct
+    }
     liste_mini.resize(n_minizer);
 
     if( file_save_debug ){
@@ -307,7 +275,9 @@ void minimizer_processing_v4(
     }
 
     // Sorting Selection
-    if( algo == "std::sort" ) {
+    if( hashed == true ) {
+        // sorted by the set
+    } else if( algo == "std::sort" ) {
         std::sort( liste_mini.begin(), liste_mini.end() );
     } else if( algo == "std_2cores" ) {
         std_2cores( liste_mini );
@@ -317,13 +287,20 @@ void minimizer_processing_v4(
         crumsort_prim( liste_mini.data(), liste_mini.size(), 9 );
     } else if( algo == "crumsort_2cores" ) {
         crumsort_2cores( liste_mini );
+    } else if( algo == "radix_lsd" ) {
+        radix_lsd( liste_mini );
+    } else if( algo == "std_parallel" ) {
+        std_parallel( liste_mini );
+    } else if( algo == "radix_par" ) {
+        radix_par( liste_mini, lent_threads() ); // also removes the duplicates
     } else {
         printf("(EE) Sorting algorithm is invalid (%s)\n", algo.c_str());
         exit( EXIT_FAILURE );
     }
 
     // Final Deduplication
-    smer_deduplication( liste_mini );
+    if( (algo != "radix_par") && (hashed == false) )
+        smer_deduplication( liste_mini );
 
     if( file_save_debug ){
         SaveMiniToTxtFile_v2(o_file + ".txt", liste_mini);
@@ -332,6 +309,4 @@ void minimizer_processing_v4(
     if( file_save_output ){
         SaveRawToFile(o_file, liste_mini);
     }
-
-    delete reader;
 }
\ No newline at end of file
@@ -17,5 +17,6 @@ extern void minimizer_processing_v4(
         const bool file_save_output,
         const bool file_save_debug,
         const uint64_t k,
-        const uint64_t m
+        const uint64_t m,
+        const std::string& accumulator = "list"   // list (occurrences) or hash (deduplicated on insertion)
     );
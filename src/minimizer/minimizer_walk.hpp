@@ -0,0 +1,206 @@
+#pragma once
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "../front/file_reader_ATCG_only.hpp"
+#include "../hash/CustomMurmurHash3.hpp"
+
+//
+// Counters of a walk, reported to the metrics by the Step 1
+//
+struct minimizer_walk_stats
+{
+    uint64_t n_bases   = 0;
+    uint64_t n_mmers   = 0;
+    uint64_t n_emitted = 0;
+};
+
+//
+// Walk over all the sequences of a reader : for each k-mer, the minimizer is the smallest
+// hash (MurmurHash3, seed 42) of its canonical m-mers. Consecutive equal minimizers are
+// emitted once, across the sequences too, emit(minimizer) is called for each new value.
+//
+// The Step 1 (minimizer_v4.cpp) and the queries (minimizer_query.cpp) both walk through
+// here, a query minimizer has to match the one computed when building the index.
+//
+template <class EMIT>
+minimizer_walk_stats minimizer_walk(file_reader_ATCG_only& reader, const uint64_t kmer, const uint64_t mmer, EMIT&& emit)
+{
+    const uint64_t z    = kmer - mmer; // Window size for minimizer selection
+    const uint64_t mask = (2 * mmer >= 64) ? UINT64_MAX : ((1ULL << (2 * mmer)) - 1ULL);
+
+    minimizer_walk_stats stats;
+    uint64_t last_min = 0; // last emitted minimizer
+
+    // Sliding window of the m-mer hashes of the current k-mer
+    std::vector<uint64_t> hash_window( z + 1 );
+
+    char*    seq_buffer = nullptr;
+    uint64_t seq_size   = 0;
+
+    bool eof_and_finished = false;
+
+    while( true ) {
+
+        // Check if the previous iteration marked global EOF
+        if (eof_and_finished) {
+            break;
+        }
+
+        // Load the initial chunk for this sequence
+        // Returns tuple: <End of File (EOF), End of Sequence (EOS)>
+        std::tuple<bool, bool> tuple_eof_eos = reader.load_next_chunk(&seq_buffer, &seq_size);
+        stats.n_bases += seq_size;
+
+        // ---------------------------------------------------------------------
+        // 1. SKIP TINY SEQS
+        // ---------------------------------------------------------------------
+        // If the chunk is smaller than kmer, we can't compute any minimizers.
+        // We loop until we get a valid chunk or hit EOF.
+        while (seq_size < kmer){
+            if (std::get<0>(tuple_eof_eos) == true) { // EOF reached
+                eof_and_finished = true;
+                break;
+            }
+            // Sequence ended (EOS), but was too short. Try next seq.
+            tuple_eof_eos = reader.load_next_chunk(&seq_buffer, &seq_size);
+            stats.n_bases += seq_size;
+        }
+
+        if (eof_and_finished) {
+            break;
+        }
+
+        // ---------------------------------------------------------------------
+        // 2. INITIALIZE ROLLING HASH (Phase 1: First M-mer)
+        // ---------------------------------------------------------------------
+        for(uint64_t x = 0; x <= z; x += 1)
+            hash_window[x] = UINT64_MAX;
+
+        uint64_t current_mmer = 0;
+        uint64_t cur_inv_mmer = 0;
+        uint64_t cnt = 0;
+
+        // Prepare the very first m-mer (first 18 bases if m=19)
+        for(uint64_t x = 0; x < mmer - 1; x += 1)
+        {
+            const uint64_t encoded = ((seq_buffer[cnt] >> 1) & 0b11);
+            current_mmer <<= 2;
+            current_mmer |= encoded; // ASCII => 2-bit encoding
+            current_mmer &= mask;
+            cur_inv_mmer >>= 2;
+            cur_inv_mmer |= ( (0x2 ^ encoded) << (2 * (mmer - 1)));
+            cnt          += 1;
+        }
+
+        // ---------------------------------------------------------------------
+        // 3. FILL HASH WINDOW (Phase 2: First K-mer)
+        // ---------------------------------------------------------------------
+        // Compute hashes for the first 'z' m-mers to fill the window and find the first minimizer
+        uint64_t minv = UINT64_MAX;
+        for(uint64_t m_pos = 0; m_pos <= z; m_pos += 1)
+        {
+            const uint64_t encoded = ((seq_buffer[cnt] >> 1) & 0b11);
+            current_mmer <<= 2;
+            current_mmer |= encoded;
+            current_mmer &= mask;
+            cur_inv_mmer >>= 2;
+            cur_inv_mmer |= ( (0x2 ^ encoded) << (2 * (mmer - 1)));
+
+            const uint64_t canon  = (current_mmer < cur_inv_mmer) ? current_mmer : cur_inv_mmer;
+
+            uint64_t tab[2];
+            CustomMurmurHash3_x64_128<8> ( &canon, 42, tab );
+
+            const uint64_t s_hash = tab[0];
+            hash_window[m_pos]    = s_hash; // Store hash in window
+            minv                  = (s_hash < minv) ? s_hash : minv;
+            cnt                   += 1;
+        }
+
+        stats.n_mmers += z + 1;
+
+        // Store the first minimizer found
+        if( (stats.n_emitted == 0) || (last_min != minv) ){
+            emit( minv );
+            last_min         = minv;
+            stats.n_emitted += 1;
+        }
+
+        // ---------------------------------------------------------------------
+        // 4. ROLLING HASH LOOP (Phase 3: All other K-mers)
+        // ---------------------------------------------------------------------
+        while ( true ) { // Loop for the rest of the sequence (across chunks)
+
+            // Process all remaining bases in the CURRENT buffer
+            stats.n_mmers += (cnt < seq_size) ? (seq_size - cnt) : 0;
+            while (cnt < seq_size) {
+                const uint64_t encoded = ((seq_buffer[cnt] >> 1) & 0b11);
+                current_mmer <<= 2;
+                current_mmer |= encoded;
+                current_mmer &= mask;
+                cur_inv_mmer >>= 2;
+                cur_inv_mmer |= ( (0x2 ^ encoded) << (2 * (mmer - 1)));
+
+                const uint64_t canon  = (current_mmer < cur_inv_mmer) ? current_mmer : cur_inv_mmer;
+
+                uint64_t tab[2];
+                CustomMurmurHash3_x64_128<8> ( &canon, 42, tab );
+
+                const uint64_t s_hash = tab[0];
+                minv                  = (s_hash < minv) ? s_hash : minv;
+
+                // Update Window
+                if( minv == hash_window[0] ) // Outgoing m-mer was the minimum; rescan window
+                {
+                    minv = s_hash;
+                    for(uint64_t p = 0; p < z; p += 1) {
+                        const uint64_t value = hash_window[p + 1];
+                        minv = (minv < value) ? minv : value;
+                        hash_window[p] = value;
+                    }
+                    hash_window[z] = s_hash;
+                }else{ // Standard shift
+                    for(uint64_t p = 0; p < z; p += 1) {
+                        hash_window[p] = hash_window[p+1];
+                    }
+                    hash_window[z] = s_hash;
+                }
+
+                // Store Minimizer (if new)
+                if( last_min != minv ){
+                    emit( minv );
+                    last_min         = minv;
+                    stats.n_emitted += 1;
+                }
+
+                cnt += 1;
+            }
+
+            // -----------------------------------------------------------------
+            // 5. HANDLE CHUNK BOUNDARIES
+            // -----------------------------------------------------------------
+
+            // If EOF reached, signal to break outer loop
+            if ( std::get<0>(tuple_eof_eos) == true ) {
+                eof_and_finished = true;
+                break;
+            }
+
+            // If End of Sequence (EOS) reached, prepare for next sequence
+            if ( std::get<1>(tuple_eof_eos) == true ) {
+                break; // Break inner loop to restart Phase 1 for new seq
+            }
+
+            // Load NEXT chunk for the SAME sequence
+            tuple_eof_eos = reader.load_next_chunk(&seq_buffer, &seq_size);
+            stats.n_bases += seq_size;
+
+            // Set 'cnt' to skip the overlap we already processed (first k-1 bases)
+            cnt = 0;
+        }
+    }
+
+    return stats;
+}
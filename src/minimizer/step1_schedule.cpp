@@ -0,0 +1,40 @@
+#include "step1_schedule.hpp"
+#include "../tools/file_stats.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+//
+// Step 1 time per byte on disk, relative to a plain FASTA/FASTQ byte : usual compression
+// ratios of sequencing files, plus the decompression (bzip2 is the slowest by far)
+//
+double step1_cost(const std::string& filen, const uint64_t size_bytes)
+{
+    const std::string ext = filen.substr(filen.find_last_of(".") + 1);
+    double weight = 1.0;
+    if     ( ext == "lz4" ) weight = 3.0;
+    else if( ext == "gz"  ) weight = 4.0;
+    else if( ext == "bz2" ) weight = 6.0;
+    return weight * (double)size_bytes;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+std::vector<size_t> step1_schedule(const std::vector<std::string>& filenames)
+{
+    std::vector<double> cost( filenames.size() );
+    for(size_t i = 0; i < filenames.size(); i += 1)
+    {
+        const file_stats file( filenames[i] );
+        cost[i] = step1_cost(file.name, file.size_bytes);
+    }
+
+    std::vector<size_t> order( filenames.size() );
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b) { return cost[a] > cost[b]; });
+    return order;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// Processing order of the Step 1 files, longest first (LPT). The size of a file on disk is
+// weighted by the cost of its format : a compressed byte holds several bytes of sequence and
+// has to be decompressed. Handed to a dynamic schedule, the large files start first and the
+// small ones fill the gaps at the end, instead of a few large files landing on one thread.
+//
+double step1_cost(const std::string& filen, const uint64_t size_bytes);
+
+std::vector<size_t> step1_schedule(const std::vector<std::string>& filenames);
@@ -0,0 +1,126 @@
+#include "minimizer_query.hpp"
+
+#include "../front/open_reader_ATCG_only.hpp"
+#include "../minimizer/minimizer_walk.hpp"
+#include "../sorting/crumsort/crumsort.hpp"
+#include "../kmer_list/smer_deduplication.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <omp.h>
+
+//
+// Sort + dedup of the minimizers collected so far, the buffer only grows when the distinct
+// values fill more than half of it
+//
+static void compact(std::vector<uint64_t>& minimizers, uint64_t& n_minizer, uint64_t& capacity)
+{
+    if( n_minizer == 0 )
+        return;
+    crumsort_prim( minimizers.data(), n_minizer, 9 /*uint64*/ );
+    n_minizer = smer_deduplication(minimizers, n_minizer);
+    if( 2 * n_minizer > capacity )
+    {
+        capacity *= 2;
+        minimizers.resize( capacity );
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void query_minimizers(const std::string& i_file, const uint64_t kmer, const uint64_t mmer, std::vector<uint64_t>& minimizers)
+{
+    std::unique_ptr<file_reader_ATCG_only> reader( open_reader_ATCG_only(i_file, 2 * 1024 * 1024) );
+    if( reader == nullptr )
+        throw std::runtime_error("File extension is not supported: " + i_file);
+
+    uint64_t capacity  = 1 << 20;
+    uint64_t n_minizer = 0;
+    minimizers.resize( capacity );
+
+    //
+    // Same walk over the sequences as minimizer_processing_v4, a query minimizer has to match
+    // the one computed when building the index
+    //
+    minimizer_walk(*reader, kmer, mmer, [&](const uint64_t minv)
+    {
+        minimizers[n_minizer++] = minv;
+        if( n_minizer == capacity )
+            compact(minimizers, n_minizer, capacity);
+    });
+
+    compact(minimizers, n_minizer, capacity);
+    minimizers.resize( n_minizer );
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t query_hits(minimizer_index& index, const std::vector<uint64_t>& sorted, std::vector<uint64_t>& hits)
+{
+    hits.assign(index.colors(), 0);
+
+    uint64_t found = 0;
+    index.join(sorted.data(), sorted.size(), [&](const uint64_t, const std::vector<uint32_t>& colors) {
+        for(const uint32_t c : colors)
+            hits[c] += 1;
+        found += 1;
+    });
+    return found;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+std::vector<query_result> query_files(const std::string& index_file, const std::vector<std::string>& files,
+                                      const uint64_t kmer, const uint64_t mmer, const int threads)
+{
+    std::vector<query_result> results( files.size() );
+
+    //
+    // Errors are caught in the workers and rethrown once the parallel section is over
+    //
+    std::string error;
+
+#pragma omp parallel num_threads(threads)
+    {
+        std::unique_ptr<minimizer_index> index;
+        std::vector<uint64_t>            minimizers;
+        try {
+            index.reset( new minimizer_index(index_file) );
+        } catch (const std::exception& e) {
+#pragma omp critical
+            error = e.what();
+        }
+
+#pragma omp for schedule(dynamic)
+        for(size_t i = 0; i < files.size(); i += 1)
+        {
+            if( index == nullptr )
+                continue;
+            try {
+                query_minimizers(files[i], kmer, mmer, minimizers);
+                results[i].name       = files[i];
+                results[i].minimizers = minimizers.size();
+                results[i].found      = query_hits(*index, minimizers, results[i].hits);
+            } catch (const std::exception& e) {
+#pragma omp critical
+                error = e.what();
+            }
+        }
+    }
+
+    if( error.empty() == false )
+        throw std::runtime_error( error );
+    return results;
+}
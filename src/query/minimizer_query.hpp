@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../index/minimizer_index.hpp"
+
+//
+// Query side of the minimizer-colors index.
+//
+// A query batch (a FASTA/FASTQ file, compressed or not) is turned into its minimizers with
+// the hashing and windowing of minimizer_processing_v4, the minimizers are sorted and
+// deduplicated, then merge-joined in a single pass against the index (rows are sorted by
+// minimizer, all tiers together). hits[c] counts the distinct minimizers of the batch that
+// are present in color c.
+//
+struct query_result
+{
+    std::string           name;
+    uint64_t              minimizers = 0; // distinct minimizers of the batch
+    uint64_t              found      = 0; // how many of them are indexed
+    std::vector<uint64_t> hits;           // per color
+};
+
+//
+// Sorted, distinct minimizers of a sequence file
+//
+extern void query_minimizers(const std::string& i_file, const uint64_t kmer, const uint64_t mmer, std::vector<uint64_t>& minimizers);
+
+//
+// Per color hit counts of sorted minimizers, hits is resized to the number of colors
+//
+extern uint64_t query_hits(minimizer_index& index, const std::vector<uint64_t>& sorted, std::vector<uint64_t>& hits);
+
+//
+// One batch per file, the files are processed in parallel (one index reader per thread)
+//
+extern std::vector<query_result> query_files(const std::string& index_file, const std::vector<std::string>& files,
+                                             const uint64_t kmer, const uint64_t mmer, const int threads);
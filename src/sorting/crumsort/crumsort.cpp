@@ -189,6 +189,20 @@
 //└─────────────────────────────────────────────────────┘//
 ///////////////////////////////////////////////////////////
 
+// (key, index) pairs, see crumsort_key_index()
+
+#define VAR key_index
+#define FUNC(NAME) NAME##_ki
+#ifndef cmp
+#define cmp(a,b) ((a)->key > (b)->key)
+#include "crumsort.hxx"
+#undef cmp
+#else
+#include "crumsort.c"
+#endif
+#undef VAR
+#undef FUNC
+
 /*
 typedef struct {char bytes[32];} struct256;
 #define VAR struct256
@@ -295,4 +309,13 @@ void crumsort_prim(void *array, size_t nmemb, size_t size)
     }
 }
 
+void crumsort_key_index(key_index *array, size_t nmemb)
+{
+    if (nmemb < 2)
+    {
+        return;
+    }
+    crumsort_ki(array, nmemb, NULL);
+}
+
 #undef QUAD_CACHE
@@ -11,5 +11,10 @@
 
 typedef int CMPFUNC (const void *a, const void *b);
 
+typedef struct { unsigned long long key; unsigned long long index; } key_index;
+
 extern void crumsort_prim(void *array, size_t nmemb, size_t size);
 extern void crumsort(void *array, size_t nmemb, size_t size, CMPFUNC *cmp);
+
+// Sorts the pairs on their key only, the order of equal keys is not specified
+extern void crumsort_key_index(key_index *array, size_t nmemb);
@@ -274,6 +274,20 @@ typedef int CMPFUNC (const void *a, const void *b);
 //└─────────────────────────────────────────────────────┘//
 ///////////////////////////////////////////////////////////
 
+// (key, index) pairs, used to sort wide rows on a 64-bit prefix of their content
+
+#define VAR key_index
+#define FUNC(NAME) NAME##_ki
+#ifndef cmp
+  #define cmp(a,b) ((a)->key > (b)->key)
+  #include "quadsort.hxx"
+  #undef cmp
+#else
+  #include "quadsort.c"
+#endif
+#undef VAR
+#undef FUNC
+
 /*
 typedef struct {char bytes[32];} struct256;
 #define VAR struct256
@@ -0,0 +1,127 @@
+#include "color_classes.hpp"
+#include "../../files/stream_reader_library.hpp"
+#include "../../files/stream_writer_library.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <filesystem>
+#include <memory>
+
+static constexpr uint64_t pair_buff_words = 2 * 65536;
+
+color_class_writer::color_class_writer(const std::string& table_file, const std::string& i_ids_file, const uint64_t i_n_words)
+    : n_words ( i_n_words ),
+      ids_file( i_ids_file ),
+      tmp_file( i_ids_file + ".pairs.tmp" )
+{
+    table = stream_writer_library::allocate( table_file );
+    pairs = stream_writer_library::allocate( tmp_file   );
+    if( !table->is_open() || !pairs->is_open() )
+        throw std::runtime_error("Cannot open color class outputs: " + table_file);
+    last.resize( n_words );
+    pair_buff.reserve( pair_buff_words );
+}
+
+color_class_writer::~color_class_writer()
+{
+    //
+    // Reached without close() when the sort failed : nothing is packed (that may throw), the
+    // staged records are dropped
+    //
+    if( table == nullptr )
+        return;
+    delete table;
+    delete pairs;
+    std::error_code ec;
+    std::filesystem::remove( tmp_file, ec );
+}
+
+void color_class_writer::flush_pairs()
+{
+    pairs->write_elements(pair_buff.data(), sizeof(uint64_t), pair_buff.size());
+    pair_buff.clear();
+}
+
+void color_class_writer::push(const uint64_t* rows, const uint64_t n)
+{
+    for(uint64_t i = 0; i < n; i += 1)
+    {
+        const uint64_t* row    = rows + i * (1 + n_words);
+        const uint64_t* colors = row + 1;
+
+        if( (n_classes == 0) || (std::memcmp(colors, last.data(), n_words * sizeof(uint64_t)) != 0) )
+        {
+            std::memcpy(last.data(), colors, n_words * sizeof(uint64_t));
+            table->write_elements(last.data(), sizeof(uint64_t), n_words);
+            n_classes += 1;
+        }
+
+        pair_buff.push_back( row[0]        );
+        pair_buff.push_back( n_classes - 1 );
+        if( pair_buff.size() >= pair_buff_words )
+            flush_pairs();
+        n_rows += 1;
+    }
+}
+
+void color_class_writer::close()
+{
+    if( table == nullptr )
+        return;
+
+    flush_pairs();
+    delete table; table = nullptr;
+    delete pairs; pairs = nullptr;
+
+    //
+    // Packing of the staged (minimizer, class id) records with the minimal id width
+    //
+    const uint64_t id_bits = (n_classes <= 1) ? 1 : 64 - __builtin_clzll( n_classes - 1 );
+
+    std::unique_ptr<stream_reader> src( stream_reader_library::allocate( tmp_file ) );
+    std::unique_ptr<stream_writer> dst( stream_writer_library::allocate( ids_file ) );
+    if( !src->is_open() || !dst->is_open() )
+        throw std::runtime_error("Cannot pack color class ids: " + ids_file);
+
+    const uint64_t header[3] = { n_rows, n_classes, id_bits };
+    dst->write_elements(header, sizeof(uint64_t), 3);
+
+    std::vector<uint64_t> in ( pair_buff_words );
+    std::vector<uint64_t> out( pair_buff_words + 2, 0 );
+    uint64_t bit  = 0; // position in out
+    size_t   got;
+    while( (got = src->read_elements(in.data(), sizeof(uint64_t), in.size())) > 0 )
+    {
+        for(size_t i = 0; i < got; i += 2)
+        {
+            // minimizer, always 64 bits
+            const uint64_t sh = bit & 63;
+            out[(bit >> 6)    ] |= in[i] << sh;
+            out[(bit >> 6) + 1] |= (sh == 0) ? 0 : in[i] >> (64 - sh);
+            bit += 64;
+
+            // class id
+            const uint64_t sid = bit & 63;
+            out[(bit >> 6)] |= in[i + 1] << sid;
+            if( sid + id_bits > 64 )
+                out[(bit >> 6) + 1] |= in[i + 1] >> (64 - sid);
+            bit += id_bits;
+
+            if( (bit >> 6) >= pair_buff_words )
+            {
+                const uint64_t full = bit >> 6;
+                dst->write_elements(out.data(), sizeof(uint64_t), full);
+                const uint64_t carry[2] = { out[full], out[full + 1] };
+                std::fill(out.begin(), out.end(), 0);
+                out[0] = carry[0];
+                out[1] = carry[1];
+                bit   &= 63;
+            }
+        }
+    }
+    dst->write_elements(out.data(), sizeof(uint64_t), (bit + 63) >> 6);
+
+    src.reset();
+    dst.reset();
+    std::filesystem::remove( tmp_file );
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class stream_writer;
+
+//
+// Color-class output of the final dense file. Rows come in color order (output of the external
+// sort) so identical color sets are adjacent : each new set gets the next class id.
+//
+//  - table file : one bitmap of n_words words per class, class i is the i-th row
+//  - ids file   : [n_rows][n_classes][id_bits] followed by the n_rows records
+//                 (minimizer on 64 bits, class id on id_bits bits) packed LSB first
+//
+// id_bits is the minimal width for n_classes, it is only known at the end so the records are
+// staged in a raw temporary file and packed by close(), which the owner must call (it throws
+// on I/O errors, the destructor only drops the staged records).
+//
+class color_class_writer
+{
+private:
+    const uint64_t        n_words;
+    const std::string     ids_file;
+    const std::string     tmp_file;
+    stream_writer*        table;
+    stream_writer*        pairs;
+    std::vector<uint64_t> last;        // color set of the current class
+    std::vector<uint64_t> pair_buff;
+    uint64_t              n_rows    = 0;
+    uint64_t              n_classes = 0;
+
+    void flush_pairs();
+
+public:
+     color_class_writer(const std::string& table_file, const std::string& ids_file, const uint64_t n_words);
+    ~color_class_writer();
+
+    //
+    // n rows of [minimizer][n_words color words]
+    //
+    void     push   (const uint64_t* rows, const uint64_t n);
+    void     close  ();
+
+    uint64_t classes() const { return n_classes; }
+    uint64_t rows   () const { return n_rows;    }
+};
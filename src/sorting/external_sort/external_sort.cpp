@@ -1,10 +1,15 @@
 #include "external_sort.hpp"
 #include "../../../lib/BreiZHMinimizer.hpp"
 #include "../../kmer_list/smer_deduplication.hpp"
+#include "color_classes.hpp"
+#include "hash_grouping.hpp"
+#include "row_sort.hpp"
+#include "loser_tree.hpp"
 
 // Wrapper Includes
 #include "../../files/stream_reader_library.hpp"
 #include "../../files/stream_writer_library.hpp"
+#include "../../tools/CMemoryBudget/CMemoryBudget.hpp"
 #include "../../../include/config.hpp"
 
 // Standard Includes
@@ -17,6 +22,8 @@
 #include <condition_variable>
 #include <queue>
 #include <iostream>
+#include <memory>
+#include <exception>
 
 // ------------------------------------------------------------
 // Thread-Safe Queue for Producer-Consumer Pattern
@@ -69,32 +76,8 @@ public:
 // Comparators
 // ------------------------------------------------------------
 
-// Comparator for Min-Heap (Returns true if A > B)
-// Used in Merge Phase to keep Smallest element at the root (std::greater logic)
-struct ElementCmpGreater {
-    const uint64_t n_uint_per_element;
-    ElementCmpGreater(uint64_t n) : n_uint_per_element(n) {}
-
-    // Updated signature to accept the Heap's value_type
-    bool operator()(const std::pair<uint64_t*, size_t>& a, 
-                    const std::pair<uint64_t*, size_t>& b) const {
-        
-        const uint64_t* ptrA = a.first;
-        const uint64_t* ptrB = b.first;
-
-        // 1. Compare Colors (Skip minimizer at index 0)
-        int res = std::memcmp(ptrA + 1, ptrB + 1, (n_uint_per_element - 1) * sizeof(uint64_t));
-        
-        // 2. Tie-breaker: Compare Minimizer for deterministic output
-        if (res == 0) {
-            return ptrA[0] > ptrB[0]; 
-        }
-        return res > 0;
-    }
-};
-
 // Comparator for Standard Sort (Returns true if A < B)
-// Used in Chunk Creation Phase
+// Used for the merge ties and the splitters
 struct ElementCmpLess {
     const uint64_t n_uint_per_element;
     ElementCmpLess(uint64_t n) : n_uint_per_element(n) {}
@@ -120,39 +103,155 @@ std::string get_extension(const std::string& filename) {
     return ext;
 }
 
+// ------------------------------------------------------------
+// Sorted Runs
+// ------------------------------------------------------------
+
+// A sorted run (chunk or merge pass output) is stored as consecutive segment files. A key
+// range of the parallel merge starts reading each run at the segment holding its first row
+// instead of decoding and dropping everything below it. Segment boundaries are only used
+// when the last pass can be split (SEGMENTS_PER_RUN per run), a run is one file otherwise.
+static const uint64_t SEGMENTS_PER_RUN = 32;
+
+struct sorted_run {
+    std::vector<std::string> segments;
+    std::vector<uint64_t>    firsts;   // first row of each segment
+    uint64_t                 n_rows = 0;
+};
+
+class run_writer {
+private:
+    const std::string              prefix;
+    const std::string              ext;
+    const uint64_t                 n_uint;
+    const uint64_t                 segment_rows;
+    std::unique_ptr<stream_writer> writer;
+    uint64_t                       in_segment = 0;
+    sorted_run                     run;
+
+    void next_segment(const uint64_t* first) {
+        if (writer) writer->close();
+        const std::string name = prefix + ".g" + std::to_string(run.segments.size()) + ext;
+        writer.reset(stream_writer_library::allocate(name));
+        if (!writer || !writer->is_open()) throw std::runtime_error("Cannot open output: " + name);
+        run.segments.push_back(name);
+        run.firsts.insert(run.firsts.end(), first, first + n_uint);
+        in_segment = 0;
+    }
+
+public:
+    run_writer(const std::string& i_prefix, const std::string& i_ext, const uint64_t i_n_uint, const uint64_t i_segment_rows)
+        : prefix(i_prefix), ext(i_ext), n_uint(i_n_uint), segment_rows(std::max((uint64_t)1, i_segment_rows)) {}
+
+    void write(const uint64_t* rows, size_t n) {
+        while (n > 0) {
+            if (!writer || in_segment == segment_rows) next_segment(rows);
+            const size_t m = std::min((uint64_t)n, segment_rows - in_segment);
+            writer->write_elements(rows, n_uint * sizeof(uint64_t), m);
+            in_segment += m;
+            run.n_rows += m;
+            rows       += m * n_uint;
+            n          -= m;
+        }
+    }
+
+    sorted_run close() {
+        if (!writer) { // an empty run still has its (empty) file
+            writer.reset(stream_writer_library::allocate(prefix + ".g0" + ext));
+            run.segments.push_back(prefix + ".g0" + ext);
+        }
+        writer->close();
+        writer.reset();
+        return run;
+    }
+};
+
+// Reads the segments [first, last) of a run as a single stream of rows
+class run_reader {
+private:
+    const sorted_run&              run;
+    size_t                         segment;
+    const size_t                   last;
+    std::unique_ptr<stream_reader> reader;
+
+    void open() {
+        reader.reset();
+        if (segment >= last) return;
+        reader.reset(stream_reader_library::allocate(run.segments[segment]));
+        if (!reader || !reader->is_open()) throw std::runtime_error("Cannot open chunk: " + run.segments[segment]);
+    }
+
+public:
+    run_reader(const sorted_run& i_run, const size_t first, const size_t i_last)
+        : run(i_run), segment(first), last(i_last) { open(); }
+
+    size_t read(uint64_t* buffer, const size_t row_bytes, const size_t n) {
+        size_t got = 0;
+        while (got < n && reader) {
+            got += reader->read_elements((char*)buffer + got * row_bytes, row_bytes, n - got);
+            if (got < n) { segment++; open(); }
+        }
+        return got;
+    }
+};
+
+static void remove_run(const sorted_run& run) {
+    for (const auto& f : run.segments) std::filesystem::remove(f);
+}
+
+// Appends the part files to outfile. Raw files and LZ4 frames (both readers decode
+// concatenated frames) can be glued byte by byte
+static void concatenate_parts(const std::vector<std::string>& parts, const std::string& outfile)
+{
+    FILE* out = fopen(outfile.c_str(), "wb");
+    if (out == NULL) throw std::runtime_error("Cannot open output: " + outfile);
+    std::vector<char> buffer(4 * 1024 * 1024);
+    for (const auto& p : parts) {
+        FILE* in = fopen(p.c_str(), "rb");
+        if (in == NULL) { fclose(out); throw std::runtime_error("Cannot open part: " + p); }
+        size_t n;
+        while ((n = fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+            if (fwrite(buffer.data(), 1, n, out) != n) { fclose(in); fclose(out); throw std::runtime_error("Cannot write: " + outfile); }
+        }
+        fclose(in);
+        std::filesystem::remove(p);
+    }
+    fclose(out);
+}
+
+// The run becomes the output file
+static void finalize_run(const sorted_run& run, const std::string& outfile) {
+    if (run.segments.size() == 1) std::filesystem::rename(run.segments[0], outfile);
+    else                          concatenate_parts(run.segments, outfile);
+}
+
 // ------------------------------------------------------------
 // PHASE 1: Parallel Chunk Creation (Producer-Consumer)
 // ------------------------------------------------------------
-std::vector<std::string> create_chunks_parallel(const std::string& infile,
-                                                const std::string& tmp_dir,
-                                                uint64_t n_uint_per_element,
-                                                uint64_t max_ram_bytes,
-                                                int n_threads,
-                                                int verbose,
-                                                const std::string& output_extension)
+static std::vector<sorted_run> create_chunks_parallel(const std::string& infile,
+                                                      const std::string& tmp_dir,
+                                                      uint64_t n_uint_per_element,
+                                                      uint64_t max_ram_bytes,
+                                                      int n_threads,
+                                                      int verbose,
+                                                      const std::string& output_extension,
+                                                      const bool segmented,
+                                                      std::vector<uint64_t>& samples)
 {
-    std::vector<std::string> chunknames;
-    std::mutex chunks_mutex; 
+    std::vector<std::pair<size_t, sorted_run>> chunks;
+    std::mutex chunks_mutex;
+    std::exception_ptr failure = nullptr; 
     
     // Config: 1 Producer, rest Workers
     size_t n_workers = std::max(1, n_threads - 1);
     
-    // RAM Calculation: Data + Vector<Pointer> overhead
+    // RAM Calculation: Data + (key, index) sort overhead
     uint64_t bytes_per_element_raw = n_uint_per_element * sizeof(uint64_t);
-    uint64_t bytes_per_element_ram = bytes_per_element_raw + sizeof(uint64_t*); 
+    uint64_t bytes_per_element_ram = bytes_per_element_raw + sizeof(key_index);
 
     // Division: (Active Workers + Queue Slots + Producer Buffer)
     uint64_t elements_per_chunk = max_ram_bytes / (bytes_per_element_ram * (2 * n_workers + 1));
     
-    // --- CRITICAL FIX START: Cap Chunk Size to 1GB ---
-    // Prevent integer overflow in stream_reader::read (which uses int for size)
-    const uint64_t MAX_IO_BYTES = 1024ULL * 1024ULL * 1024ULL; // 1GB
-    if (elements_per_chunk * bytes_per_element_raw > MAX_IO_BYTES) {
-        elements_per_chunk = MAX_IO_BYTES / bytes_per_element_raw;
-        if (verbose >= 3) std::cerr << "[III] Chunk size capped to 1GB to prevent IO overflow.\n";
-    }
-    // --- CRITICAL FIX END ---
-
     // Safety lower bound
     if (elements_per_chunk < 1000) elements_per_chunk = 1000;
 
@@ -168,52 +267,49 @@ std::vector<std::string> create_chunks_parallel(const std::string& infile,
     // --- WORKER THREAD FUNCTION ---
     auto worker_task = [&]() {
         Job job;
-        std::vector<uint64_t*> ptrs; 
-        ElementCmpLess cmp(n_uint_per_element);
-        
+        std::vector<key_index> order;
+
         while (queue.pop(job)) {
             size_t n_items = job.data.size() / n_uint_per_element;
-            
-            // 1. Setup Pointers
-            ptrs.resize(n_items);
-            for (size_t i = 0; i < n_items; i++) {
-                ptrs[i] = &job.data[i * n_uint_per_element];
+
+            // 1. Sort (key, index) pairs, the rows stay in place
+            sort_rows(job.data.data(), n_items, n_uint_per_element, order);
+            auto row = [&](const size_t i) { return job.data.data() + order[i].index * n_uint_per_element; };
+
+            // Evenly spaced rows of the chunk, they give the key ranges of the parallel merge
+            {
+                const size_t SAMPLES_PER_CHUNK = 64;
+                const size_t step = std::max((size_t)1, n_items / SAMPLES_PER_CHUNK);
+                std::lock_guard<std::mutex> lock(chunks_mutex);
+                for (size_t i = step / 2; i < n_items; i += step)
+                    samples.insert(samples.end(), row(i), row(i) + n_uint_per_element);
             }
 
-            // 2. Sort
-            std::sort(ptrs.begin(), ptrs.end(), cmp);
+            // 2. Write
+            try {
+                const uint64_t segment_rows = segmented ? (n_items + SEGMENTS_PER_RUN - 1) / SEGMENTS_PER_RUN : n_items;
+                run_writer writer(tmp_dir + "/chunk_" + std::to_string(job.id), output_extension, n_uint_per_element, segment_rows);
 
-            // 3. Write
-            std::string fname = tmp_dir + "/chunk_" + std::to_string(job.id) + output_extension;
-            stream_writer* writer = stream_writer_library::allocate(fname);
-            
-            if(writer && writer->is_open()) {
-                const size_t STAGE_COUNT = 4096; 
+                const size_t STAGE_COUNT = 4096;
                 std::vector<uint64_t> stage_buf;
                 stage_buf.reserve(STAGE_COUNT * n_uint_per_element);
 
                 for (size_t i = 0; i < n_items; i++) {
-                    stage_buf.insert(stage_buf.end(), ptrs[i], ptrs[i] + n_uint_per_element);
+                    stage_buf.insert(stage_buf.end(), row(i), row(i) + n_uint_per_element);
 
                     if (stage_buf.size() >= STAGE_COUNT * n_uint_per_element) {
-                        writer->write(stage_buf.data(), sizeof(uint64_t) * n_uint_per_element, STAGE_COUNT);
+                        writer.write(stage_buf.data(), STAGE_COUNT);
                         stage_buf.clear();
                     }
                 }
-                if (!stage_buf.empty()) {
-                     writer->write(stage_buf.data(), sizeof(uint64_t) * n_uint_per_element, stage_buf.size() / n_uint_per_element);
-                }
-
-                writer->close();
-                delete writer;
-
-                {
-                    std::lock_guard<std::mutex> lock(chunks_mutex);
-                    chunknames.push_back(fname);
-                }
-            } else {
-                if(writer) delete writer;
-                std::cerr << "Error writing chunk: " << fname << "\n";
+                writer.write(stage_buf.data(), stage_buf.size() / n_uint_per_element);
+
+                sorted_run run = writer.close();
+                std::lock_guard<std::mutex> lock(chunks_mutex);
+                chunks.emplace_back(job.id, std::move(run));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(chunks_mutex);
+                failure = std::current_exception();
             }
         }
     };
@@ -239,12 +335,12 @@ std::vector<std::string> create_chunks_parallel(const std::string& infile,
         job.data.resize(elements_per_chunk * n_uint_per_element);
         job.id = chunk_id++;
 
-        // Because elements_per_chunk is now capped, this read is safe from overflow
-        int got = reader->read(job.data.data(), sizeof(uint64_t) * n_uint_per_element, elements_per_chunk);
+        // 64-bit read: the chunk size only depends on the RAM budget
+        size_t got = reader->read_elements(job.data.data(), sizeof(uint64_t) * n_uint_per_element, elements_per_chunk);
         
-        if (got <= 0) break; // EOF
+        if (got == 0) break; // EOF
 
-        if ((uint64_t)got < elements_per_chunk) {
+        if (got < elements_per_chunk) {
             job.data.resize(got * n_uint_per_element);
         }
 
@@ -254,8 +350,13 @@ std::vector<std::string> create_chunks_parallel(const std::string& infile,
     delete reader;
     queue.stop();
     for (auto& t : threads) if(t.joinable()) t.join();
+    if (failure) std::rethrow_exception(failure);
 
-    return chunknames;
+    // Chunk order does not matter for the merge, it is only made deterministic
+    std::sort(chunks.begin(), chunks.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<sorted_run> runs;
+    for (auto& c : chunks) runs.push_back(std::move(c.second));
+    return runs;
 }
 
 // ------------------------------------------------------------
@@ -265,16 +366,22 @@ struct ChunkEntry {
     std::vector<uint64_t> buffer;
     size_t pos = 0;
     size_t count = 0;
-    stream_reader* reader = nullptr;
+    std::unique_ptr<run_reader> reader;
 };
 
-void nway_merge(const std::vector<std::string>& chunknames,
-                const std::string& outfile,
-                uint64_t n_uint_per_element,
-                uint64_t max_ram_bytes,
-                int verbose) 
+// Merges the rows of [lo, hi) of the runs (nullptr = unbounded) to out, or to the class
+// writer. Each run is only read from the segment holding its first row >= lo, rows below lo
+// are skipped there, and a run is done at its first row >= hi
+static void nway_merge(const std::vector<sorted_run>& runs,
+                       run_writer* out,
+                       uint64_t n_uint_per_element,
+                       uint64_t max_ram_bytes,
+                       int verbose,
+                       color_class_writer* classes = nullptr,
+                       const uint64_t* lo = nullptr,
+                       const uint64_t* hi = nullptr)
 {
-    size_t n_chunks = chunknames.size();
+    size_t n_chunks = runs.size();
     if (n_chunks == 0) return;
 
     // 1. Calculate Buffer Sizes
@@ -283,123 +390,225 @@ void nway_merge(const std::vector<std::string>& chunknames,
     // Divide RAM by (n_chunks inputs + 1 output)
     uint64_t buf_elems = (max_ram_bytes / bytes_per_elem_raw) / (n_chunks + 1);
     
-    // --- CRITICAL FIX: CAP BUFFER SIZE ---
-    // The underlying read/write functions use 'int', limiting I/O to ~2GB per call.
-    // We cap the buffer at 1GB (1024^3 bytes) to be safe and prevent overflow.
-    const uint64_t MAX_IO_BYTES = 1024ULL * 1024ULL * 1024ULL; // 1GB
-    
-    if (buf_elems * bytes_per_elem_raw > MAX_IO_BYTES) {
-        buf_elems = MAX_IO_BYTES / bytes_per_elem_raw;
-        // (Optional) Log this if you want to verify the fix
-        // if (verbose >= 3) std::cout << "[III] Merge buffers capped to 1GB to prevent IO overflow.\n";
-    }
-
     // Safety floor
     if (buf_elems < 16) buf_elems = 16; 
 
     std::vector<uint64_t> outbuf(buf_elems * n_uint_per_element);
     std::vector<ChunkEntry> chunks(n_chunks);
+    ElementCmpLess less(n_uint_per_element);
+
+    // Segments [first, last) of a run that can hold rows of [lo, hi)
+    auto segment_range = [&](const sorted_run& run, size_t& first, size_t& last) {
+        const size_t n_seg = run.segments.size();
+        auto first_row = [&](const size_t g) { return run.firsts.data() + g * n_uint_per_element; };
+        first = 0;
+        last  = n_seg;
+        if (run.firsts.size() != n_seg * n_uint_per_element) return; // empty run
+        if (lo != nullptr)
+            while (first + 1 < n_seg && !less(lo, first_row(first + 1))) first++;
+        if (hi != nullptr)
+            while (last > first + 1 && !less(first_row(last - 1), hi)) last--;
+    };
 
-    // 2. Initialize Readers (Safe)
+    // Reads the next buffer of a chunk, skipping the rows below lo
+    auto refill = [&](ChunkEntry& c) {
+        c.pos   = 0;
+        c.count = c.reader->read(c.buffer.data(), bytes_per_elem_raw, buf_elems);
+        while (lo != nullptr && c.count > 0) {
+            while (c.pos < c.count && less(c.buffer.data() + c.pos * n_uint_per_element, lo)) c.pos++;
+            if (c.pos < c.count) break;
+            c.pos   = 0;
+            c.count = c.reader->read(c.buffer.data(), bytes_per_elem_raw, buf_elems);
+        }
+    };
+    auto in_range = [&](const ChunkEntry& c) {
+        return c.pos < c.count && (hi == nullptr || less(c.buffer.data() + c.pos * n_uint_per_element, hi));
+    };
+
+    // 2. Initialize Readers
     for (size_t i = 0; i < n_chunks; i++) {
+        size_t first, last;
+        segment_range(runs[i], first, last);
         chunks[i].buffer.resize(buf_elems * n_uint_per_element);
-        chunks[i].reader = stream_reader_library::allocate(chunknames[i]);
-        if (!chunks[i].reader || !chunks[i].reader->is_open())
-            throw std::runtime_error("Cannot open chunk: " + chunknames[i]);
-            
-        // Because buf_elems is capped, this cast is now safe
-        int got = chunks[i].reader->read(chunks[i].buffer.data(), bytes_per_elem_raw, (int)buf_elems);
-        
-        if (got <= 0) {
-            chunks[i].count = 0; 
-        } else {
-            chunks[i].count = static_cast<size_t>(got);
-        }
-        chunks[i].pos = 0;
+        chunks[i].reader.reset(new run_reader(runs[i], first, last));
+        refill(chunks[i]);
     }
 
-    stream_writer* writer = stream_writer_library::allocate(outfile);
-    if (!writer || !writer->is_open()) {
-        for(auto& c : chunks) if(c.reader) delete c.reader;
-        throw std::runtime_error("Cannot open output: " + outfile);
-    }
+    // The last pass of a color class sort streams its rows to the class writer
+    auto emit = [&](const uint64_t* rows, const size_t n) {
+        if (classes != nullptr) classes->push(rows, n);
+        else                    out->write(rows, n);
+    };
 
-    // 3. Initialize Min-Heap
-    std::vector<std::pair<uint64_t*, size_t>> heap;
-    ElementCmpGreater cmp(n_uint_per_element);
+    // 3. Initialize the Loser Tree, keyed on the first color word
+    auto head = [&](const size_t i) { return chunks[i].buffer.data() + chunks[i].pos * n_uint_per_element; };
+    auto tie  = [&](const size_t a, const size_t b) { return less(head(a), head(b)); };
+    loser_tree<decltype(tie)> tree(n_chunks, tie);
 
     for (size_t i = 0; i < n_chunks; i++) {
-        if (chunks[i].count > 0) 
-            heap.push_back({ chunks[i].buffer.data(), i });
+        if (in_range(chunks[i])) tree.set(i, row_key(head(i), 1));
     }
-    std::make_heap(heap.begin(), heap.end(), cmp);
+    tree.build();
 
     size_t outcount = 0;
 
-    // 4. Merge Loop
-    while (!heap.empty()) {
-        std::pop_heap(heap.begin(), heap.end(), cmp);
-        auto [ptr, idx] = heap.back();
-        heap.pop_back();
-
-        // Copy to output
-        std::memcpy(&outbuf[outcount * n_uint_per_element], ptr, bytes_per_elem_raw);
-        outcount++;
-
-        // Flush Output if full
-        if (outcount == buf_elems) {
-            // Safe write because outcount <= buf_elems (which is capped)
-            writer->write(outbuf.data(), bytes_per_elem_raw, (int)outcount);
-            outcount = 0;
-        }
+    // Consecutive rows won by the same chunk are sent as a block : straight from the chunk
+    // buffer when it is large enough, through outbuf otherwise
+    const size_t DIRECT_MIN = std::max((size_t)1, (size_t)buf_elems / 8);
+    size_t run_chunk = n_chunks;
+    size_t run_begin = 0;
+    size_t run_len   = 0;
 
-        // Advance Reader
-        chunks[idx].pos++;
-        
-        // Refill if needed
-        if (chunks[idx].pos == chunks[idx].count) {
-            int got = chunks[idx].reader->read(chunks[idx].buffer.data(), bytes_per_elem_raw, (int)buf_elems);
-            
-            if (got > 0) {
-                chunks[idx].count = static_cast<size_t>(got);
-                chunks[idx].pos = 0;
-            } else {
-                chunks[idx].count = 0; // EOF
+    auto flush = [&]() {
+        if (outcount > 0) emit(outbuf.data(), outcount);
+        outcount = 0;
+    };
+    auto end_run = [&]() {
+        if (run_len == 0) return;
+        const uint64_t* src = chunks[run_chunk].buffer.data() + run_begin * n_uint_per_element;
+        if (run_len >= DIRECT_MIN) {
+            flush();
+            emit(src, run_len);
+        } else {
+            while (run_len > 0) {
+                const size_t n = std::min(run_len, (size_t)buf_elems - outcount);
+                std::memcpy(&outbuf[outcount * n_uint_per_element], src, n * bytes_per_elem_raw);
+                outcount += n;
+                src      += n * n_uint_per_element;
+                run_len  -= n;
+                if (outcount == buf_elems) flush();
             }
         }
+        run_len = 0;
+    };
+
+    // 4. Merge Loop
+    while (!tree.empty()) {
+        const size_t idx = tree.top();
+        ChunkEntry&  c   = chunks[idx];
+
+        if (idx != run_chunk) {
+            end_run();
+            run_chunk = idx;
+            run_begin = c.pos;
+        }
+        run_len++;
+
+        // Advance Reader, the run must leave before its buffer is overwritten
+        c.pos++;
+        if (c.pos == c.count) {
+            end_run();
+            run_chunk = n_chunks;
+            c.count = c.reader->read(c.buffer.data(), bytes_per_elem_raw, buf_elems); // 0 = EOF
+            c.pos   = 0;
+        }
 
-        // Push back to heap if valid
-        if (chunks[idx].pos < chunks[idx].count) {
-            heap.push_back({ chunks[idx].buffer.data() + chunks[idx].pos * n_uint_per_element, idx });
-            std::push_heap(heap.begin(), heap.end(), cmp);
+        if (in_range(c)) {
+            tree.replace_top(row_key(head(idx), 1));
         } else {
             // Close exhausted chunk
-            if (chunks[idx].reader) {
-                delete chunks[idx].reader;
-                chunks[idx].reader = nullptr;
-            }
+            end_run();
+            run_chunk = n_chunks;
+            tree.pop_top();
+            c.reader.reset();
         }
     }
+    end_run();
 
     // 5. Final Flush
-    if (outcount > 0) {
-        writer->write(outbuf.data(), bytes_per_elem_raw, (int)outcount);
+    flush();
+}
+
+// ------------------------------------------------------------
+// Feeds a sorted run to the color class writer
+// ------------------------------------------------------------
+static void stream_to_classes(const sorted_run& run, uint64_t n_uint_per_element, color_class_writer* classes)
+{
+    run_reader reader(run, 0, run.segments.size());
+    const size_t n_elems = std::max((uint64_t)1, (uint64_t)(1 << 20) / n_uint_per_element);
+    std::vector<uint64_t> buffer(n_elems * n_uint_per_element);
+    size_t got;
+    while ((got = reader.read(buffer.data(), sizeof(uint64_t) * n_uint_per_element, n_elems)) > 0) {
+        classes->push(buffer.data(), got);
     }
+}
 
-    writer->close();
-    delete writer;
+// ------------------------------------------------------------
+// Splitter-based parallel merge
+// ------------------------------------------------------------
 
-    for(size_t i=0; i<n_chunks; i++) if(chunks[i].reader) delete chunks[i].reader;
+// Each thread merges one key range of all the runs, the ranges come from the rows sampled
+// during chunk creation. A thread opens each run at the segment holding the start of its
+// range, so only a fraction of a segment per run is decoded and dropped.
+static void parallel_nway_merge(const std::vector<sorted_run>& runs,
+                                const std::string& outfile,
+                                uint64_t n_uint_per_element,
+                                uint64_t max_ram_bytes,
+                                int verbose,
+                                color_class_writer* classes,
+                                const std::vector<uint64_t>& samples,
+                                int n_threads)
+{
+    ElementCmpLess less(n_uint_per_element);
+
+    std::vector<const uint64_t*> sorted;
+    for (size_t i = 0; i < samples.size(); i += n_uint_per_element) sorted.push_back(samples.data() + i);
+    std::sort(sorted.begin(), sorted.end(), less);
+
+    std::vector<const uint64_t*> splitters;
+    for (int t = 1; t < n_threads; t++) {
+        const uint64_t* s = sorted[t * sorted.size() / n_threads];
+        if (splitters.empty() || less(splitters.back(), s)) splitters.push_back(s);
+    }
+    const size_t n_parts = splitters.size() + 1;
+
+    if (verbose >= 3) {
+        std::cerr << "[III] Parallel merge of " << runs.size() << " chunks over " << n_parts << " key ranges\n";
+    }
+
+    const std::string ext = get_extension(outfile);
+    std::vector<sorted_run> parts(n_parts);
+    std::exception_ptr failure = nullptr;
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(n_parts)
+    for (size_t t = 0; t < n_parts; t++) {
+        try {
+            run_writer part(outfile + ".part" + std::to_string(t), ext, n_uint_per_element, UINT64_MAX);
+            nway_merge(runs, &part, n_uint_per_element, max_ram_bytes / n_parts, verbose, nullptr,
+                       (t == 0)           ? nullptr : splitters[t - 1],
+                       (t == n_parts - 1) ? nullptr : splitters[t]);
+            parts[t] = part.close();
+        } catch (...) {
+            #pragma omp critical
+            failure = std::current_exception();
+        }
+    }
+    if (failure) std::rethrow_exception(failure);
+
+    if (classes != nullptr) {
+        for (const auto& p : parts) {
+            stream_to_classes(p, n_uint_per_element, classes);
+            remove_run(p);
+        }
+    } else {
+        std::vector<std::string> files;
+        for (const auto& p : parts) files.insert(files.end(), p.segments.begin(), p.segments.end());
+        concatenate_parts(files, outfile);
+    }
 }
 
 // ------------------------------------------------------------
 // Multi-Pass Logic
 // ------------------------------------------------------------
-void multi_pass_nway_merge(std::vector<std::string> chunknames,
-                           const std::string& outfile,
-                           uint64_t n_uint_per_element,
-                           uint64_t max_ram_bytes,
-                           int verbose) 
+static void multi_pass_nway_merge(std::vector<sorted_run> runs,
+                                  const std::string& outfile,
+                                  uint64_t n_uint_per_element,
+                                  uint64_t max_ram_bytes,
+                                  int verbose,
+                                  color_class_writer* classes,
+                                  const std::vector<uint64_t>& samples,
+                                  int n_threads,
+                                  const bool segmented)
 {
     const size_t FAN_IN = 64; 
     size_t pass = 0;
@@ -407,52 +616,80 @@ void multi_pass_nway_merge(std::vector<std::string> chunknames,
     // Determine extension for intermediate files
     std::string ext = get_extension(outfile);
 
-    while (chunknames.size() > 1) {
+    const bool can_split = segmented && (samples.size() >= n_uint_per_element * n_threads);
+
+    while (runs.size() > 1) {
         pass++;
-        size_t n_groups = (chunknames.size() + FAN_IN - 1) / FAN_IN;
-        std::vector<std::string> next_chunks;
+        size_t n_groups = (runs.size() + FAN_IN - 1) / FAN_IN;
 
+        if (n_groups == 1 && can_split) {
+            if (verbose >= 3) {
+                 std::cerr << "[III] Merge Pass " << pass << " (" << runs.size() << " files, parallel) -> " << outfile << "\n";
+            }
+            parallel_nway_merge(runs, outfile, n_uint_per_element, max_ram_bytes, verbose, classes, samples, n_threads);
+            for(const auto& r : runs) remove_run(r);
+            return;
+        }
+        color_class_writer* last_pass = (n_groups == 1) ? classes : nullptr;
+
+        // Groups are independent, each one gets its share of the RAM budget
+        const int n_par = (int)std::min((size_t)std::max(1, n_threads), n_groups);
+        std::vector<sorted_run> next_runs(n_groups);
+        std::exception_ptr failure = nullptr;
+
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(n_par)
         for (size_t g = 0; g < n_groups; ++g) {
             size_t start = g * FAN_IN;
-            size_t end = std::min(start + FAN_IN, chunknames.size());
+            size_t end = std::min(start + FAN_IN, runs.size());
             
-            std::vector<std::string> group;
-            group.reserve(end - start);
-            for(size_t k=start; k<end; ++k) group.push_back(chunknames[k]);
+            std::vector<sorted_run> group(runs.begin() + start, runs.begin() + end);
+            uint64_t n_rows = 0;
+            for (const auto& r : group) n_rows += r.n_rows;
 
-            std::string tmp_out = outfile + ".tmp.pass" + std::to_string(pass) + ".group" + std::to_string(g) + ext;
+            std::string tmp_out = outfile + ".tmp.pass" + std::to_string(pass) + ".group" + std::to_string(g);
             
             if (verbose >= 3) {
+                 #pragma omp critical
                  std::cerr << "[III] Merge Pass " << pass << ", Group " << g 
                            << " (" << group.size() << " files) -> " << tmp_out << "\n";
             }
 
-            nway_merge(group, tmp_out, n_uint_per_element, max_ram_bytes, verbose);
-            next_chunks.push_back(tmp_out);
+            try {
+                const uint64_t segment_rows = segmented ? (n_rows + SEGMENTS_PER_RUN - 1) / SEGMENTS_PER_RUN : n_rows;
+                run_writer out(tmp_out, ext, n_uint_per_element, segment_rows);
+                nway_merge(group, (last_pass != nullptr) ? nullptr : &out, n_uint_per_element, max_ram_bytes / n_par, verbose, last_pass);
+                if (last_pass == nullptr) next_runs[g] = out.close();
+            } catch (...) {
+                #pragma omp critical
+                failure = std::current_exception();
+            }
 
             // Delete merged chunks
-            for(const auto& f : group) std::filesystem::remove(f);
+            for(const auto& r : group) remove_run(r);
         }
-        chunknames = next_chunks;
+        if (failure) std::rethrow_exception(failure);
+
+        if (last_pass != nullptr) return; // rows went to the color classes
+        runs = next_runs;
     }
 
     // Final Rename
-    if (!chunknames.empty() && chunknames[0] != outfile) {
-        std::filesystem::rename(chunknames[0], outfile);
-    }
+    if (!runs.empty()) finalize_run(runs[0], outfile);
 }
 
 // ------------------------------------------------------------
 // Main External Sort Entry Point
 // ------------------------------------------------------------
-void external_sort(const std::string& infile,
-                   const std::string& outfile,
-                   const std::string& tmp_dir,
-                   const uint64_t n_colors,
-                   const uint64_t ram_value_MB,
-                   const bool keep_tmp_files,
-                   const int verbose,
-                   int n_threads)
+static void external_sort_rows(const std::string& infile,
+                               const std::string& outfile,
+                               const std::string& tmp_dir,
+                               const uint64_t n_colors,
+                               const uint64_t ram_value_MB,
+                               const bool keep_tmp_files,
+                               const int verbose,
+                               int n_threads,
+                               color_class_writer* classes,
+                               const color_grouping grouping)
 {
     // Determine output extension (e.g. .lz4) so temporary chunks match format
     std::string out_ext = get_extension(outfile);
@@ -463,22 +700,67 @@ void external_sort(const std::string& infile,
     }
 
     const uint64_t n_uint_per_element = (n_colors + 63) / 64 + 1;
-    uint64_t max_ram_bytes = ram_value_MB * 1024 * 1024;
-
-    // Phase 1: Create Chunks using Producer-Consumer
-    auto chunknames = create_chunks_parallel(infile, tmp_dir, 
-                                             n_uint_per_element, 
-                                             max_ram_bytes, 
-                                             n_threads, 
-                                             verbose,
-                                             out_ext);
-
-    if (chunknames.size() == 1) {
-        // Single chunk created, just rename it
-        std::filesystem::rename(chunknames[0], outfile);
-    } else {
+
+    // Runs and merge buffers are taken from the process memory budget
+    CMemoryBudget::lease memory(ram_value_MB * 1024 * 1024 / 4, ram_value_MB * 1024 * 1024);
+    uint64_t max_ram_bytes = memory.bytes();
+
+    if (grouping == GROUP_HASH) {
+        // Equal color vectors only need to be adjacent : linear hash grouping instead of the sort
+        std::unique_ptr<stream_writer> writer;
+        std::vector<uint64_t> outbuf;
+        if (classes == nullptr) {
+            writer.reset(stream_writer_library::allocate(outfile));
+            if (!writer || !writer->is_open()) throw std::runtime_error("Cannot open output: " + outfile);
+            outbuf.reserve(1 << 20);
+        }
+
+        hash_grouping grouper([n_uint_per_element](const uint64_t*) { return n_uint_per_element; },
+                              max_ram_bytes, tmp_dir + "/group", out_ext, verbose);
+        grouper.run(infile, [&](const uint64_t* row, const uint64_t n) {
+            if (classes != nullptr) { classes->push(row, 1); return; }
+            outbuf.insert(outbuf.end(), row, row + n);
+            if (outbuf.size() >= (1 << 20)) {
+                writer->write_elements(outbuf.data(), sizeof(uint64_t), outbuf.size());
+                outbuf.clear();
+            }
+        });
+        if (writer) {
+            writer->write_elements(outbuf.data(), sizeof(uint64_t), outbuf.size());
+            writer->close();
+        }
+
+        if (!keep_tmp_files) std::filesystem::remove(infile);
+        return;
+    }
+
+    // Phase 1: Create Chunks using Producer-Consumer. bz2 streams cannot be concatenated, their
+    // runs are single files and their last pass stays sequential
+    const bool segmented = (n_threads > 1) && (out_ext != ".bz2");
+    std::vector<uint64_t> samples;
+    auto chunks = create_chunks_parallel(infile, tmp_dir, 
+                                         n_uint_per_element, 
+                                         max_ram_bytes, 
+                                         n_threads, 
+                                         verbose,
+                                         out_ext,
+                                         segmented,
+                                         samples);
+
+    if (chunks.size() == 1) {
+        // Single chunk created, just rename it (or give it to the color classes)
+        if (classes != nullptr) {
+            stream_to_classes(chunks[0], n_uint_per_element, classes);
+            remove_run(chunks[0]);
+        } else {
+            finalize_run(chunks[0], outfile);
+        }
+    } else if (chunks.size() > 1) {
         // Phase 2: Merge
-        multi_pass_nway_merge(chunknames, outfile, n_uint_per_element, max_ram_bytes, verbose);
+        multi_pass_nway_merge(chunks, outfile, n_uint_per_element, max_ram_bytes, verbose, classes, samples, n_threads, segmented);
+    } else if (classes == nullptr) {
+        // Empty input, the output still has to exist
+        std::unique_ptr<stream_writer> w(stream_writer_library::allocate(outfile)); w->close();
     }
 
     // Cleanup input if requested
@@ -489,6 +771,41 @@ void external_sort(const std::string& infile,
 
 
 
+void external_sort(const std::string& infile,
+                   const std::string& outfile,
+                   const std::string& tmp_dir,
+                   const uint64_t n_colors,
+                   const uint64_t ram_value_MB,
+                   const bool keep_tmp_files,
+                   const int verbose,
+                   int n_threads,
+                   const color_grouping grouping)
+{
+    external_sort_rows(infile, outfile, tmp_dir, n_colors, ram_value_MB, keep_tmp_files, verbose, n_threads, nullptr, grouping);
+}
+
+void external_sort_color_classes(const std::string& infile,
+                                 const std::string& table_file,
+                                 const std::string& ids_file,
+                                 const std::string& tmp_dir,
+                                 const uint64_t n_colors,
+                                 const uint64_t ram_value_MB,
+                                 const bool keep_tmp_files,
+                                 const int verbose,
+                                 int n_threads,
+                                 const color_grouping grouping)
+{
+    color_class_writer classes(table_file, ids_file, (n_colors + 63) / 64);
+
+    external_sort_rows(infile, ids_file, tmp_dir, n_colors, ram_value_MB, keep_tmp_files, verbose, n_threads, &classes, grouping);
+    classes.close();
+
+    if (verbose >= 3) {
+        std::cerr << "[III] Color classes : " << classes.classes() << " distinct color sets for "
+                  << classes.rows() << " minimizers\n";
+    }
+}
+
 bool check_file_sorted(const std::string& filename, uint64_t n_colors, bool verbose) {
     // 1. Calculate Element Size
     // Logic must match external_sort: 1 uint64 (minimizer) + N uint64 (colors)
@@ -524,10 +841,10 @@ bool check_file_sorted(const std::string& filename, uint64_t n_colors, bool verb
     // 4. Verification Loop
     while (true) {
         // Read a chunk of elements
-        int count = reader->read(buffer.data(), bytes_per_element, elems_per_chunk);
-        if (count <= 0) break; // EOF
+        size_t count = reader->read_elements(buffer.data(), bytes_per_element, elems_per_chunk);
+        if (count == 0) break; // EOF
 
-        for (int i = 0; i < count; ++i) {
+        for (size_t i = 0; i < count; ++i) {
             uint64_t* curr_ptr = &buffer[i * n_uint_per_element];
 
             if (first_element_seen) {
@@ -27,6 +27,12 @@ inline uint64_t get_file_size(const std::string& filen) {
     return file_status.st_size;
 }
 
+//
+// How rows with equal color sets are brought together : full sort by color, or hash grouping
+// (see hash_grouping.hpp), equal sets are adjacent but the groups are not ordered
+//
+enum color_grouping { GROUP_SORT = 0, GROUP_HASH = 1 };
+
 void external_sort (
     const std::string& infile,
     const std::string& outfile,
@@ -35,9 +41,35 @@ void external_sort (
     const uint64_t ram_value_MB,
     const bool keep_tmp_files,
     const int verbose_flag,
-    int n_threads
+    int n_threads,
+    const color_grouping grouping = GROUP_SORT
+);
+
+//
+// Same sort as external_sort, but the output is deduplicated : one bitmap per distinct color
+// set in table_file and the minimizer -> class id records in ids_file (see color_classes.hpp)
+//
+void external_sort_color_classes (
+    const std::string& infile,
+    const std::string& table_file,
+    const std::string& ids_file,
+    const std::string& tmp_dir,
+    const uint64_t n_colors,
+    const uint64_t ram_value_MB,
+    const bool keep_tmp_files,
+    const int verbose_flag,
+    int n_threads,
+    const color_grouping grouping = GROUP_SORT
 );
 
+//
+// Row layouts of the files sorted by external_sort_sparse. Both start with a header word :
+//  - SPARSE_LIST  : color count in the upper bits, ids packed MSB first
+//  - SPARSE_DELTA : payload length in the bits [40, 64), gaps packed LSB first
+//  - SPARSE_VBYTE : payload length - 1 in the bits [24, 40), StreamVByte gaps (sparse_codec.hpp)
+//
+enum sparse_layout { SPARSE_LIST = 0, SPARSE_DELTA = 1, SPARSE_VBYTE = 2 };
+
 void external_sort_sparse (
     const std::string& infile,
     const std::string& outfile,
@@ -46,7 +78,9 @@ void external_sort_sparse (
     const uint64_t ram_value_MB,
     const bool keep_tmp_files,
     const int verbose_flag,
-    int n_threads
+    int n_threads,
+    const sparse_layout layout = SPARSE_LIST,
+    const color_grouping grouping = GROUP_SORT
 );
 
 bool check_file_sorted(
@@ -58,5 +92,6 @@ bool check_file_sorted(
 bool check_file_sorted_sparse(
     const std::string& filename, 
     uint64_t n_colors, 
-    bool verbose = true
+    bool verbose = true,
+    const sparse_layout layout = SPARSE_LIST
 );
\ No newline at end of file
@@ -1,11 +1,14 @@
 #include "external_sort.hpp"
+#include "hash_grouping.hpp"
+#include "loser_tree.hpp"
+#include "../../merger/hybrid/sparse_codec.hpp"
 #include "../../files/stream_reader_library.hpp"
 #include "../../files/stream_writer_library.hpp"
+#include "../../tools/CMemoryBudget/CMemoryBudget.hpp"
 #include "../../../include/config.hpp"
 
 #include <algorithm>
 #include <vector>
-#include <queue>
 #include <cstring>
 #include <cmath>
 #include <filesystem>
@@ -19,15 +22,40 @@
 // Data Structures
 // =========================================================================
 
-struct Element {
-    uint64_t minimizer;
-    std::vector<uint64_t> payload; // [Header (contains size), ...Body...]
+// Rows are kept as they are stored, [minimizer][payload words], the payload starting with
+// its header. A batch is a flat arena of rows plus an index of (key, offset, length) entries,
+// the key being the first payload word : most comparisons end on it.
+struct RowRef {
+    uint64_t key;
+    uint64_t offset;   // of the minimizer in the arena
+    uint64_t n_words;  // payload words
 };
 
-// Comparator for sorting elements by payload (color sets)
-struct ElementCmp {
-    bool operator()(const Element& a, const Element& b) const {
-        return a.payload < b.payload;
+struct RowBatch {
+    std::vector<uint64_t> arena;
+    std::vector<RowRef>   index;
+
+    void clear() { arena.clear(); index.clear(); }
+    const uint64_t* row(const RowRef& r) const { return arena.data() + r.offset; }
+};
+
+// Order of the sparse files : payload words (lexicographic, shorter first on a common
+// prefix), then minimizer
+static inline bool row_less(const uint64_t* a, const uint64_t na, const uint64_t* b, const uint64_t nb) {
+    const uint64_t n = std::min(na, nb);
+    for (uint64_t i = 1; i <= n; i++) {
+        if (a[i] != b[i]) return a[i] < b[i];
+    }
+    if (na != nb) return na < nb;
+    return a[0] < b[0];
+}
+
+// Comparator for sorting the index of a batch (color sets, then minimizer)
+struct RowRefCmp {
+    const uint64_t* arena;
+    bool operator()(const RowRef& a, const RowRef& b) const {
+        if (a.key != b.key) return a.key < b.key;
+        return row_less(arena + a.offset, a.n_words, arena + b.offset, b.n_words);
     }
 };
 
@@ -37,9 +65,11 @@ struct ElementCmp {
 
 class BufferedPageReader {
 public:
-    BufferedPageReader(const std::string& filename, uint64_t bits_per_color, size_t buffer_size_bytes = 1024 * 1024 * 8)
+    BufferedPageReader(const std::string& filename, uint64_t bits_per_color, size_t buffer_size_bytes = 1024 * 1024 * 8,
+                       sparse_layout layout = SPARSE_LIST)
         : _bits_per_color(bits_per_color),
           _colors_per_word(64 / bits_per_color),
+          _layout(layout),
           _pos(0),
           _limit(0),
           _eof_reached(false) 
@@ -49,13 +79,6 @@ public:
             throw std::runtime_error("Could not open file: " + filename);
         }
 
-        // --- FIX 1: Cap Buffer to 1GB to prevent Integer Overflow in read() ---
-        // The underlying reader uses 'int' (max ~2GB). We cap at 1GB to be safe.
-        size_t max_safe_bytes = 1024ULL * 1024ULL * 1024ULL;
-        if (buffer_size_bytes > max_safe_bytes) {
-            buffer_size_bytes = max_safe_bytes;
-        }
-
         // Allocate buffer (ensure multiple of uint64_t)
         size_t num_words = std::max((size_t)1024, buffer_size_bytes / sizeof(uint64_t));
         _buffer.resize(num_words);
@@ -71,7 +94,8 @@ public:
     BufferedPageReader(const BufferedPageReader&) = delete;
     BufferedPageReader& operator=(const BufferedPageReader&) = delete;
 
-    bool next(Element& out) {
+    // Points row to the next [minimizer][payload] of the file, valid up to the next call
+    bool next(const uint64_t*& row, size_t& n_payload_words) {
         // 1. We need at least 2 words to start (Minimizer + Header)
         if (!ensure_available(2)) {
             return false;
@@ -79,8 +103,15 @@ public:
 
         // 2. Decode size from Header (2nd word in buffer relative to pos)
         uint64_t header = _buffer[_pos + 1];
-        uint64_t list_size = header >> (64 - _bits_per_color);
-        size_t n_payload_words = (list_size + _colors_per_word) / _colors_per_word;
+        if (_layout == SPARSE_DELTA) {
+            // gap stream length is stored in the header (see tier_policy.hpp)
+            n_payload_words = 1 + (header >> 40);
+        } else if (_layout == SPARSE_VBYTE) {
+            n_payload_words = 1 + vbyte_extra_words(header);
+        } else {
+            uint64_t list_size = header >> (64 - _bits_per_color);
+            n_payload_words = (list_size + _colors_per_word) / _colors_per_word;
+        }
         size_t total_words_needed = 1 + n_payload_words;
 
         // 3. Ensure the FULL element is in the buffer
@@ -90,22 +121,24 @@ public:
              throw std::runtime_error("Sparse element size exceeds buffer size! Increase min buffer.");
         }
 
-        // 4. Extract Data
-        out.minimizer = _buffer[_pos++];
-        out.payload.resize(n_payload_words);
-        std::memcpy(out.payload.data(), &_buffer[_pos], n_payload_words * sizeof(uint64_t));
-        _pos += n_payload_words;
+        // 4. The row stays in the buffer
+        row   = &_buffer[_pos];
+        _pos += total_words_needed;
 
         return true;
     }
 
-    size_t fill_batch(std::vector<Element>& batch, size_t max_words) {
+    // Appends rows to the batch up to max_words words (rows and index entries)
+    size_t fill_batch(RowBatch& batch, size_t max_words) {
+        const uint64_t index_words = sizeof(RowRef) / sizeof(uint64_t);
         size_t words_read = 0;
-        Element el;
+        const uint64_t* row;
+        size_t n_words;
         while (words_read < max_words) {
-            if (!next(el)) break;
-            words_read += (1 + el.payload.size());
-            batch.push_back(std::move(el));
+            if (!next(row, n_words)) break;
+            batch.index.push_back({ row[1], batch.arena.size(), n_words });
+            batch.arena.insert(batch.arena.end(), row, row + 1 + n_words);
+            words_read += 1 + n_words + index_words;
         }
         return words_read;
     }
@@ -114,6 +147,7 @@ private:
     std::unique_ptr<stream_reader> _reader;
     const uint64_t _bits_per_color;
     const uint64_t _colors_per_word;
+    const sparse_layout _layout;
     
     std::vector<uint64_t> _buffer;
     size_t _pos;    
@@ -136,18 +170,16 @@ private:
         // Read new data
         size_t words_capacity = _buffer.size() - _limit;
         
-        // This cast is now safe because we capped _buffer size in constructor
-        int words_read_count = _reader->read(
+        // 64-bit read, the buffer size is only bounded by the RAM budget
+        size_t words_read_count = _reader->read_elements(
             (void*)(_buffer.data() + _limit), 
             sizeof(uint64_t), 
-            (int)words_capacity
+            words_capacity
         );
 
-        if (words_read_count > 0) {
-            _limit += words_read_count;
-        }
+        _limit += words_read_count;
 
-        if (words_read_count < (int)words_capacity || _reader->is_eof()) {
+        if (words_read_count < words_capacity || _reader->is_eof()) {
             _eof_reached = true;
         }
 
@@ -166,23 +198,26 @@ private:
 // Verification Logic
 // =========================================================================
 
-bool check_file_sorted_sparse(const std::string& filename, uint64_t bits_per_color, bool verbose_flag) {
+bool check_file_sorted_sparse(const std::string& filename, uint64_t bits_per_color, bool verbose_flag, const sparse_layout layout) {
     uint64_t idx = 0;
     try {
-        BufferedPageReader reader(filename, bits_per_color);
-        Element prev, curr;
-        
-        if (!reader.next(prev)) {
+        BufferedPageReader reader(filename, bits_per_color, 1024 * 1024 * 8, layout);
+        std::vector<uint64_t> prev;
+        const uint64_t* curr;
+        size_t n_words;
+
+        if (!reader.next(curr, n_words)) {
             if (verbose_flag) std::cout << "File is empty.\n";
             return true;
         }
+        prev.assign(curr, curr + 1 + n_words);
 
-        while (reader.next(curr)) {
-            if (prev.payload > curr.payload) {
+        while (reader.next(curr, n_words)) {
+            if (row_less(curr, n_words, prev.data(), prev.size() - 1)) {
                 std::cout << "File not sorted at index " << idx + 1 << "\n";
                 return false;
             }
-            prev = std::move(curr);
+            prev.assign(curr, curr + 1 + n_words);
             idx++;
         }
     } catch (const std::exception& e) {
@@ -198,14 +233,23 @@ bool check_file_sorted_sparse(const std::string& filename, uint64_t bits_per_col
 // Phase 1: Create Sorted Chunks
 // =========================================================================
 
-void write_chunk(const std::vector<Element>& batch, const std::string& filename) {
+static const size_t STAGE_WORDS = 1 << 16;
+
+void write_chunk(const RowBatch& batch, const std::string& filename) {
     std::unique_ptr<stream_writer> writer(stream_writer_library::allocate(filename));
     if (!writer || !writer->is_open()) throw std::runtime_error("Cannot open output chunk: " + filename);
 
-    for (const auto& el : batch) {
-        writer->write((void*)&el.minimizer, sizeof(uint64_t), 1);
-        writer->write((void*)el.payload.data(), sizeof(uint64_t), el.payload.size());
+    std::vector<uint64_t> stage;
+    stage.reserve(STAGE_WORDS);
+    for (const auto& r : batch.index) {
+        const uint64_t* row = batch.row(r);
+        stage.insert(stage.end(), row, row + 1 + r.n_words);
+        if (stage.size() >= STAGE_WORDS) {
+            writer->write_elements(stage.data(), sizeof(uint64_t), stage.size());
+            stage.clear();
+        }
     }
+    writer->write_elements(stage.data(), sizeof(uint64_t), stage.size());
     writer->close();
 }
 
@@ -215,10 +259,11 @@ std::vector<std::string> parallel_create_chunks(
     uint64_t max_words_in_RAM,
     int bits_per_color,
     int verbose,
-    int num_threads
+    int num_threads,
+    sparse_layout layout
 ) {
     std::vector<std::string> chunk_files;
-    BufferedPageReader reader(infile, bits_per_color); // 1GB max buffer implicitly
+    BufferedPageReader reader(infile, bits_per_color, 1024 * 1024 * 8, layout);
     omp_lock_t read_lock;
     omp_init_lock(&read_lock);
 
@@ -228,9 +273,11 @@ std::vector<std::string> parallel_create_chunks(
 
     #pragma omp parallel num_threads(num_threads) shared(done, chunk_files)
     {
+        RowBatch batch;
+        batch.arena.reserve(ram_per_thread);
+
         while (true) {
-            std::vector<Element> batch;
-            batch.reserve(ram_per_thread / 4); 
+            batch.clear();
 
             omp_set_lock(&read_lock);
             if (done) {
@@ -239,14 +286,14 @@ std::vector<std::string> parallel_create_chunks(
             }
             // reader is NOT thread safe, but protected by lock here.
             reader.fill_batch(batch, ram_per_thread);
-            if (batch.empty()) {
+            if (batch.index.empty()) {
                 done = true;
                 omp_unset_lock(&read_lock);
                 break;
             }
             omp_unset_lock(&read_lock);
 
-            std::sort(batch.begin(), batch.end(), ElementCmp());
+            std::sort(batch.index.begin(), batch.index.end(), RowRefCmp{ batch.arena.data() });
 
             int id = chunk_counter.fetch_add(1);
             std::string outname = tmp_dir + "/sparse_chunk_" + std::to_string(id) + ".lz4";
@@ -264,18 +311,13 @@ std::vector<std::string> parallel_create_chunks(
 // Phase 2: N-Way Merge
 // =========================================================================
 
-struct MergeNode {
-    Element el;
-    int stream_idx;
-    bool operator>(const MergeNode& other) const { return el.payload > other.el.payload; }
-};
-
 void nway_merge_sparse(
     const std::vector<std::string>& chunk_files,
     const std::string& outfile,
     int bits_per_color,
     int verbose,
-    uint64_t ram_budget_bytes
+    uint64_t ram_budget_bytes,
+    sparse_layout layout
 ) {
     int n_files = chunk_files.size();
     if (n_files == 0) return;
@@ -292,60 +334,94 @@ void nway_merge_sparse(
         if (verbose >= 3) std::cout << "[Warning] RAM tight, enforcing 64KB min buffer per file.\n";
     }
 
-    // The Constructor of BufferedPageReader will cap this at 1GB automatically (Fix 1)
     std::vector<std::unique_ptr<BufferedPageReader>> readers;
     readers.reserve(n_files);
 
     for (const auto& f : chunk_files) {
-        readers.push_back(std::make_unique<BufferedPageReader>(f, bits_per_color, buffer_size_per_file));
+        readers.push_back(std::make_unique<BufferedPageReader>(f, bits_per_color, buffer_size_per_file, layout));
     }
 
-    std::priority_queue<MergeNode, std::vector<MergeNode>, std::greater<MergeNode>> pq;
+    // Stream heads point into the reader buffers, nothing is copied before the output stage
+    std::vector<const uint64_t*> heads(n_files, nullptr);
+    std::vector<size_t>          sizes(n_files, 0);
+    auto tie = [&](const size_t a, const size_t b) { return row_less(heads[a], sizes[a], heads[b], sizes[b]); };
+    loser_tree<decltype(tie)> tree(n_files, tie);
 
     for (int i = 0; i < n_files; ++i) {
-        Element el;
-        if (readers[i]->next(el)) {
-            pq.push({std::move(el), i});
-        }
+        if (readers[i]->next(heads[i], sizes[i])) tree.set(i, heads[i][1]);
     }
+    tree.build();
 
     std::unique_ptr<stream_writer> writer(stream_writer_library::allocate(outfile));
     if (!writer || !writer->is_open()) throw std::runtime_error("Cannot open output: " + outfile);
 
-    while (!pq.empty()) {
-        MergeNode node = pq.top();
-        pq.pop();
-
-        writer->write((void*)&node.el.minimizer, sizeof(uint64_t), 1);
-        writer->write((void*)node.el.payload.data(), sizeof(uint64_t), node.el.payload.size());
-
-        if (readers[node.stream_idx]->next(node.el)) {
-            pq.push(std::move(node));
+    std::vector<uint64_t> stage;
+    stage.reserve(STAGE_WORDS);
+    while (!tree.empty()) {
+        const size_t i = tree.top();
+        stage.insert(stage.end(), heads[i], heads[i] + 1 + sizes[i]);
+        if (stage.size() >= STAGE_WORDS) {
+            writer->write_elements(stage.data(), sizeof(uint64_t), stage.size());
+            stage.clear();
         }
+
+        if (readers[i]->next(heads[i], sizes[i])) tree.replace_top(heads[i][1]);
+        else                                      tree.pop_top();
     }
+    writer->write_elements(stage.data(), sizeof(uint64_t), stage.size());
     writer->close();
 }
 
 void external_sort_sparse(const std::string& infile, const std::string& outfile, const std::string& tmp_dir,
                           const uint64_t n_colors, const uint64_t ram_value_MB, const bool keep_tmp_files,
-                          const int verbose, int n_threads) {
+                          const int verbose, int n_threads, const sparse_layout layout, const color_grouping grouping) {
     uint64_t bits_per_color = std::ceil(std::log2(n_colors));
     if (bits_per_color <= 8) bits_per_color = 8;
     else if (bits_per_color <= 16) bits_per_color = 16;
     else if (bits_per_color <= 32) bits_per_color = 32;
     else bits_per_color = 64;
 
-    const uint64_t bytes_in_RAM = ram_value_MB * 1024ULL * 1024ULL;
+    // Runs and merge buffers are taken from the process memory budget
+    CMemoryBudget::lease memory(ram_value_MB * 1024ULL * 1024ULL / 4, ram_value_MB * 1024ULL * 1024ULL);
+    const uint64_t bytes_in_RAM = memory.bytes();
     const uint64_t max_words_in_RAM = bytes_in_RAM / sizeof(uint64_t);
 
-    auto chunk_files = parallel_create_chunks(infile, tmp_dir, max_words_in_RAM, bits_per_color, verbose, n_threads);
+    if (grouping == GROUP_HASH) {
+        // Same row sizes as BufferedPageReader : minimizer + header + colors
+        const uint64_t colors_per_word = 64 / bits_per_color;
+        auto row_words = [=](const uint64_t* row) -> uint64_t {
+            const uint64_t header = row[1];
+            if (layout == SPARSE_DELTA) return 2 + (header >> 40);
+            if (layout == SPARSE_VBYTE) return 2 + vbyte_extra_words(header);
+            return 1 + ((header >> (64 - bits_per_color)) + colors_per_word) / colors_per_word;
+        };
+
+        std::unique_ptr<stream_writer> writer(stream_writer_library::allocate(outfile));
+        if (!writer || !writer->is_open()) throw std::runtime_error("Cannot open output: " + outfile);
+        std::vector<uint64_t> outbuf;
+        outbuf.reserve(1 << 20);
+
+        hash_grouping grouper(row_words, bytes_in_RAM, tmp_dir + "/sparse_group", std::filesystem::path(outfile).extension().string(), verbose);
+        grouper.run(infile, [&](const uint64_t* row, const uint64_t n) {
+            outbuf.insert(outbuf.end(), row, row + n);
+            if (outbuf.size() >= (1 << 20)) {
+                writer->write_elements(outbuf.data(), sizeof(uint64_t), outbuf.size());
+                outbuf.clear();
+            }
+        });
+        writer->write_elements(outbuf.data(), sizeof(uint64_t), outbuf.size());
+        writer->close();
+        return;
+    }
+
+    auto chunk_files = parallel_create_chunks(infile, tmp_dir, max_words_in_RAM, bits_per_color, verbose, n_threads, layout);
 
     if (chunk_files.empty()) {
         std::unique_ptr<stream_writer> w(stream_writer_library::allocate(outfile)); w->close();
     } else if (chunk_files.size() == 1) {
         std::filesystem::rename(chunk_files[0], outfile);
     } else {
-        nway_merge_sparse(chunk_files, outfile, bits_per_color, verbose, bytes_in_RAM);
+        nway_merge_sparse(chunk_files, outfile, bits_per_color, verbose, bytes_in_RAM, layout);
     }
 
     if (!keep_tmp_files) {
@@ -0,0 +1,249 @@
+#include "hash_grouping.hpp"
+#include "../../files/stream_reader_library.hpp"
+#include "../../files/stream_writer_library.hpp"
+#include "../../hash/CustomMurmurHash3.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include <filesystem>
+
+hash_grouping::hash_grouping(const row_words_fn& i_row_words, const uint64_t max_ram_bytes, const std::string& i_tmp_prefix, const std::string& i_extension, const int i_verbose)
+    : row_words    ( i_row_words ),
+      max_ram_words( std::max((uint64_t)65536, max_ram_bytes / sizeof(uint64_t)) ),
+      tmp_prefix   ( i_tmp_prefix ),
+      extension    ( i_extension ),
+      verbose      ( i_verbose )
+{
+    //
+    // Half of the budget holds the rows, the rest goes to the grouping index (see fits_in_memory)
+    // or to the bucket stages of partition
+    //
+    buffer.resize( max_ram_words / 2 );
+}
+
+//
+// Index of group_in_memory per row : offset and hash (16 B), slot (< 4 slots of 4 B per row),
+// next (4 B), head and tail (8 B)
+//
+static constexpr uint64_t index_bytes_per_row = 16 + 16 + 4 + 8;
+
+bool hash_grouping::fits_in_memory(const uint64_t n_words, uint64_t& n_rows) const
+{
+    n_rows = 0;
+    for(uint64_t pos = 0; pos < n_words; n_rows += 1)
+        pos += row_words( buffer.data() + pos );
+
+    const uint64_t budget = max_ram_words * sizeof(uint64_t);
+    const uint64_t rows   = buffer.size() * sizeof(uint64_t); // allocated, whatever the part in use
+    return (n_rows < UINT32_MAX) && (rows + n_rows * index_bytes_per_row <= budget);
+}
+
+uint64_t hash_grouping::hash(const uint64_t* payload, const uint64_t n_words)
+{
+    uint64_t h = n_words;
+    for(uint64_t i = 0; i < n_words; i += 1)
+        h = rotl64(h ^ fmix64(payload[i] + i), 27) * BIG_CONSTANT(0x9e3779b97f4a7c15);
+    return fmix64( h );
+}
+
+void hash_grouping::run(const std::string& infile, const row_sink_fn& sink)
+{
+    process(infile, 0, sink);
+}
+
+void hash_grouping::process(const std::string& infile, const int depth, const row_sink_fn& sink)
+{
+    stream_reader* reader = stream_reader_library::allocate( infile );
+    if (!reader || !reader->is_open())
+        throw std::runtime_error("Cannot open input: " + infile);
+
+    const uint64_t limit = reader->read_elements(buffer.data(), sizeof(uint64_t), buffer.size());
+    const bool     eof   = (limit < buffer.size());
+
+    //
+    // Narrow rows can need more index than the half of the budget left to it : such a bucket
+    // is split further
+    //
+    uint64_t n_rows = 0;
+    if( (eof == true) && fits_in_memory(limit, n_rows) )
+    {
+        delete reader;
+        group_in_memory(limit, n_rows, sink);
+        return;
+    }
+
+    //
+    // The buckets are processed once the reader and the stages of this level are released, only
+    // the rows buffer is shared between the levels
+    //
+    std::vector<std::string> names;
+    const bool same_hash = partition(infile, reader, limit, eof, depth, names, sink);
+    delete reader;
+
+    for(const std::string& name : names)
+    {
+        if( name.empty() == true )
+            continue;
+        process(name, same_hash ? max_depth : depth + 1, sink);
+        std::filesystem::remove( name );
+    }
+}
+
+bool hash_grouping::partition(const std::string& infile, stream_reader* reader, uint64_t limit, bool eof, const int depth, std::vector<std::string>& names, const row_sink_fn& sink)
+{
+    //
+    // Every row of this file shares the hash bits already used, nothing left to split on : the
+    // rows are sent as they are (hash collisions only, the equal color sets are all here)
+    //
+    const bool passthrough = (depth >= max_depth);
+    if( (passthrough == true) && (verbose >= 3) )
+        std::cerr << "[III] Hash grouping : " << infile << " cannot be split any further\n";
+
+    //
+    // The stages take the part of the budget left by the rows buffer
+    //
+    const uint64_t stage_words = std::min((uint64_t)8192, (max_ram_words - buffer.size()) / fan_out);
+    std::vector<std::unique_ptr<stream_writer>> writers( fan_out );
+    std::vector<std::vector<uint64_t>>          stages ( fan_out );
+    names.assign( fan_out, std::string() );
+
+    auto flush = [&](const int b) {
+        if( writers[b] == nullptr )
+        {
+            names  [b] = tmp_prefix + ".d" + std::to_string(depth) + ".b" + std::to_string(b) + extension;
+            writers[b].reset( stream_writer_library::allocate(names[b]) );
+            if( !writers[b]->is_open() )
+                throw std::runtime_error("Cannot open bucket: " + names[b]);
+        }
+        writers[b]->write_elements(stages[b].data(), sizeof(uint64_t), stages[b].size());
+        stages [b].clear();
+    };
+
+    //
+    // A single color set larger than the RAM budget keeps the same hash at every level, it is
+    // detected here so that it is not split again and again
+    //
+    bool     same_hash  = true;
+    uint64_t first_hash = 0;
+    bool     first_row  = true;
+
+    const uint64_t shift = 58 - 6 * depth;
+    uint64_t       pos   = 0;
+    while( true )
+    {
+        while( pos + 2 <= limit )
+        {
+            const uint64_t* row = buffer.data() + pos;
+            const uint64_t  n   = row_words( row );
+            if( pos + n > limit )
+                break;
+            if( n > buffer.size() )
+                throw std::runtime_error("Row larger than the grouping buffer: " + infile);
+
+            if( passthrough == true )
+            {
+                sink(row, n);
+            }
+            else
+            {
+                const uint64_t h = hash(row + 1, n - 1);
+                if( first_row == true ){ first_hash = h; first_row = false; }
+                same_hash &= (h == first_hash);
+                const int b = (h >> shift) & (fan_out - 1);
+                if( (stages[b].empty() == false) && (stages[b].size() + n > stage_words) )
+                    flush( b );
+                if( stages[b].capacity() == 0 )
+                    stages[b].reserve( stage_words );
+                stages[b].insert(stages[b].end(), row, row + n);
+            }
+            pos += n;
+        }
+
+        if( eof == true )
+            break;
+
+        const uint64_t remaining = limit - pos;
+        std::memmove(buffer.data(), buffer.data() + pos, remaining * sizeof(uint64_t));
+        const uint64_t got = reader->read_elements(buffer.data() + remaining, sizeof(uint64_t), buffer.size() - remaining);
+        pos   = 0;
+        limit = remaining + got;
+        eof   = (got < buffer.size() - remaining);
+    }
+
+    if( pos != limit )
+        throw std::runtime_error("Truncated row at the end of: " + infile);
+
+    for(int b = 0; b < fan_out; b += 1)
+    {
+        if( stages[b].empty() == false ) flush( b );
+        writers[b].reset();
+    }
+    return same_hash;
+}
+
+void hash_grouping::group_in_memory(const uint64_t n_words, const uint64_t n_rows, const row_sink_fn& sink)
+{
+    //
+    // Row offsets and hashes (n_rows < UINT32_MAX, the row ids of the table are 32-bit)
+    //
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> hashes;
+    offsets.reserve( n_rows + 1 );
+    hashes .reserve( n_rows     );
+    for(uint64_t pos = 0; pos < n_words; )
+    {
+        const uint64_t* row = buffer.data() + pos;
+        const uint64_t  n   = row_words( row );
+        if( pos + n > n_words )
+            throw std::runtime_error("Truncated row in a grouping bucket");
+        offsets.push_back( pos );
+        hashes .push_back( hash(row + 1, n - 1) );
+        pos += n;
+    }
+    offsets.push_back( n_words );
+
+    //
+    // Open addressing table : slot -> group, each group is a linked list of rows
+    //
+    uint64_t n_slots = 1;
+    while( n_slots < 2 * n_rows ) n_slots <<= 1;
+    std::vector<uint32_t> slots(n_slots, UINT32_MAX);
+    std::vector<uint32_t> head, tail;
+    std::vector<uint32_t> next(n_rows, UINT32_MAX);
+    head.reserve( n_rows );
+    tail.reserve( n_rows );
+
+    for(uint64_t r = 0; r < n_rows; r += 1)
+    {
+        const uint64_t* row = buffer.data() + offsets[r];
+        const uint64_t  n   = offsets[r + 1] - offsets[r];
+        uint64_t s = hashes[r] & (n_slots - 1);
+        while( true )
+        {
+            const uint32_t g = slots[s];
+            if( g == UINT32_MAX )
+            {
+                slots[s] = head.size();
+                head.push_back( r );
+                tail.push_back( r );
+                break;
+            }
+            const uint32_t h = head[g];
+            if( (hashes[h] == hashes[r]) && (offsets[h + 1] - offsets[h] == n) &&
+                (std::memcmp(buffer.data() + offsets[h] + 1, row + 1, (n - 1) * sizeof(uint64_t)) == 0) )
+            {
+                next[tail[g]] = r;
+                tail[g]       = r;
+                break;
+            }
+            s = (s + 1) & (n_slots - 1);
+        }
+    }
+
+    for(uint64_t g = 0; g < head.size(); g += 1)
+        for(uint32_t r = head[g]; r != UINT32_MAX; r = next[r])
+            sink(buffer.data() + offsets[r], offsets[r + 1] - offsets[r]);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+class stream_reader;
+
+//
+// Streaming grouping of rows [minimizer][payload ...] by payload, an alternative to sorting
+// them by color when only the adjacency of equal color sets matters.
+//
+// The input is loaded in RAM when it fits, the rows are then grouped with a hash table in one
+// linear pass. Otherwise the rows are partitioned on their payload hash into fan_out bucket
+// files, each of them being processed the same way with the next bits of the hash. Groups are
+// emitted in order of first appearance, rows of a group keep their input (minimizer) order.
+//
+class hash_grouping
+{
+public:
+    typedef std::function<uint64_t(const uint64_t* row)>                    row_words_fn; // row size, minimizer included
+    typedef std::function<void    (const uint64_t* row, const uint64_t n)> row_sink_fn;  // n words of complete rows
+
+    static constexpr int fan_out   = 64;
+    static constexpr int max_depth = 10; // 6 bits of hash per level
+
+private:
+    const row_words_fn row_words;
+    const uint64_t     max_ram_words;
+    const std::string  tmp_prefix;
+    const std::string  extension;
+    const int          verbose;
+
+    std::vector<uint64_t> buffer;
+
+    bool fits_in_memory (const uint64_t n_words, uint64_t& n_rows) const;
+    void group_in_memory(const uint64_t n_words, const uint64_t n_rows, const row_sink_fn& sink);
+    bool partition      (const std::string& infile, stream_reader* reader, uint64_t limit, bool eof, const int depth, std::vector<std::string>& names, const row_sink_fn& sink);
+    void process        (const std::string& infile, const int depth, const row_sink_fn& sink);
+
+public:
+    hash_grouping(const row_words_fn& row_words, const uint64_t max_ram_bytes, const std::string& tmp_prefix, const std::string& extension, const int verbose);
+
+    void run(const std::string& infile, const row_sink_fn& sink);
+
+    static uint64_t hash(const uint64_t* payload, const uint64_t n_words);
+};
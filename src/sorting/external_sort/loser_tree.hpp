@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+//
+// Tournament (loser) tree over k sorted streams, for the k-way merges of the external sorts.
+//
+// Each stream head is represented by a 64-bit key cached in the tree, heads are compared on
+// their keys and tie(a, b) (true when the head of stream a is smaller than the one of stream b)
+// is only called when the keys are equal. Replacing the winner costs log2(k) key comparisons
+// on the path to the root, against about 2.log2(k) full comparisons for a binary heap.
+//
+// Usage : set() or done() every stream, build(), then top() / replace_top() / pop_top() until
+// empty().
+//
+template <class TieLess>
+class loser_tree
+{
+private:
+    const size_t          k;
+    TieLess               tie;
+    std::vector<uint64_t> keys;
+    std::vector<uint8_t>  dead;   // exhausted streams, larger than everything
+    std::vector<size_t>   tree;   // tree[0] = winner, tree[1..k-1] = loser of each match
+    size_t                alive;
+
+    inline bool less(const size_t a, const size_t b) const
+    {
+        if( dead[a] ) return false;
+        if( dead[b] ) return true;
+        if( keys[a] != keys[b] ) return keys[a] < keys[b];
+        return tie(a, b);
+    }
+
+    //
+    // Winner of the sub-tree rooted at node, leaves are the nodes [k, 2k)
+    //
+    size_t play(const size_t node)
+    {
+        if( node >= k )
+            return node - k;
+        const size_t l = play(2 * node    );
+        const size_t r = play(2 * node + 1);
+        if( less(r, l) ){ tree[node] = l; return r; }
+        tree[node] = r;
+        return l;
+    }
+
+    void replay(size_t winner)
+    {
+        for(size_t node = (winner + k) / 2; node >= 1; node /= 2)
+            if( less(tree[node], winner) )
+                std::swap(tree[node], winner);
+        tree[0] = winner;
+    }
+
+public:
+    loser_tree(const size_t n_streams, const TieLess& i_tie)
+        : k( n_streams ), tie( i_tie ), keys( n_streams, 0 ), dead( n_streams, 1 ), tree( n_streams, 0 ), alive( 0 )
+    {
+    }
+
+    void set (const size_t s, const uint64_t key) { keys[s] = key; if( dead[s] ){ dead[s] = 0; alive += 1; } }
+    void done(const size_t s)                     { if( !dead[s] ){ dead[s] = 1; alive -= 1; } }
+
+    void build()
+    {
+        if( k != 0 )
+            tree[0] = play(1);
+    }
+
+    bool   empty() const { return alive == 0; }
+    size_t top  () const { return tree[0];    }
+
+    //
+    // The winner stream moved to its next head / is exhausted
+    //
+    void replace_top(const uint64_t key) { keys[tree[0]] = key; replay( tree[0] ); }
+    void pop_top    ()                   { done( tree[0] );     replay( tree[0] ); }
+};
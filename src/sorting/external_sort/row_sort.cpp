@@ -0,0 +1,59 @@
+#include "row_sort.hpp"
+
+#include <utility>
+
+void sort_rows(const uint64_t* rows, const uint64_t n_rows, const uint64_t n_words, std::vector<key_index>& order)
+{
+    order.resize( n_rows );
+    if( n_rows == 0 )
+        return;
+
+    //
+    // Words are looked at in the order 1, 2, ..., n_words-1 then 0
+    //
+    auto next_word = [n_words](const uint64_t w) -> uint64_t {
+        return (w == 0) ? n_words : ((w + 1 < n_words) ? w + 1 : 0);
+    };
+
+    const uint64_t first = (n_words > 1) ? 1 : 0;
+    for(uint64_t i = 0; i < n_rows; i += 1)
+    {
+        order[i].key   = row_key(rows + i * n_words, first);
+        order[i].index = i;
+    }
+
+    //
+    // Pending ranges [begin, end) whose keys hold the word w of their rows
+    //
+    struct range { uint64_t begin; uint64_t end; uint64_t w; };
+    std::vector<range> todo;
+    todo.push_back( {0, n_rows, first} );
+
+    while( todo.empty() == false )
+    {
+        const range r = todo.back();
+        todo.pop_back();
+
+        key_index* base = order.data() + r.begin;
+        crumsort_key_index(base, r.end - r.begin);
+
+        const uint64_t nw = next_word( r.w );
+        if( nw == n_words )
+            continue; // the minimizer was the last word to compare
+
+        uint64_t s = r.begin;
+        while( s < r.end )
+        {
+            uint64_t e = s + 1;
+            while( (e < r.end) && (order[e].key == order[s].key) )
+                e += 1;
+            if( e - s > 1 )
+            {
+                for(uint64_t i = s; i < e; i += 1)
+                    order[i].key = row_key(rows + order[i].index * n_words, nw);
+                todo.push_back( {s, e, nw} );
+            }
+            s = e;
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../crumsort/crumsort.hpp"
+
+//
+// Key of a row for its word w : the color words are byte swapped (memcmp order), the
+// minimizer (word 0) is compared as a number
+//
+inline uint64_t row_key(const uint64_t* row, const uint64_t w)
+{
+    return (w == 0) ? row[0] : __builtin_bswap64( row[w] );
+}
+
+//
+// Sort of n_rows fixed width rows [minimizer][n_words-1 color words] in the external sort
+// order : memcmp over the color words, then the minimizer value.
+//
+// The rows are not moved nor compared as a whole, each row is represented by a (key, index)
+// pair where key is one of its words, byte swapped so that the integer order of the keys is
+// the memcmp order of the words. The pairs are sorted on the first color word, the runs of
+// equal keys are then refined on the next word, and so on up to the minimizer. Only the rows
+// sharing a prefix are looked at again, a 4096-color row is rarely read past its first words.
+//
+// On return order[i].index is the index of the i-th smallest row.
+//
+extern void sort_rows(const uint64_t* rows, const uint64_t n_rows, const uint64_t n_words, std::vector<key_index>& order);
@@ -0,0 +1,89 @@
+#include "radix_lsd.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <omp.h>
+
+static const uint64_t radix_bits    = 11; // 6 passes, a 16 KB histogram per thread
+static const uint64_t radix_buckets = 1 << radix_bits;
+static const uint64_t min_per_thread = 1 << 16;
+
+void radix_lsd(uint64_t* data, const uint64_t n, const int threads)
+{
+    if( n < 2 )
+        return;
+
+    const int n_threads = (int)std::max<uint64_t>(1, std::min<uint64_t>(threads, n / min_per_thread));
+
+    //
+    // Bytes that differ between at least two keys, the other passes are identities
+    //
+    uint64_t all_and = UINT64_MAX;
+    uint64_t all_or  = 0;
+#pragma omp parallel for num_threads(n_threads) reduction(&:all_and) reduction(|:all_or)
+    for(uint64_t i = 0; i < n; i += 1)
+    {
+        all_and &= data[i];
+        all_or  |= data[i];
+    }
+    const uint64_t varying = all_and ^ all_or;
+
+    std::vector<uint64_t> passes;
+    for(uint64_t shift = 0; shift < 64; shift += radix_bits)
+        if( ((varying >> shift) & (radix_buckets - 1)) != 0 )
+            passes.push_back( shift );
+    if( passes.empty() )
+        return;
+
+    std::unique_ptr<uint64_t[]> buffer( new uint64_t[n] ); // not zeroed
+    std::vector<uint64_t> offsets( n_threads * radix_buckets );
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        const int      t     = omp_get_thread_num();
+        const uint64_t start = n *  t      / n_threads;
+        const uint64_t stop  = n * (t + 1) / n_threads;
+        uint64_t*      count = offsets.data() + t * radix_buckets;
+
+        uint64_t* src = data;
+        uint64_t* dst = buffer.get();
+        for(const uint64_t shift : passes)
+        {
+            std::fill(count, count + radix_buckets, 0);
+            for(uint64_t i = start; i < stop; i += 1)
+                count[(src[i] >> shift) & (radix_buckets - 1)] += 1;
+#pragma omp barrier
+
+#pragma omp single
+            {
+                uint64_t sum = 0;
+                for(uint64_t d = 0; d < radix_buckets; d += 1)
+                {
+                    for(int th = 0; th < n_threads; th += 1)
+                    {
+                        const uint64_t c = offsets[th * radix_buckets + d];
+                        offsets[th * radix_buckets + d] = sum;
+                        sum += c;
+                    }
+                }
+            } // implicit barrier
+
+            for(uint64_t i = start; i < stop; i += 1)
+                dst[count[(src[i] >> shift) & (radix_buckets - 1)]++] = src[i];
+#pragma omp barrier
+            std::swap(src, dst);
+        }
+
+        //
+        // Odd number of passes : the sorted keys are in the buffer
+        //
+        if( src != data )
+            memcpy(data + start, src + start, (stop - start) * sizeof(uint64_t));
+    }
+}
+
+void radix_lsd(std::vector<uint64_t>& data, const int threads)
+{
+    radix_lsd(data.data(), data.size(), threads);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//
+// LSD radix sort of uint64 keys, 11 bits per pass (stable counting scatter through a buffer
+// of the same size). The bytes that are the same for all the keys are skipped, which saves
+// the high passes when the keys are small.
+//
+// With threads > 1 each pass is split in contiguous chunks : every thread builds the
+// histogram of its chunk, the (digit, thread) offsets are scanned once, then every thread
+// scatters its chunk. Small inputs are sorted by a single thread.
+//
+extern void radix_lsd(uint64_t* data, const uint64_t n, const int threads = 1);
+extern void radix_lsd(std::vector<uint64_t>& data, const int threads = 1);
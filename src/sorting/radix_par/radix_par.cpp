@@ -0,0 +1,287 @@
+#include "radix_par.hpp"
+#include "../crumsort/crumsort.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <omp.h>
+
+static const uint64_t radix_buckets  = 256;
+static const uint64_t leaf_size      = 1 << 16;   // crumsort below (512 KB, in L2)
+static const uint64_t min_per_thread = 1 << 16;
+
+static inline uint64_t digit(const uint64_t v, const int shift)
+{
+    return (v >> shift) & (radix_buckets - 1);
+}
+
+static inline int next_shift(const int shift)
+{
+    return (shift >= 8) ? (shift - 8) : ((shift > 0) ? 0 : -1);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+//
+// Moves the keys found in [head[b], tail[b]) to the free slots of their bucket. The keys
+// before head[b] are placed, a key whose bucket has no free slot left is put back and stops
+// the processing of its range (with a single range per bucket this never happens).
+//
+static void permute(uint64_t* a, uint64_t* head, const uint64_t* tail, const int shift)
+{
+    for(uint64_t b = 0; b < radix_buckets; b += 1)
+    {
+        while( head[b] < tail[b] )
+        {
+            uint64_t v = a[head[b]];
+            uint64_t d = digit(v, shift);
+            while( (d != b) && (head[d] < tail[d]) )
+            {
+                std::swap(v, a[head[d]]);
+                head[d] += 1;
+                d = digit(v, shift);
+            }
+            a[head[b]] = v;
+            if( d != b )
+                break;
+            head[b] += 1;
+        }
+    }
+}
+
+static void flag_sort(uint64_t* a, const uint64_t n, const int shift)
+{
+    if( n <= leaf_size )
+    {
+        crumsort_prim(a, n, 9 /*uint64*/);
+        return;
+    }
+
+    uint64_t head[radix_buckets] = { 0 };
+    uint64_t tail[radix_buckets];
+    for(uint64_t i = 0; i < n; i += 1)
+        head[digit(a[i], shift)] += 1;
+    uint64_t sum = 0;
+    for(uint64_t b = 0; b < radix_buckets; b += 1)
+    {
+        const uint64_t c = head[b];
+        head[b] = sum;
+        sum    += c;
+        tail[b] = sum;
+    }
+
+    permute(a, head, tail, shift);
+
+    const int next = next_shift( shift );
+    if( next < 0 )
+        return;
+    for(uint64_t b = 0, start = 0; b < radix_buckets; start = tail[b], b += 1)
+        if( tail[b] - start > 1 )
+            flag_sort(a + start, tail[b] - start, next);
+}
+
+static uint64_t deduplicate(uint64_t* a, const uint64_t n)
+{
+    if( n == 0 )
+        return 0;
+    uint64_t o = 1;
+    for(uint64_t i = 1; i < n; i += 1)
+    {
+        if( a[i] != a[o - 1] )
+            a[o++] = a[i];
+    }
+    return o;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+//
+// Keys of bucket b that were not placed by the last round (one range per thread) : the
+// placed keys are swapped with them so that the bucket becomes [placed keys][left keys],
+// the start of the left keys is returned.
+//
+static uint64_t gather(uint64_t* a, const uint64_t first, const uint64_t last, const uint64_t* head, const int T)
+{
+    const uint64_t rem = last - first;
+    auto lo = [&](const int t) { return first + rem *  t      / T; };
+    auto hi = [&](const int t) { return first + rem * (t + 1) / T; };
+
+    uint64_t left = 0;
+    for(int t = 0; t < T; t += 1)
+        left += hi(t) - head[t * radix_buckets];
+    const uint64_t split = last - left;
+
+    //
+    // Left keys before split <=> placed keys after split, there are as many of each
+    //
+    int      ta = 0, tb = 0;
+    uint64_t pa = head[0];
+    uint64_t pb = std::max(lo(0), split);
+    while( true )
+    {
+        while( (ta < T) && (pa >= hi(ta)) )
+        {
+            ta += 1;
+            if( ta < T ) pa = head[ta * radix_buckets];
+        }
+        if( (ta == T) || (pa >= split) )
+            break;
+        while( (tb < T) && (pb >= head[tb * radix_buckets]) )
+        {
+            tb += 1;
+            if( tb < T ) pb = std::max(lo(tb), split);
+        }
+        std::swap(a[pa++], a[pb++]);
+    }
+    return split;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t radix_par(uint64_t* data, const uint64_t n, const int threads)
+{
+    if( n < 2 )
+        return n;
+
+    //
+    // Called from a parallel region (the Step 1 workers), the passes need the nested
+    // parallelism that the caller enables around its region, they run on one thread otherwise.
+    // The setting is process wide, it is not changed here while other threads may sort
+    //
+    const bool nested = (omp_get_active_level() == 0) || (omp_get_max_active_levels() > omp_get_active_level());
+
+    uint64_t all_and = UINT64_MAX;
+    uint64_t all_or  = 0;
+    const int n_threads = (nested == false) ? 1 : (int)std::max<uint64_t>(1, std::min<uint64_t>(threads, n / min_per_thread));
+#pragma omp parallel for num_threads(n_threads) reduction(&:all_and) reduction(|:all_or)
+    for(uint64_t i = 0; i < n; i += 1)
+    {
+        all_and &= data[i];
+        all_or  |= data[i];
+    }
+    const uint64_t varying = all_and ^ all_or;
+    if( varying == 0 )
+        return 1;
+
+    const int top  = std::max(0, 63 - __builtin_clzll(varying) - 7);
+    const int next = next_shift( top );
+
+    //
+    // On a single core the data dependent swaps of the in-place passes are slower than crumsort
+    //
+    if( n_threads == 1 )
+    {
+        crumsort_prim(data, n, 9 /*uint64*/);
+        return deduplicate(data, n);
+    }
+
+    std::vector<uint64_t> start   ( radix_buckets + 1 );
+    std::vector<uint64_t> first   ( radix_buckets     ); // first key not placed yet
+    std::vector<uint64_t> distinct( radix_buckets     );
+    std::vector<uint64_t> head    ( n_threads * radix_buckets );
+    std::vector<uint64_t> tail    ( n_threads * radix_buckets );
+    uint64_t left   = n;
+    int      rounds = 0;
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        const int T = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        uint64_t* my_head = head.data() + t * radix_buckets;
+        uint64_t* my_tail = tail.data() + t * radix_buckets;
+
+        std::fill(my_head, my_head + radix_buckets, 0);
+        for(uint64_t i = n * t / T; i < n * (t + 1) / T; i += 1)
+            my_head[digit(data[i], top)] += 1;
+#pragma omp barrier
+
+#pragma omp single
+        {
+            start[0] = 0;
+            for(uint64_t b = 0; b < radix_buckets; b += 1)
+            {
+                uint64_t c = 0;
+                for(int th = 0; th < T; th += 1)
+                    c += head[th * radix_buckets + b];
+                start[b + 1] = start[b] + c;
+                first[b]     = start[b];
+            }
+        }
+
+        //
+        // Parallel rounds while they place most of the keys left, the last ones are placed by
+        // a single thread
+        //
+        while( true )
+        {
+            for(uint64_t b = 0; b < radix_buckets; b += 1)
+            {
+                const uint64_t rem = start[b + 1] - first[b];
+                my_head[b] = first[b] + rem *  t      / T;
+                my_tail[b] = first[b] + rem * (t + 1) / T;
+            }
+            permute(data, my_head, my_tail, top);
+#pragma omp barrier
+
+#pragma omp for schedule(dynamic)
+            for(uint64_t b = 0; b < radix_buckets; b += 1)
+                first[b] = gather(data, first[b], start[b + 1], head.data() + b, T);
+
+#pragma omp single
+            {
+                const uint64_t before = left;
+                left = 0;
+                for(uint64_t b = 0; b < radix_buckets; b += 1)
+                    left += start[b + 1] - first[b];
+                rounds += 1;
+
+                const bool progress = (left * 2 <= before);
+                if( (left != 0) && ((progress == false) || (left < min_per_thread) || (rounds == 8)) )
+                {
+                    for(uint64_t b = 0; b < radix_buckets; b += 1)
+                        head[b] = first[b];
+                    permute(data, head.data(), start.data() + 1, top);
+                    left = 0;
+                }
+            }
+            if( left == 0 )
+                break;
+        }
+
+        //
+        // Buckets sorted and deduplicated independently
+        //
+#pragma omp for schedule(dynamic)
+        for(uint64_t b = 0; b < radix_buckets; b += 1)
+        {
+            const uint64_t length = start[b + 1] - start[b];
+            if( (next >= 0) && (length > 1) )
+                flag_sort(data + start[b], length, next);
+            distinct[b] = deduplicate(data + start[b], length);
+        }
+    }
+
+    uint64_t n_distinct = 0;
+    for(uint64_t b = 0; b < radix_buckets; b += 1)
+    {
+        memmove(data + n_distinct, data + start[b], distinct[b] * sizeof(uint64_t));
+        n_distinct += distinct[b];
+    }
+    return n_distinct;
+}
+
+void radix_par(std::vector<uint64_t>& data, const int threads)
+{
+    data.resize( radix_par(data.data(), data.size(), threads) );
+}
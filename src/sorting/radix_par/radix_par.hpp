@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//
+// Parallel in-place MSD radix sort of uint64 keys (8 bits per level), the duplicates are
+// removed by the last pass : the n keys become the sorted distinct keys, stored at the start
+// of the array, and their number is returned (the vector version resizes the vector).
+//
+// The first level is distributed by all the threads without a second buffer (PARADIS) :
+// every bucket is cut in one stripe per thread, each thread moves the keys of its stripes
+// to its stripes of their bucket, the keys that did not find a place are gathered at the
+// end of their buckets and the next round works on what is left. The buckets are then
+// sorted independently (American flag sort down to 64K keys, crumsort below) and
+// deduplicated while they are still in cache. Small inputs and single thread calls are
+// sorted by crumsort, faster than the in-place passes on one core.
+//
+// The highest level only covers the bits that differ between the keys, which fits the
+// uniformly distributed minimizer hashes as well as small keys.
+//
+extern uint64_t radix_par(uint64_t* data, const uint64_t n, const int threads);
+extern void     radix_par(std::vector<uint64_t>& data, const int threads);
@@ -0,0 +1,21 @@
+#include "std_parallel.hpp"
+
+#include <algorithm>
+#include <execution>
+#include <memory>
+
+#if defined(_PSTL_PAR_BACKEND_TBB)
+#include <tbb/global_control.h>
+#endif
+
+void std_parallel(std::vector<uint64_t>& test, const int threads)
+{
+#if defined(_PSTL_PAR_BACKEND_TBB)
+    std::unique_ptr<tbb::global_control> limit;
+    if( threads > 0 )
+        limit.reset( new tbb::global_control(tbb::global_control::max_allowed_parallelism, threads) );
+#else
+    (void)threads;
+#endif
+    std::sort(std::execution::par_unseq, test.begin(), test.end());
+}
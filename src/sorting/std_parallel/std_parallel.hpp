@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//
+// std::sort with the parallel execution policy (par_unseq). With libstdc++ the parallel
+// backend is TBB when its headers are found at compile time (the program is then linked to
+// TBB), the sort is sequential otherwise. threads caps the TBB workers (0 : TBB default).
+//
+extern void std_parallel(std::vector<uint64_t>& test, const int threads = 0);
@@ -0,0 +1,253 @@
+#include "CJournal.hpp"
+#include "../colors.hpp"
+#include "../../hash/MurmurHash3.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+CJournal::CJournal()
+{
+
+}
+
+CJournal::~CJournal()
+{
+    close();
+}
+
+void CJournal::close()
+{
+    if( file != nullptr )
+        fclose( file );
+    file = nullptr;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t CJournal::signature(const std::string& filen, uint64_t* bytes)
+{
+    const uint64_t sample = 64 * 1024;
+
+    FILE* f = fopen(filen.c_str(), "rb");
+    if( f == NULL )
+        return 0;
+    fseek(f, 0, SEEK_END);
+    const uint64_t size = ftell(f);
+
+    std::vector<char> data( 2 * sample + sizeof(uint64_t) );
+    memcpy(data.data(), &size, sizeof(uint64_t));
+    uint64_t n = sizeof(uint64_t);
+
+    fseek(f, 0, SEEK_SET);
+    n += fread(data.data() + n, 1, std::min(size, sample), f);
+    if( size > sample )
+    {
+        const uint64_t tail = std::min(size - sample, sample);
+        fseek(f, size - tail, SEEK_SET);
+        n += fread(data.data() + n, 1, tail, f);
+    }
+    fclose( f );
+
+    uint64_t h[2];
+    MurmurHash3_x64_128(data.data(), n, 0x42, h);
+    if( bytes != nullptr )
+        *bytes = size;
+    return h[0] | 1; // 0 is kept for the missing files
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void CJournal::open(const std::string& filen, const std::string& run, const bool resume, const int verbose)
+{
+    close();
+    records .clear();
+    consumed.clear();
+
+    std::ifstream in( filen );
+    if( (resume == true) && (in.is_open() == false) )
+    {
+        warning_section();
+        printf("(WW) No journal to resume from (%s), starting from scratch\n", filen.c_str());
+        reset_section();
+    }
+
+    if( (resume == true) && (in.is_open() == true) )
+    {
+        std::string line;
+        std::getline(in, line);
+        if( line != "run\t" + run )
+        {
+            error_section();
+            printf("(EE) The journal (%s) belongs to another run (different parameters or input files)\n", filen.c_str());
+            printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+            reset_section();
+            exit( EXIT_FAILURE );
+        }
+
+        //
+        // A record cut by the interruption fails to parse : it is ignored
+        //
+        while( std::getline(in, line) )
+        {
+            std::istringstream ss( line );
+            record   r;
+            uint64_t n = 0;
+            bool     ok = (bool)std::getline(ss, r.step, '\t');
+            std::string field;
+            auto next = [&]() { return (bool)std::getline(ss, field, '\t'); };
+
+            ok = ok && next();
+            n  = ok ? std::strtoull(field.c_str(), nullptr, 10) : 0;
+            for(uint64_t i = 0; ok && (i < n); i += 1)
+            {
+                ok = ok && next(); if( ok ) r.outputs   .push_back( field );
+                ok = ok && next(); if( ok ) r.bytes     .push_back( std::strtoull(field.c_str(), nullptr, 10) );
+                ok = ok && next(); if( ok ) r.signatures.push_back( std::strtoull(field.c_str(), nullptr, 16) );
+            }
+            ok = ok && next();
+            n  = ok ? std::strtoull(field.c_str(), nullptr, 10) : 0;
+            for(uint64_t i = 0; ok && (i < n); i += 1)
+            {
+                ok = ok && next(); if( ok ) r.values.push_back( std::strtoull(field.c_str(), nullptr, 10) );
+            }
+            ok = ok && next();
+            n  = ok ? std::strtoull(field.c_str(), nullptr, 10) : 0;
+            for(uint64_t i = 0; ok && (i < n); i += 1)
+            {
+                ok = ok && next(); if( ok ) r.inputs.push_back( field );
+            }
+            ok = ok && next() && (field == "end");
+            if( ok == false )
+                continue;
+
+            for(const std::string& i : r.inputs)
+                consumed.insert( i );
+            records.push_back( r );
+        }
+        in.close();
+
+        file = fopen(filen.c_str(), "a");
+        if (verbose >= 1){
+            printf("[I] Resuming from %s (%zu completed steps)\n", filen.c_str(), records.size());
+        }
+    }
+    else
+    {
+        file = fopen(filen.c_str(), "w");
+        if( file != nullptr )
+            fprintf(file, "run\t%s\n", run.c_str());
+    }
+
+    if( file == nullptr )
+    {
+        error_section();
+        printf("(EE) Cannot open the journal file (%s)\n", filen.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+    fflush( file );
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+const CJournal::record* CJournal::find(const std::string& step, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs) const
+{
+    //
+    // The last matching record wins, a step redone after a resume is recorded again
+    //
+    for(auto r = records.rbegin(); r != records.rend(); ++r)
+        if( (r->step == step) && (r->inputs == inputs) && (r->outputs == outputs) )
+            return &(*r);
+    return nullptr;
+}
+
+bool CJournal::done(const std::string& step, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs,
+                    std::vector<uint64_t>* values)
+{
+    std::lock_guard<std::mutex> guard( lock );
+
+    const record* r = find(step, inputs, outputs);
+    bool valid = (r != nullptr);
+    for(size_t i = 0; valid && (i < r->outputs.size()); i += 1)
+    {
+        if( consumed.count(r->outputs[i]) != 0 )
+            continue;
+        uint64_t bytes = 0;
+        valid = (signature(r->outputs[i], &bytes) == r->signatures[i]) && (bytes == r->bytes[i]);
+    }
+
+    if( valid == false )
+    {
+        //
+        // The step has to be redone, its inputs were deleted once consumed by a recorded step
+        //
+        for(const std::string& i : inputs)
+        {
+            if( (consumed.count(i) != 0) && (signature(i) == 0) )
+            {
+                error_section();
+                printf("(EE) The step %s has to be redone but its input file (%s) was deleted\n", step.c_str(), i.c_str());
+                printf("(EE) The run cannot be resumed, restart it without --resume\n");
+                printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+                reset_section();
+                exit( EXIT_FAILURE );
+            }
+        }
+        return false;
+    }
+
+    if( values != nullptr )
+        *values = r->values;
+    n_reused += 1;
+    return true;
+}
+
+void CJournal::commit(const std::string& step, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs,
+                      const std::vector<uint64_t>& values)
+{
+    std::ostringstream line;
+    line << step << '\t' << outputs.size();
+    for(const std::string& o : outputs)
+    {
+        uint64_t bytes = 0;
+        const uint64_t sig = signature(o, &bytes);
+        line << '\t' << o << '\t' << bytes << '\t' << std::hex << sig << std::dec;
+    }
+    line << '\t' << values.size();
+    for(const uint64_t v : values)
+        line << '\t' << v;
+    line << '\t' << inputs.size();
+    for(const std::string& i : inputs)
+        line << '\t' << i;
+    line << "\tend\n";
+
+    std::lock_guard<std::mutex> guard( lock );
+    if( file == nullptr )
+        return;
+    fputs(line.str().c_str(), file);
+    fflush( file );
+    fsync ( fileno(file) );
+}
@@ -0,0 +1,69 @@
+#ifndef _CJournal_
+#define _CJournal_
+
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+//
+// Journal of the completed steps of a run, kept in the tmp directory so that an interrupted
+// run can be resumed. A record is appended (and synced) once a node of the pipeline has
+// written all its outputs, before its inputs are deleted :
+//
+//   <step> <n outputs> (<file> <bytes> <signature>)... <n values> <value>... <n inputs> <input>...
+//
+// The signature is a hash of the size, the first and the last 64 KB of the file : it detects
+// truncated or rewritten files without reading them entirely. The first line identifies the
+// run (parameters and input files), a journal of another run is not reused.
+//
+class CJournal
+{
+public:
+    struct record
+    {
+        std::string              step;
+        std::vector<std::string> outputs;
+        std::vector<uint64_t>    bytes;
+        std::vector<uint64_t>    signatures;
+        std::vector<uint64_t>    values;
+        std::vector<std::string> inputs;
+    };
+
+private:
+    FILE*                 file = nullptr;
+    std::vector<record>   records;
+    std::set<std::string> consumed; // inputs of the recorded steps
+    std::mutex            lock;
+    uint64_t              n_reused = 0;
+
+    const record* find(const std::string& step, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs) const;
+
+public:
+     CJournal();
+    ~CJournal();
+
+    //
+    // Starts a new journal, or reloads the one of the same run when resume is set
+    //
+    void open(const std::string& filen, const std::string& run, const bool resume, const int verbose);
+    void close();
+
+    //
+    // True when the step was recorded and its outputs are still valid, or were consumed by a
+    // later recorded step. values receives the values of the record.
+    //
+    bool done  (const std::string& step, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs,
+                std::vector<uint64_t>* values = nullptr);
+
+    void commit(const std::string& step, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs,
+                const std::vector<uint64_t>& values = {});
+
+    uint64_t reused() const { return n_reused; }
+
+    static uint64_t signature(const std::string& filen, uint64_t* bytes = nullptr);
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "CMemoryBudget.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+static std::mutex              budget_lock;
+static std::condition_variable freed;
+
+static uint64_t budget_limit = 0;
+static uint64_t budget_grain = 0;
+static uint64_t budget_used  = 0;
+static uint64_t budget_peak  = 0;
+
+//
+// Part of a request that can be granted now (lock held), 0 if min_bytes are not free
+//
+static uint64_t grantable(const uint64_t min_bytes, const uint64_t max_bytes)
+{
+    if( budget_limit == 0 )
+        return max_bytes;
+    const uint64_t free_bytes = (budget_used < budget_limit) ? (budget_limit - budget_used) : 0;
+    if( free_bytes >= min_bytes )
+        return std::min(max_bytes, free_bytes);
+    if( budget_used == 0 )
+        return min_bytes; // larger than the whole budget, granted when alone
+    return 0;
+}
+
+static void take(const uint64_t bytes)
+{
+    budget_used += bytes;
+    budget_peak  = std::max(budget_peak, budget_used);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void CMemoryBudget::set_limit(const uint64_t limit, const uint64_t grain)
+{
+    std::lock_guard<std::mutex> guard( budget_lock );
+    budget_limit = limit;
+    budget_grain = (limit == 0) ? 0 : std::min(std::max<uint64_t>(grain, 1), limit);
+    budget_peak  = budget_used;
+    freed.notify_all();
+}
+
+uint64_t CMemoryBudget::limit ()  { std::lock_guard<std::mutex> guard( budget_lock ); return budget_limit; }
+uint64_t CMemoryBudget::grain ()  { std::lock_guard<std::mutex> guard( budget_lock ); return budget_grain; }
+uint64_t CMemoryBudget::in_use()  { std::lock_guard<std::mutex> guard( budget_lock ); return budget_used;  }
+uint64_t CMemoryBudget::peak  ()  { std::lock_guard<std::mutex> guard( budget_lock ); return budget_peak;  }
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+uint64_t CMemoryBudget::acquire(const uint64_t min_bytes, const uint64_t max_bytes)
+{
+    const uint64_t min_b = std::min(min_bytes, max_bytes);
+    std::unique_lock<std::mutex> guard( budget_lock );
+    uint64_t granted;
+    while( (granted = grantable(min_b, max_bytes)) == 0 && (min_b != 0) )
+        freed.wait( guard );
+    take( granted );
+    return granted;
+}
+
+uint64_t CMemoryBudget::try_acquire(const uint64_t min_bytes, const uint64_t max_bytes)
+{
+    const uint64_t min_b = std::min(min_bytes, max_bytes);
+    std::lock_guard<std::mutex> guard( budget_lock );
+    const uint64_t granted = grantable(min_b, max_bytes);
+    take( granted );
+    return granted;
+}
+
+void CMemoryBudget::release(const uint64_t bytes)
+{
+    if( bytes == 0 )
+        return;
+    std::lock_guard<std::mutex> guard( budget_lock );
+    budget_used -= std::min(bytes, budget_used);
+    freed.notify_all();
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+CMemoryBudget::lease::lease(const uint64_t min_bytes, const uint64_t max_bytes)
+{
+    held = CMemoryBudget::acquire(min_bytes, max_bytes);
+}
+
+CMemoryBudget::lease::~lease()
+{
+    CMemoryBudget::release( held );
+}
+
+uint64_t CMemoryBudget::lease::grow(const uint64_t min_bytes, const uint64_t max_bytes)
+{
+    const uint64_t added = CMemoryBudget::try_acquire(min_bytes, max_bytes);
+    held += added;
+    return added;
+}
+
+void CMemoryBudget::lease::release(const uint64_t bytes)
+{
+    const uint64_t given = std::min(bytes, held);
+    held -= given;
+    CMemoryBudget::release( given );
+}
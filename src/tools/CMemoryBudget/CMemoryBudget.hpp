@@ -0,0 +1,69 @@
+#ifndef _CMemoryBudget_
+#define _CMemoryBudget_
+
+#include <cstdint>
+
+//
+// Memory budget of the process (the -M option) shared by the workers of the pipeline. Each
+// worker leases the memory of its buffers and gives it back once done : the budget left by
+// the small samples of Step 1 goes to the large ones instead of a fixed ram / threads share,
+// and a worker only spills when the whole budget is in use.
+//
+// Without a limit (the default, when the functions are used outside generate_minimizers)
+// every request is granted its maximum.
+//
+class CMemoryBudget
+{
+public:
+    //
+    // Scoped lease, what is held is given back when it goes out of scope
+    //
+    class lease
+    {
+    private:
+        uint64_t held = 0;
+
+    public:
+        //
+        // Waits until min_bytes are free and takes up to max_bytes
+        //
+         lease(const uint64_t min_bytes, const uint64_t max_bytes);
+        ~lease();
+
+        lease(const lease&)            = delete;
+        lease& operator=(const lease&) = delete;
+
+        uint64_t bytes() const { return held; }
+
+        //
+        // Adds between min_bytes and max_bytes without waiting, returns the added bytes (0
+        // when the budget is under pressure)
+        //
+        uint64_t grow(const uint64_t min_bytes, const uint64_t max_bytes);
+
+        //
+        // Gives back a part of the lease
+        //
+        void release(const uint64_t bytes);
+    };
+
+    //
+    // limit : budget in bytes (0 : no limit), grain : smallest lease worth growing a buffer
+    //
+    static void set_limit(const uint64_t limit, const uint64_t grain);
+
+    static uint64_t limit ();
+    static uint64_t grain ();
+    static uint64_t in_use();
+    static uint64_t peak  ();  // largest amount leased since set_limit
+
+    //
+    // Raw interface of the leases. acquire waits until min_bytes are free, or until nothing
+    // is leased when min_bytes exceeds the limit, try_acquire returns 0 instead of waiting.
+    //
+    static uint64_t acquire    (const uint64_t min_bytes, const uint64_t max_bytes);
+    static uint64_t try_acquire(const uint64_t min_bytes, const uint64_t max_bytes);
+    static void     release    (const uint64_t bytes);
+};
+
+#endif
@@ -0,0 +1,342 @@
+#include "CMetrics.hpp"
+#include "../colors.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+
+std::atomic<bool> CMetrics::active( false );
+
+static std::mutex                                          registry_lock;
+static std::vector<std::unique_ptr<CMetrics::thread_slot>> registry;
+static std::vector<CMetrics::stage_record>                 done_stages;
+static CMetrics::stage_record                              current;
+static bool                                                in_stage = false;
+
+static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+static const char* metric_names[N_METRICS] = {
+    "bases", "mmers", "minimizers",
+    "read_bytes", "read_disk_bytes", "write_bytes", "write_disk_bytes",
+    "read_ns", "write_ns", "stall_ns",
+    "merge_nodes", "merge_inputs"
+};
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+const char* CMetrics::name(const int id)
+{
+    return metric_names[id];
+}
+
+uint64_t CMetrics::now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+uint64_t CMetrics::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void CMetrics::enable(const bool on)
+{
+    active.store(on, std::memory_order_relaxed);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+CMetrics::thread_slot* CMetrics::register_thread()
+{
+    std::lock_guard<std::mutex> guard( registry_lock );
+    registry.emplace_back( new thread_slot );
+    thread_slot* slot = registry.back().get();
+    for(int i = 0; i < N_METRICS; i += 1)
+        slot->counters[i].store(0, std::memory_order_relaxed);
+    slot->id = registry.size() - 1;
+    return slot;
+}
+
+std::vector<uint64_t> CMetrics::totals()
+{
+    std::lock_guard<std::mutex> guard( registry_lock );
+    std::vector<uint64_t> sum( N_METRICS, 0 );
+    for(const auto& slot : registry)
+        for(int i = 0; i < N_METRICS; i += 1)
+            sum[i] += slot->counters[i].load(std::memory_order_relaxed);
+    return sum;
+}
+
+std::vector<CMetrics::stage_record> CMetrics::stages()
+{
+    return done_stages;
+}
+
+void CMetrics::reset()
+{
+    std::lock_guard<std::mutex> guard( registry_lock );
+    for(const auto& slot : registry)
+    {
+        for(int i = 0; i < N_METRICS; i += 1)
+            slot->counters[i].store(0, std::memory_order_relaxed);
+        slot->spans.clear();
+    }
+    done_stages.clear();
+    in_stage = false;
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void CMetrics::stage(const std::string& name)
+{
+    const std::vector<uint64_t> sum = totals();
+    const uint64_t              t   = now_us();
+
+    if( in_stage == true )
+    {
+        current.duration_us = t - current.start_us;
+        for(int i = 0; i < N_METRICS; i += 1)
+            current.counters[i] = sum[i] - current.counters[i];
+        done_stages.push_back( current );
+        in_stage = false;
+    }
+
+    if( name.empty() == false )
+    {
+        current.name     = name;
+        current.start_us = t;
+        for(int i = 0; i < N_METRICS; i += 1)
+            current.counters[i] = sum[i]; // totals at the start, turned into deltas at the end
+        in_stage = true;
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+CMetrics::span::span(const std::string& _name, const uint64_t _fan_in)
+{
+    active = CMetrics::enabled();
+    if( active == false )
+        return;
+    thread_slot* slot = CMetrics::local();
+    name     = _name;
+    fan_in   = _fan_in;
+    start_us = CMetrics::now_us();
+    read_0   = slot->counters[MET_READ_BYTES ].load(std::memory_order_relaxed);
+    write_0  = slot->counters[MET_WRITE_BYTES].load(std::memory_order_relaxed);
+}
+
+CMetrics::span::~span()
+{
+    if( active == false )
+        return;
+    thread_slot* slot = CMetrics::local();
+    span_record r;
+    r.name        = name;
+    r.stage       = in_stage ? current.name : "";
+    r.thread      = slot->id;
+    r.start_us    = start_us;
+    r.duration_us = CMetrics::now_us() - start_us;
+    r.fan_in      = fan_in;
+    r.bytes_in    = slot->counters[MET_READ_BYTES ].load(std::memory_order_relaxed) - read_0;
+    r.bytes_out   = slot->counters[MET_WRITE_BYTES].load(std::memory_order_relaxed) - write_0;
+    slot->spans.push_back( r );
+    if( fan_in != 0 )
+    {
+        CMetrics::add(MET_MERGE_NODES,  1);
+        CMetrics::add(MET_MERGE_INPUTS, fan_in);
+    }
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+static std::string json_string(const std::string& s)
+{
+    std::string r = "\"";
+    for(const char c : s)
+    {
+        if     ( c == '"'  ) r += "\\\"";
+        else if( c == '\\' ) r += "\\\\";
+        else if( (unsigned char)c < 0x20 ) r += ' ';
+        else                 r += c;
+    }
+    return r + "\"";
+}
+
+static FILE* open_output(const std::string& filen)
+{
+    FILE* f = fopen(filen.c_str(), "w");
+    if( f == NULL )
+    {
+        error_section();
+        printf("(EE) Cannot create the metrics file (%s)\n", filen.c_str());
+        printf("(EE) Error location : %s %d\n", __FILE__, __LINE__);
+        reset_section();
+        exit( EXIT_FAILURE );
+    }
+    return f;
+}
+
+static void json_counters(FILE* f, const uint64_t* counters)
+{
+    fprintf(f, "{");
+    for(int i = 0; i < N_METRICS; i += 1)
+        fprintf(f, "%s\"%s\": %lu", (i == 0) ? "" : ", ", metric_names[i], counters[i]);
+    fprintf(f, "}");
+}
+
+static double mb_per_s(const uint64_t bytes, const uint64_t us)
+{
+    return (us == 0) ? 0.0 : ((double)bytes / (1024.0 * 1024.0)) / ((double)us / 1e6);
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void CMetrics::write(const std::string& filen)
+{
+    stage( "" );
+
+    const std::vector<uint64_t> sum = totals();
+    uint64_t wall_us = 0;
+    for(const stage_record& s : done_stages)
+        wall_us += s.duration_us;
+
+    std::lock_guard<std::mutex> guard( registry_lock );
+    FILE* f = open_output( filen );
+
+    const bool csv = (filen.size() >= 4) && (filen.substr(filen.size() - 4) == ".csv");
+    if( csv == true )
+    {
+        fprintf(f, "scope,name,seconds");
+        for(int i = 0; i < N_METRICS; i += 1)
+            fprintf(f, ",%s", metric_names[i]);
+        fprintf(f, "\n");
+
+        for(const stage_record& s : done_stages)
+        {
+            fprintf(f, "stage,%s,%.6f", s.name.c_str(), s.duration_us / 1e6);
+            for(int i = 0; i < N_METRICS; i += 1)
+                fprintf(f, ",%lu", s.counters[i]);
+            fprintf(f, "\n");
+        }
+
+        fprintf(f, "total,all,%.6f", wall_us / 1e6);
+        for(int i = 0; i < N_METRICS; i += 1)
+            fprintf(f, ",%lu", sum[i]);
+        fprintf(f, "\n");
+
+        for(const auto& slot : registry)
+        {
+            fprintf(f, "thread,%u,", slot->id);
+            for(int i = 0; i < N_METRICS; i += 1)
+                fprintf(f, ",%lu", slot->counters[i].load(std::memory_order_relaxed));
+            fprintf(f, "\n");
+        }
+        fclose( f );
+        return;
+    }
+
+    fprintf(f, "{\n  \"seconds\": %.6f,\n  \"totals\": ", wall_us / 1e6);
+    json_counters(f, sum.data());
+
+    fprintf(f, ",\n  \"stages\": [");
+    for(size_t s = 0; s < done_stages.size(); s += 1)
+    {
+        const stage_record& r = done_stages[s];
+        const double fan_in   = (r.counters[MET_MERGE_NODES] == 0) ? 0.0 : (double)r.counters[MET_MERGE_INPUTS] / r.counters[MET_MERGE_NODES];
+        fprintf(f, "%s\n    {\"name\": %s, \"seconds\": %.6f, ", (s == 0) ? "" : ",", json_string(r.name).c_str(), r.duration_us / 1e6);
+        fprintf(f, "\"read_MB_s\": %.2f, \"write_MB_s\": %.2f, \"read_disk_MB_s\": %.2f, \"write_disk_MB_s\": %.2f, \"mean_fan_in\": %.2f, \"counters\": ",
+                mb_per_s(r.counters[MET_READ_BYTES],      r.duration_us), mb_per_s(r.counters[MET_WRITE_BYTES],      r.duration_us),
+                mb_per_s(r.counters[MET_READ_DISK_BYTES], r.duration_us), mb_per_s(r.counters[MET_WRITE_DISK_BYTES], r.duration_us),
+                fan_in);
+        json_counters(f, r.counters);
+        fprintf(f, "}");
+    }
+
+    fprintf(f, "\n  ],\n  \"threads\": [");
+    for(size_t t = 0; t < registry.size(); t += 1)
+    {
+        uint64_t counters[N_METRICS];
+        for(int i = 0; i < N_METRICS; i += 1)
+            counters[i] = registry[t]->counters[i].load(std::memory_order_relaxed);
+        fprintf(f, "%s\n    {\"id\": %u, \"spans\": %zu, \"counters\": ", (t == 0) ? "" : ",", registry[t]->id, registry[t]->spans.size());
+        json_counters(f, counters);
+        fprintf(f, "}");
+    }
+
+    fprintf(f, "\n  ],\n  \"spans\": [");
+    bool first = true;
+    for(const auto& slot : registry)
+    {
+        for(const span_record& r : slot->spans)
+        {
+            fprintf(f, "%s\n    {\"name\": %s, \"stage\": %s, \"thread\": %u, \"start_us\": %lu, \"duration_us\": %lu, \"fan_in\": %lu, \"bytes_in\": %lu, \"bytes_out\": %lu}",
+                    first ? "" : ",", json_string(r.name).c_str(), json_string(r.stage).c_str(), r.thread,
+                    r.start_us, r.duration_us, r.fan_in, r.bytes_in, r.bytes_out);
+            first = false;
+        }
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose( f );
+}
+//
+//
+//
+////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//
+//
+void CMetrics::write_trace(const std::string& filen)
+{
+    stage( "" );
+
+    std::lock_guard<std::mutex> guard( registry_lock );
+    FILE* f = open_output( filen );
+
+    //
+    // tid 0 holds the stages, the threads follow
+    //
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(f, "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"stages\"}}");
+    for(const auto& slot : registry)
+        fprintf(f, ",\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"thread %u\"}}", slot->id + 1, slot->id);
+
+    for(const stage_record& s : done_stages)
+        fprintf(f, ",\n  {\"name\": %s, \"cat\": \"stage\", \"ph\": \"X\", \"pid\": 1, \"tid\": 0, \"ts\": %lu, \"dur\": %lu}",
+                json_string(s.name).c_str(), s.start_us, s.duration_us);
+
+    for(const auto& slot : registry)
+    {
+        for(const span_record& r : slot->spans)
+            fprintf(f, ",\n  {\"name\": %s, \"cat\": %s, \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %lu, \"dur\": %lu, \"args\": {\"fan_in\": %lu, \"bytes_in\": %lu, \"bytes_out\": %lu}}",
+                    json_string(r.name).c_str(), json_string(r.stage).c_str(), r.thread + 1, r.start_us, r.duration_us,
+                    r.fan_in, r.bytes_in, r.bytes_out);
+    }
+    fprintf(f, "\n]}\n");
+    fclose( f );
+}
@@ -0,0 +1,137 @@
+#ifndef _CMetrics_
+#define _CMetrics_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// Counters of the hot paths, kept per thread (each thread only writes its own slot, no lock
+// nor atomic read-modify-write), and spans of the pipeline nodes. The run is cut in stages
+// (Step 1, 2.1, ...) : the counters of a stage are the difference of the totals at its bounds.
+//
+// Everything is disabled by default, the counters are then still incremented (a thread local
+// add per buffer or per file) but the spans and the I/O metering are not recorded.
+//
+enum metric_id
+{
+    MET_BASES = 0,          // nucleotides delivered by the sequence parsers
+    MET_MMERS,              // m-mers hashed
+    MET_MINIMIZERS,         // minimizers emitted by the sliding window (before deduplication)
+    MET_READ_BYTES,         // bytes returned by the stream readers (decompressed)
+    MET_READ_DISK_BYTES,    // bytes of the files opened for reading (compressed)
+    MET_WRITE_BYTES,        // bytes given to the stream writers (before compression)
+    MET_WRITE_DISK_BYTES,   // bytes of the files written (compressed)
+    MET_READ_NS,            // time spent in the stream reads (decoding and I/O)
+    MET_WRITE_NS,           // time spent in the stream writes (encoding and I/O)
+    MET_STALL_NS,           // time a merge waited for its read-ahead blocks
+    MET_MERGE_NODES,        // merge nodes executed
+    MET_MERGE_INPUTS,       // sum of the fan-in of the merge nodes
+    N_METRICS
+};
+
+class CMetrics
+{
+public:
+    struct span_record
+    {
+        std::string name;
+        std::string stage;
+        uint32_t    thread;
+        uint64_t    start_us;
+        uint64_t    duration_us;
+        uint64_t    fan_in;
+        uint64_t    bytes_in;   // read by the thread of the span (decompressed)
+        uint64_t    bytes_out;  // written by the thread of the span (before compression)
+    };
+
+    struct thread_slot
+    {
+        std::atomic<uint64_t>    counters[N_METRICS];
+        std::vector<span_record> spans;
+        uint32_t                 id;
+    };
+
+    //
+    // Scoped span of a pipeline node, recorded when it goes out of scope
+    //
+    class span
+    {
+    private:
+        std::string name;
+        uint64_t    fan_in;
+        uint64_t    start_us;
+        uint64_t    read_0;
+        uint64_t    write_0;
+        bool        active;
+
+    public:
+         span(const std::string& name, const uint64_t fan_in = 0);
+        ~span();
+    };
+
+    struct stage_record
+    {
+        std::string name;
+        uint64_t    start_us;
+        uint64_t    duration_us;
+        uint64_t    counters[N_METRICS];
+    };
+
+private:
+    static std::atomic<bool> active;
+
+    static thread_slot* register_thread();
+
+public:
+    static void enable (const bool on);
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+    static thread_slot* local()
+    {
+        static thread_local thread_slot* slot = nullptr;
+        if( slot == nullptr )
+            slot = register_thread();
+        return slot;
+    }
+
+    static void add(const metric_id id, const uint64_t value)
+    {
+        std::atomic<uint64_t>& c = local()->counters[id];
+        c.store(c.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static uint64_t now_us();
+    static uint64_t now_ns();
+
+    //
+    // Ends the current stage and starts a new one (an empty name only ends the current one).
+    // Must be called when no worker is running.
+    //
+    static void stage(const std::string& name);
+
+    static std::vector<uint64_t>     totals();
+    static std::vector<stage_record> stages();
+
+    //
+    // Clears the counters, spans and stages (between two benchmark runs, no worker running)
+    //
+    static void reset();
+
+    //
+    // Stages, per thread counters and spans. The format comes from the extension : .csv
+    // (one line per stage and per thread) or JSON otherwise
+    //
+    static void write(const std::string& filen);
+
+    //
+    // Spans in the Chrome trace event format (chrome://tracing, Perfetto)
+    //
+    static void write_trace(const std::string& filen);
+
+    static const char* name(const int id);
+};
+
+#endif
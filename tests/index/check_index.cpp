@@ -0,0 +1,106 @@
+//
+// Lookups of the index (--index) and of the minimal perfect hash (--mphf) of a run against a
+// scan of its tier files :
+//
+//  - every row of the tier files is found in both, with the colors of the row
+//  - both hold as many keys as the tier files
+//  - minimizers that are not in the tier files are not found by the index, and the mphf
+//    fingerprints reject most of them
+//
+// Usage : check_index <output>.<N>c.manifest <output>.<N>c.index <output>.<N>c.mphf
+//
+#include "index/minimizer_index.hpp"
+#include "index/minimizer_mphf.hpp"
+#include "index/tier_stream.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static int failure(const std::string& message)
+{
+    printf("(EE) %s\n", message.c_str());
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+    if( argc != 4 )
+    {
+        printf("Usage : %s <manifest> <index> <mphf>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    //
+    // Tier files of the manifest : "<tier> <min colors> <max colors> <rows> <file>"
+    //
+    std::vector<std::string> files( N_TIERS );
+    std::ifstream manifest( argv[1] );
+    if( !manifest )
+        return failure(std::string("cannot open the manifest ") + argv[1]);
+    std::string   line;
+    while( std::getline(manifest, line) )
+    {
+        std::istringstream fields( line );
+        std::string name, low, high, rows, file;
+        if( (line.empty() == true) || (line[0] == '#') || !(fields >> name >> low >> high >> rows >> file) )
+            continue;
+        for(int t = 0; t < N_TIERS; t += 1)
+            if( (name == tier_name(t)) && (file != "-") )
+                files[t] = file;
+    }
+
+    minimizer_index index( argv[2] );
+    minimizer_mphf  mphf ( argv[3] );
+    const tier_policy& policy = index.tiers();
+
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> expected, colors;
+    for(int t = 0; t < N_TIERS; t += 1)
+    {
+        if( files[t].empty() == true )
+            continue;
+        for(tier_stream stream(files[t], t, policy); stream.valid == true; stream.next())
+        {
+            const uint64_t minimizer = stream.minimizer();
+            policy.decode(t, stream.payload(), expected);
+            keys.push_back( minimizer );
+
+            if( (index.lookup(minimizer, colors) == false) || (colors != expected) )
+                return failure("index lookup of " + std::to_string(minimizer) + " (" + tier_name(t) + ")");
+            if( (mphf.lookup(minimizer, colors) == false) || (colors != expected) )
+                return failure("mphf lookup of " + std::to_string(minimizer) + " (" + tier_name(t) + ")");
+        }
+    }
+
+    if( (index.rows() != keys.size()) || (mphf.keys() != keys.size()) )
+        return failure("the tier files hold " + std::to_string(keys.size()) + " rows, the index " +
+                       std::to_string(index.rows()) + " and the mphf " + std::to_string(mphf.keys()));
+
+    //
+    // Neighbours of the keys that are not keys : the index has no row for them, a few pass the
+    // mphf fingerprints (2^-fp_bits of them)
+    //
+    std::sort(keys.begin(), keys.end());
+    uint64_t n_absent = 0;
+    uint64_t n_passed = 0;
+    for(const uint64_t key : keys)
+    {
+        const uint64_t absent = key + 1;
+        if( (absent == 0) || std::binary_search(keys.begin(), keys.end(), absent) )
+            continue;
+        if( index.lookup(absent, colors) == true )
+            return failure("index lookup of the absent minimizer " + std::to_string(absent));
+        n_absent += 1;
+        n_passed += (mphf.lookup(absent, colors) == true) ? 1 : 0;
+    }
+    if( 20 * n_passed > n_absent )
+        return failure("the mphf accepts " + std::to_string(n_passed) + " of " + std::to_string(n_absent) + " absent minimizers");
+
+    printf("index / mphf : %lu rows OK, %lu / %lu absent minimizers accepted by the mphf\n", keys.size(), n_passed, n_absent);
+    return EXIT_SUCCESS;
+}
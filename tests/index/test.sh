@@ -0,0 +1,59 @@
+#!/bin/bash
+#
+# Round trips of the vbyte rows and of the --index / --mphf outputs, to run from the build
+# directory (as the merger tests) once BreiZHMinimizer and its library are built :
+#
+#   ../tests/index/test.sh
+#
+set -e
+TESTS=../tests/index
+
+#
+# The checkers are compiled as the library they link against : the options of the build
+# are read back from its CMakeCache.txt
+#
+option() { grep -q "^$1:BOOL=ON" CMakeCache.txt; }
+CXX=$(sed -n 's/^CMAKE_CXX_COMPILER:FILEPATH=//p' CMakeCache.txt)
+FLAGS="-std=c++17 -O2 -fopenmp -I../src"
+LIBS="./libBreiZHMinimizerLib.a -lz -lbz2"
+if option BUILD_LINUX_INTEL || option BUILD_MACOS_INTEL; then FLAGS="$FLAGS -march=native"; fi
+if option BUILD_LINUX_ARM   || option BUILD_MACOS_ARM;   then FLAGS="$FLAGS -mcpu=native";  fi
+if option ENABLE_IO_URING && (option BUILD_LINUX_INTEL || option BUILD_LINUX_ARM); then FLAGS="$FLAGS -D_IO_URING_"; fi
+if option ENABLE_LTO; then FLAGS="$FLAGS -flto"; fi
+if grep -q "^TBB_DIR:PATH=/" CMakeCache.txt; then LIBS="$LIBS -ltbb"; fi
+
+${CXX:-g++} $FLAGS $TESTS/check_vbyte.cpp -o check_vbyte $LIBS
+
+./check_vbyte
+
+${CXX:-g++} $FLAGS $TESTS/check_index.cpp -o check_index $LIBS
+
+#
+# 80 samples : a part shared by all of them, parts shared by groups of samples and a part of
+# their own, so that the rows spread over the tiers. More samples than a group of Step 2 (64)
+# for Step 2.2 to merge several files, and 40 of them for the run where Step 2.1 leaves a
+# single file
+#
+rm -rf index_test && mkdir -p index_test/samples index_test/small index_test/tmp
+awk 'function seq(n,   s, i) { s = ""; for(i = 0; i < n; i++) s = s substr("ACGT", int(rand() * 4) + 1, 1); return s }
+     BEGIN {
+         srand(42); core = seq(2000); for(g = 0; g < 6; g++) group[g] = seq(800)
+         for(i = 0; i < 80; i++) {
+             s = core group[i % 6] group[(i * 5) % 6] group[(i % 4) + 2] seq(1000)
+             f = sprintf("index_test/samples/s%02d.fasta", i)
+             print ">s" i > f
+             for(k = 1; k <= length(s); k += 80) print substr(s, k, 80) > f
+             close(f)
+         }
+     }'
+
+for codec in fixed vbyte; do
+    ./BreiZHMinimizer -d index_test/samples -o index_test/$codec -u index_test/tmp -S $codec -I -H > index_test/$codec.log 2>&1
+    ./check_index index_test/$codec.80c.manifest index_test/$codec.80c.index index_test/$codec.80c.mphf
+done
+
+cp index_test/samples/s[0-3]?.fasta index_test/small
+./BreiZHMinimizer -d index_test/small -o index_test/small -u index_test/tmp -S vbyte -I -H > index_test/small.log 2>&1
+./check_index index_test/small.40c.manifest index_test/small.40c.index index_test/small.40c.mphf
+
+rm -rf index_test
@@ -0,0 +1,104 @@
+//
+// radix_par (sorting/radix_par) against std::sort + std::unique : uniform, duplicate heavy and
+// skewed keys, sizes around the number of keys a thread is given (min_per_thread) and several
+// thread counts, from the main thread and from a parallel region as the Step 1 workers do.
+//
+#include "sorting/radix_par/radix_par.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+static const uint64_t min_per_thread = 1 << 16; // as in radix_par.cpp
+
+static std::vector<uint64_t> keys(const int dist, const uint64_t n, std::mt19937_64& rng)
+{
+    std::vector<uint64_t> v( n );
+    for(uint64_t i = 0; i < n; i += 1)
+    {
+        switch( dist )
+        {
+            case 0 : v[i] = rng();                                           break; // uniform
+            case 1 : v[i] = rng() % 16;                                      break; // 16 distinct keys
+            case 2 : v[i] = 0xABCDEF0123456789ULL;                           break; // a single key
+            case 3 : v[i] = (rng() % 10 != 0) ? (rng() & 0xFFFF) : rng();    break; // 90 % in the first bucket
+            case 4 : v[i] = (rng() % 1000) << 40 | (rng() % 4);              break; // varying high bits, duplicates
+            case 5 : v[i] = rng() >> 44;                                     break; // small keys (20 bits)
+            case 6 : v[i] = i / 3;                                           break; // sorted, triplicates
+            default: v[i] = n - i;                                           break; // reverse sorted
+        }
+    }
+    return v;
+}
+
+static const char* dist_name[8] = { "uniform", "16 keys", "1 key", "skewed", "high bits", "small", "sorted", "reverse" };
+
+static bool check(const int dist, const uint64_t n, const int threads, std::mt19937_64& rng)
+{
+    std::vector<uint64_t> data     = keys(dist, n, rng);
+    std::vector<uint64_t> expected = data;
+    std::sort(expected.begin(), expected.end());
+    expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+
+    radix_par(data, threads);
+    if( data != expected )
+    {
+        printf("(EE) radix_par : %s keys, n = %lu, %d threads : %lu distinct keys instead of %lu%s\n",
+               dist_name[dist], n, threads, data.size(), expected.size(), (data.size() == expected.size()) ? " (different keys)" : "");
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::mt19937_64 rng( 0x5eed );
+
+    const uint64_t m = min_per_thread;
+    const std::vector<uint64_t> sizes   = { 0, 1, 2, 1000, m - 1, m, m + 1, 2 * m - 1, 2 * m, 2 * m + 1, 3 * m + 7, 4 * m, 8 * m + 1, (1 << 20) + 3 };
+    const std::vector<int>      threads = { 1, 2, 3, 4, 8 };
+
+    uint64_t n_runs = 0;
+    for(int dist = 0; dist < 8; dist += 1)
+        for(const uint64_t n : sizes)
+            for(const int t : threads)
+            {
+                if( check(dist, n, t, rng) == false )
+                    return EXIT_FAILURE;
+                n_runs += 1;
+            }
+
+    //
+    // Calls from the threads of a parallel region, with the nested parallelism of the caller
+    // (one thread per call) and with a second level enabled as Step 1 does : radix_par leaves
+    // the setting as it is
+    //
+    const int max_levels = omp_get_max_active_levels();
+    for(const int levels : { 1, 2 })
+    {
+        omp_set_max_active_levels( levels );
+        bool nested_ok = true;
+#pragma omp parallel num_threads(2) reduction(&&:nested_ok)
+        {
+            std::mt19937_64 local( 0x5eed + omp_get_thread_num() );
+            nested_ok = check(3, 4 * m + 1, 2, local) && check(0, 2 * m, 3, local);
+        }
+        if( nested_ok == false )
+            return EXIT_FAILURE;
+        if( omp_get_max_active_levels() != levels )
+        {
+            printf("(EE) radix_par : max active levels %d after the calls, %d before\n", omp_get_max_active_levels(), levels);
+            return EXIT_FAILURE;
+        }
+        n_runs += 4;
+    }
+    omp_set_max_active_levels( max_levels );
+
+    printf("radix_par : %lu sorts OK\n", n_runs);
+    return EXIT_SUCCESS;
+}
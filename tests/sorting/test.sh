@@ -0,0 +1,27 @@
+#!/bin/bash
+#
+# Parallel radix sort (radix_par) against std::sort + std::unique, to run from the build
+# directory (as the merger tests) once the library is built :
+#
+#   ../tests/sorting/test.sh
+#
+set -e
+TESTS=../tests/sorting
+
+#
+# The checker is compiled as the library it links against : the options of the build are
+# read back from its CMakeCache.txt
+#
+option() { grep -q "^$1:BOOL=ON" CMakeCache.txt; }
+CXX=$(sed -n 's/^CMAKE_CXX_COMPILER:FILEPATH=//p' CMakeCache.txt)
+FLAGS="-std=c++17 -O2 -fopenmp -I../src"
+LIBS="./libBreiZHMinimizerLib.a -lz -lbz2"
+if option BUILD_LINUX_INTEL || option BUILD_MACOS_INTEL; then FLAGS="$FLAGS -march=native"; fi
+if option BUILD_LINUX_ARM   || option BUILD_MACOS_ARM;   then FLAGS="$FLAGS -mcpu=native";  fi
+if option ENABLE_IO_URING && (option BUILD_LINUX_INTEL || option BUILD_LINUX_ARM); then FLAGS="$FLAGS -D_IO_URING_"; fi
+if option ENABLE_LTO; then FLAGS="$FLAGS -flto"; fi
+if grep -q "^TBB_DIR:PATH=/" CMakeCache.txt; then LIBS="$LIBS -ltbb"; fi
+
+${CXX:-g++} $FLAGS $TESTS/check_radix_par.cpp -o check_radix_par $LIBS
+
+./check_radix_par